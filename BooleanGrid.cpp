@@ -2,13 +2,18 @@
 
 
 #include "BooleanGrid.h"
+#include "BuildingStats.h"
+#include "BuildingMeshPool.h"
 #include "BuildingEnums.h"
-#include "DynamicCube.h"
+#include "DynamicBox.h"
 #include "GeometryScript/MeshQueryFunctions.h"
 #include "GeometryScript/MeshBooleanFunctions.h"
 #include "GeometryScript/MeshModelingFunctions.h"
 #include "GeometryScript/MeshNormalsFunctions.h"
 #include "GeometryScript/MeshRepairFunctions.h"
+#include "BuildingRandom.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
 
 BooleanGrid::BooleanGrid()
 {
@@ -119,6 +124,27 @@ TTuple<TRange<float>, TRange<float>> BooleanGrid::GetBooleanSizeRange()
 
 
 void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperation BoolMode)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BooleanGrid::ApplyBooleans);
+	FBox MeshBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(Mesh);
+	TArray<FBox> Boxes = GetBooleanBoxes(MeshBounds, BoolMode);
+	if (Boxes.IsEmpty()) {
+		return;
+	}
+
+	// Windows cut into a panel are rectangles through a box, no need for a mesh boolean
+	if (Options->CutMode == EBuildingCutMode::Analytic && BoolMode == EGeometryScriptBooleanOperation::Subtract) {
+		if (ApplyAnalyticCutouts(Mesh, Boxes)) {
+			INC_DWORD_STAT_BY(STAT_BuildingAnalyticCutouts, Boxes.Num());
+			return;
+		}
+		UE_LOG(LogBuildingGeneration, Verbose, TEXT("Booleans - Analytic cut-outs not possible for this mesh, using a mesh boolean"));
+	}
+
+	ApplyMeshBooleans(Mesh, Boxes, BoolMode, MeshPool);
+}
+
+TArray<FBox> BooleanGrid::GetBooleanBoxes(const FBox& MeshBounds, EGeometryScriptBooleanOperation BoolMode)
 {
 	/*
 	* 1.) We want to evenly space the booleans across rows if there is a boolean limit 
@@ -136,9 +162,10 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 	* - allow mesh to be penetrated from any side.
 	* - in the event the mesh size exceeds the size of the parent mesh, just limit it so at least 1 row is generated
 	*/
-	FRandomStream RandomStream = FRandomStream(Options->RandomSeed);
+	// each window and row draws from its own element, a window's size never depends on how many windows came before it
+	const FBuildingRandom Random = FBuildingRandom(Options->RandomSeed).Stage(EBuildingRandomStage::WindowLayout);
 
-	FBox Box = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(Mesh);
+	const FBox& Box = MeshBounds;
 	// TODO from Box we can determine the center coordinate of the mesh in each axis.
 	FVector MeshSize = Box.GetSize();
 	FVector MeshCenter = Box.GetCenter();
@@ -180,14 +207,11 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 	float RowsTotalHeightHalf = RowsTotalHeight * 0.5;
 	int32 MaxRowBooleans = Options->bSpecifyMaxBooleansPerRow ? Options->MaxBooleansPerRowOrColumn : BooleanGrid::MAX_ROW_BOOLEANS;
 
-	UE_LOG(LogTemp, Warning, TEXT("Booleans - MeshSize: %s, MeshCenter: %s, NumRows: %i, MaxCols: %i, WidthIdx: %i, HeightIdx: %i"), *(MeshSize.ToString()), *(MeshCenter.ToString()), NumRows, MaxRowBooleans, WidthIdx, HeightIdx);
+	UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Booleans - MeshSize: %s, MeshCenter: %s, NumRows: %i, MaxCols: %i, WidthIdx: %i, HeightIdx: %i"), *(MeshSize.ToString()), *(MeshCenter.ToString()), NumRows, MaxRowBooleans, WidthIdx, HeightIdx);
 
-	FTransform DefaultTransform;
-	FGeometryScriptMeshBooleanOptions BooleanOptions;
-	BooleanOptions.bFillHoles = true;
-	BooleanOptions.bSimplifyOutput = true;
-
-	UDynamicMesh* BoolMesh = NewObject<UDynamicMesh>();
+	// the booleans are laid out relative to the bottom of the mesh
+	FVector ToolOrigin = MeshCenter + (FVector::DownVector * MeshHeight * 0.5);
+	TArray<FBox> Boxes;
 
 	// keep track of space between booleans for this row
 	TArray<float> HorizontalSpacings;
@@ -196,13 +220,15 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 	for (int Row = 0; Row < NumRows; Row++) {
 
 		float UsedWidth = 0.f;
+		const FBuildingRandom RowRandom = Random.Element(Row);
 		TArray<TTuple<FVector, FVector>> RowBooleans; // holds location, size vectors
 		for (int Col = 0; Col < MaxRowBooleans; Col++) { // Upper limit to avoid while loop and keep some sanity.
 			
 			// calculate boolean width and height
-			float Width = FMath::Min(RandomStream.FRandRange(WidthRange.GetLowerBoundValue(), WidthRange.GetUpperBoundValue()), MaxTotalWidth);
-			float Height = FMath::Min(RandomStream.FRandRange(HeightRange.GetLowerBoundValue(), HeightRange.GetUpperBoundValue()), MaxTotalHeight);
-			float HSpacing = FMath::Min(RandomStream.FRandRange(Options->HorizontalSpacing, Options->HorizontalSpacing + Options->HorizontalSpacingVariance), MaxTotalHeight);
+			const FBuildingRandom WindowRandom = RowRandom.Element(Col);
+			float Width = FMath::Min(WindowRandom.FRandRange(WidthRange.GetLowerBoundValue(), WidthRange.GetUpperBoundValue(), 0), MaxTotalWidth);
+			float Height = FMath::Min(WindowRandom.FRandRange(HeightRange.GetLowerBoundValue(), HeightRange.GetUpperBoundValue(), 1), MaxTotalHeight);
+			float HSpacing = FMath::Min(WindowRandom.FRandRange(Options->HorizontalSpacing, Options->HorizontalSpacing + Options->HorizontalSpacingVariance, 2), MaxTotalHeight);
 
 			FVector Location;
 			FVector Size;
@@ -231,7 +257,7 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 				// Add a spacer for the next item that will be added
 				UsedWidth += (Width + HSpacing);
 				HorizontalSpacings.Add(HSpacing);
-				UE_LOG(LogTemp, Warning, TEXT("Booleans[%i][%i] -  UsedWidth: %f, MaxTotalWidth: %f Size: %s, Location: %s"), Row, Col, UsedWidth, MaxTotalWidth, *(Size.ToString()), *(Location.ToString()));
+				UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Booleans[%i][%i] -  UsedWidth: %f, MaxTotalWidth: %f Size: %s, Location: %s"), Row, Col, UsedWidth, MaxTotalWidth, *(Size.ToString()), *(Location.ToString()));
 			}
 			else {
 				break;
@@ -239,7 +265,7 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 		}
 	
 		//float RowHRandOffset = (MaxTotalWidth - UsedWidth) * 0.5;
-		//float RowHCenter = RandomStream.FRandRange(-RowHRandOffset, RowHRandOffset);
+		//float RowHCenter = RowRandom.FRandRange(-RowHRandOffset, RowHRandOffset);
 		// no idea why its exactly (Options->HorizontalSpacing * 0.5) ??? to make it align?
 		float UsedWidthHalf = UsedWidth * 0.5;
 		float RowHAdjust = MeshCenter[WidthIdx] - (UsedWidthHalf - (Options->HorizontalSpacing * 0.5));
@@ -254,7 +280,7 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 			break;
 		case EBuildingHAlignmentChoices::Random:
 			// calculate a random position for the row horizontally, within the allowable bounds
-			RowHAdjust += RandomStream.FRandRange(-RemainingSafeHSpacePerSide, RemainingSafeHSpacePerSide);
+			RowHAdjust += RowRandom.FRandRange(-RemainingSafeHSpacePerSide, RemainingSafeHSpacePerSide, 0);
 		case EBuildingHAlignmentChoices::Center:
 		default:
 			break;
@@ -268,17 +294,15 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 		float RowVMiddle = FirstRowHeightOnCenter - (DistBetweenRows * Row);
 		RowVMiddle += MeshCenter[HeightIdx]; // adjust for the offset of the mesh (0 could be vertical center, or -500 could be)
 
-		UE_LOG(LogTemp, Warning, TEXT("Booleans[%i] - UsedWidth: %f, RowHAdjust: %f, HorizontalSpacing: %f"), Row, UsedWidth, RowHAdjust, Options->HorizontalSpacing);
-
-		UDynamicCube* Cube = NewObject<UDynamicCube>();
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Booleans[%i] - UsedWidth: %f, RowHAdjust: %f, HorizontalSpacing: %f"), Row, UsedWidth, RowHAdjust, Options->HorizontalSpacing);
 
 		// debug
 		/*
-		Cube->Reset();
-		Cube->SetTranslation(FVector(0.f, 0.f, MeshCenter.Z));
-		Cube->SetSize(FVector(BoolDepth, UsedWidth, MaxTotalHeight));
-		Cube->SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
-		Cube->GenerateMesh(Mesh);
+		Cube.Reset();
+		Cube.SetTranslation(FVector(0.f, 0.f, MeshCenter.Z));
+		Cube.SetSize(FVector(BoolDepth, UsedWidth, MaxTotalHeight));
+		Cube.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
+		Cube.GenerateMesh(Mesh);
 		*/
 
 		// perform booleans for the current row, row boolean sizes and transorm info is stored in `RowBooleans`
@@ -288,14 +312,9 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 			Location[WidthIdx] += RowHAdjust;
 			Location[HeightIdx] += RowVMiddle;
 
-			// append the boolean as a cube to the "BoolMesh"
-			Cube->SetSize(Size);
-			Cube->SetTranslation(Location);
-			Cube->SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
-			// generate the mesh on "BoolMesh"
-			Cube->GenerateMesh(BoolMesh);
+			// the boolean is a box centered on its location
+			Boxes.Add(FBox::BuildAABB(ToolOrigin + Location, Size * 0.5));
 
-			//UE_LOG(LogTemp, Warning, TEXT("Booleans[%i] Performing Boolean - Size: %s, Location: %s, RowMiddle: %f"), Row, *(Size.ToString()), *(Location.ToString()), RowVMiddle);
 			/*
 			auto RectOptions = FGeometryScriptPrimitiveOptions();
 			// create a rectangle for our boolean
@@ -323,21 +342,440 @@ void BooleanGrid::ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperat
 	}
 
 
-	// finaly perform booleans... it's most efficient to apply the boolean mesh all at once
-	
-	FVector ToolOrigin = MeshCenter + (FVector::DownVector * MeshHeight * 0.5);
+	return Boxes;
+}
+
+void BooleanGrid::ApplyMeshBooleans(UDynamicMesh* Mesh, const TArray<FBox>& Boxes, EGeometryScriptBooleanOperation BoolMode, FBuildingMeshPool* MeshPool)
+{
+	FGeometryScriptMeshBooleanOptions BooleanOptions;
+	BooleanOptions.bFillHoles = true;
+	BooleanOptions.bSimplifyOutput = true;
+
+	// the tool boxes are collected in a plain mesh and moved into `BoolMesh` once, it's most efficient to apply the 
+	// boolean mesh all at once
+	UE::Geometry::FDynamicMesh3 ToolMesh;
+	FDynamicBox Cube;
+	Cube.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
+	for (const FBox& Box : Boxes) {
+		Cube.SetSize(Box.GetSize());
+		Cube.SetTranslation(Box.GetCenter());
+		Cube.GenerateMesh(ToolMesh);
+	}
+
+	FScopedBuildingMesh BoolMesh(MeshPool);
+	BoolMesh.Get()->SetMesh(MoveTemp(ToolMesh));
 
 	UGeometryScriptLibrary_MeshBooleanFunctions::ApplyMeshBoolean(
 		Mesh,              // target mesh
-		DefaultTransform,  // target mesh transform
-		BoolMesh,          // tool mesh
-		FTransform(ToolOrigin), // location of the tool mesh
+		FTransform(),      // target mesh transform
+		BoolMesh.Get(),    // tool mesh
+		FTransform(),      // the boxes are already in the space of the target mesh
 		BoolMode,       // subtract, intersect, union
 		BooleanOptions  // fill-holes, simplify, etc
 	);
+	// one boolean however many windows it cuts
+	INC_DWORD_STAT(STAT_BuildingMeshBooleans);
+}
+
+// ======================== ANALYTIC CUT-OUTS ========================
+
+// The uv layout, normal and material of one axis aligned face of a box, taken from an existing mesh so faces we 
+// rebuild get exactly the attributes a mesh boolean would have kept.
+struct FAxisFaceAttributes
+{
+	int32 AxisS = 1;
+	int32 AxisT = 2;
+	FVector2d ST0 = FVector2d::Zero();
+	FVector2d UV0 = FVector2d::Zero();
+	FVector2d UVPerS = FVector2d::Zero();
+	FVector2d UVPerT = FVector2d::Zero();
+	int32 MaterialID = 0;
+
+	FVector2f GetUV(const FVector3d& Position) const
+	{
+		const double DS = Position[AxisS] - ST0.X;
+		const double DT = Position[AxisT] - ST0.Y;
+		return FVector2f(UV0 + UVPerS * DS + UVPerT * DT);
+	}
 
+	// Find a triangle of `Mesh` facing `Normal` and solve the (affine) uv mapping of its plane
+	static FAxisFaceAttributes FromMesh(const UE::Geometry::FDynamicMesh3& Mesh, const FVector3d& Normal)
+	{
+		using namespace UE::Geometry;
+		FAxisFaceAttributes Face;
+		const int32 Axis = FMath::Abs(Normal.X) > 0.5 ? 0 : (FMath::Abs(Normal.Y) > 0.5 ? 1 : 2);
+		Face.AxisS = (Axis + 1) % 3;
+		Face.AxisT = (Axis + 2) % 3;
+
+		const FDynamicMeshUVOverlay* UVs = Mesh.HasAttributes() ? Mesh.Attributes()->PrimaryUV() : nullptr;
+		const FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.HasAttributes() ? Mesh.Attributes()->GetMaterialID() : nullptr;
+		for (int32 TriangleID : Mesh.TriangleIndicesItr()) {
+			if (Mesh.GetTriNormal(TriangleID).Dot(Normal) < 0.99) {
+				continue;
+			}
+			if (MaterialIDs != nullptr) {
+				Face.MaterialID = MaterialIDs->GetValue(TriangleID);
+			}
+			if (UVs == nullptr || !UVs->IsSetTriangle(TriangleID)) {
+				break;
+			}
+
+			FVector3d A, B, C;
+			Mesh.GetTriVertices(TriangleID, A, B, C);
+			const FIndex3i Elements = UVs->GetTriangle(TriangleID);
+			const FVector2d UVA = FVector2d(UVs->GetElement(Elements.A));
+			const FVector2d UVB = FVector2d(UVs->GetElement(Elements.B));
+			const FVector2d UVC = FVector2d(UVs->GetElement(Elements.C));
+
+			const double DS1 = B[Face.AxisS] - A[Face.AxisS];
+			const double DT1 = B[Face.AxisT] - A[Face.AxisT];
+			const double DS2 = C[Face.AxisS] - A[Face.AxisS];
+			const double DT2 = C[Face.AxisT] - A[Face.AxisT];
+			const double Det = DS1 * DT2 - DS2 * DT1;
+			if (FMath::Abs(Det) < 1e-12) {
+				continue;
+			}
+			const FVector2d DUV1 = UVB - UVA;
+			const FVector2d DUV2 = UVC - UVA;
+			Face.ST0 = FVector2d(A[Face.AxisS], A[Face.AxisT]);
+			Face.UV0 = UVA;
+			Face.UVPerS = (DUV1 * DT2 - DUV2 * DT1) / Det;
+			Face.UVPerT = (DUV2 * DS1 - DUV1 * DS2) / Det;
+			break;
+		}
+		return Face;
+	}
+};
 
+// Writes the quads of the cut slab into a new mesh. Vertices live on a grid (X levels, Y lines, Z lines) and are
+// shared between faces, so the result is closed without T-junctions.
+struct FCutoutMeshWriter
+{
+	UE::Geometry::FDynamicMesh3& Mesh;
+	const TArray<double>& Xs;
+	const TArray<double>& Ys;
+	const TArray<double>& Zs;
+	TMap<FIntVector, int32> Vertices;
+	bool bFailed = false;
+
+	// the face currently being written, every face gets its own polygroup and overlay elements
+	FVector3f FaceNormal = FVector3f::UnitX();
+	FAxisFaceAttributes FaceAttributes;
+	int32 FaceGroup = 0;
+	int32 FaceNormalElement = -1;
+	TMap<int32, int32> FaceUVElements;
+	TMap<int32, int32> FaceNormalElements;
+
+	FCutoutMeshWriter(UE::Geometry::FDynamicMesh3& InMesh, const TArray<double>& InXs, const TArray<double>& InYs, const TArray<double>& InZs)
+		: Mesh(InMesh), Xs(InXs), Ys(InYs), Zs(InZs)
+	{}
+
+	int32 GetVertex(const FIntVector& Grid)
+	{
+		if (const int32* Existing = Vertices.Find(Grid)) {
+			return *Existing;
+		}
+		const int32 VertexID = Mesh.AppendVertex(FVector3d(Xs[Grid.X], Ys[Grid.Y], Zs[Grid.Z]));
+		Vertices.Add(Grid, VertexID);
+		return VertexID;
+	}
 
+	void BeginFace(const FVector3d& Normal, const FAxisFaceAttributes& Attributes)
+	{
+		FaceNormal = FVector3f(Normal);
+		FaceAttributes = Attributes;
+		FaceGroup = Mesh.AllocateTriangleGroup();
+		FaceUVElements.Reset();
+		FaceNormalElements.Reset();
+	}
+
+	int32 GetUVElement(int32 VertexID)
+	{
+		if (const int32* Existing = FaceUVElements.Find(VertexID)) {
+			return *Existing;
+		}
+		const int32 ElementID = Mesh.Attributes()->PrimaryUV()->AppendElement(FaceAttributes.GetUV(Mesh.GetVertex(VertexID)));
+		FaceUVElements.Add(VertexID, ElementID);
+		return ElementID;
+	}
+
+	int32 GetNormalElement(int32 VertexID)
+	{
+		if (const int32* Existing = FaceNormalElements.Find(VertexID)) {
+			return *Existing;
+		}
+		const int32 ElementID = Mesh.Attributes()->PrimaryNormals()->AppendElement(FaceNormal);
+		FaceNormalElements.Add(VertexID, ElementID);
+		return ElementID;
+	}
+
+	void AddTriangle(int32 A, int32 B, int32 C)
+	{
+		using namespace UE::Geometry;
+		const int32 TriangleID = Mesh.AppendTriangle(A, B, C, FaceGroup);
+		if (TriangleID < 0) {
+			bFailed = true; // non-manifold, the caller falls back to a mesh boolean
+			return;
+		}
+		Mesh.Attributes()->PrimaryUV()->SetTriangle(TriangleID, FIndex3i(GetUVElement(A), GetUVElement(B), GetUVElement(C)));
+		Mesh.Attributes()->PrimaryNormals()->SetTriangle(TriangleID, FIndex3i(GetNormalElement(A), GetNormalElement(B), GetNormalElement(C)));
+		Mesh.Attributes()->GetMaterialID()->SetValue(TriangleID, FaceAttributes.MaterialID);
+	}
+
+	// Corners in order around the quad, the winding is picked so the quad faces the current face normal
+	void AddQuad(const FIntVector& C0, const FIntVector& C1, const FIntVector& C2, const FIntVector& C3)
+	{
+		const int32 V0 = GetVertex(C0);
+		const int32 V1 = GetVertex(C1);
+		const int32 V2 = GetVertex(C2);
+		const int32 V3 = GetVertex(C3);
+		const FVector3d P0 = Mesh.GetVertex(V0);
+		const FVector3d Winding = (Mesh.GetVertex(V1) - P0).Cross(Mesh.GetVertex(V2) - P0);
+		if (Winding.Dot(FVector3d(FaceNormal)) >= 0.0) {
+			AddTriangle(V0, V1, V2);
+			AddTriangle(V0, V2, V3);
+		}
+		else {
+			AddTriangle(V0, V2, V1);
+			AddTriangle(V0, V3, V2);
+		}
+	}
+};
+
+// Sort the coordinates and merge the ones within Tolerance of the previous one
+static void FinishGridCoordinates(TArray<double>& Coordinates, double Tolerance)
+{
+	Coordinates.Sort();
+	TArray<double> Unique;
+	for (double Value : Coordinates) {
+		if (Unique.IsEmpty() || Value - Unique.Last() > Tolerance) {
+			Unique.Add(Value);
+		}
+	}
+	Coordinates = MoveTemp(Unique);
+}
+
+static int32 GetGridIndex(const TArray<double>& Coordinates, double Value)
+{
+	int32 Best = 0;
+	for (int32 Index = 1; Index < Coordinates.Num(); Index++) {
+		if (FMath::Abs(Coordinates[Index] - Value) < FMath::Abs(Coordinates[Best] - Value)) {
+			Best = Index;
+		}
+	}
+	return Best;
+}
+
+bool BooleanGrid::ApplyAnalyticCutouts(UDynamicMesh* Mesh, const TArray<FBox>& Boxes)
+{
+	using namespace UE::Geometry;
+	const double Tolerance = 0.001;
+
+	struct FCutout
+	{
+		FBox Box;
+		int32 Y0, Y1, Z0, Z1; // grid lines of the hole
+		int32 XBottom;        // grid level of the bottom of the pocket (or the back of the slab)
+		bool bThrough;
+	};
+
+	bool bIsBox = false;
+	FBox Slab = FBox(ForceInit);
+	FAxisFaceAttributes SlabFaces[6];
+	Mesh->ProcessMesh([&](const FDynamicMesh3& ReadMesh)
+	{
+		// the mesh must be a plain axis aligned box, every vertex on a corner of its bounds
+		if (ReadMesh.TriangleCount() != 12) {
+			return;
+		}
+		Slab = FBox(ReadMesh.GetBounds(true));
+		for (int32 VertexID : ReadMesh.VertexIndicesItr()) {
+			const FVector3d Position = ReadMesh.GetVertex(VertexID);
+			for (int32 Axis = 0; Axis < 3; Axis++) {
+				if (FMath::Abs(Position[Axis] - Slab.Min[Axis]) > Tolerance && FMath::Abs(Position[Axis] - Slab.Max[Axis]) > Tolerance) {
+					return;
+				}
+			}
+		}
+		for (int32 Axis = 0; Axis < 3; Axis++) {
+			FVector3d Normal = FVector3d::Zero();
+			Normal[Axis] = -1.0;
+			SlabFaces[Axis * 2] = FAxisFaceAttributes::FromMesh(ReadMesh, Normal);
+			Normal[Axis] = 1.0;
+			SlabFaces[Axis * 2 + 1] = FAxisFaceAttributes::FromMesh(ReadMesh, Normal);
+		}
+		bIsBox = true;
+	});
+
+	if (!bIsBox) {
+		return false;
+	}
+
+	// ================ GRID ===================
+	// every hole edge becomes a grid line on the Y/Z faces, every pocket depth an X level
+	TArray<double> Xs = { Slab.Min.X, Slab.Max.X };
+	TArray<double> Ys = { Slab.Min.Y, Slab.Max.Y };
+	TArray<double> Zs = { Slab.Min.Z, Slab.Max.Z };
+	for (const FBox& Box : Boxes) {
+		// the box must start outside the X+ face and stay inside the face in Y and Z
+		if (Box.Max.X < Slab.Max.X - Tolerance || Box.Min.X >= Slab.Max.X - Tolerance
+			|| Box.Min.Y <= Slab.Min.Y + Tolerance || Box.Max.Y >= Slab.Max.Y - Tolerance
+			|| Box.Min.Z <= Slab.Min.Z + Tolerance || Box.Max.Z >= Slab.Max.Z - Tolerance) {
+			return false;
+		}
+		if (Box.Min.X > Slab.Min.X + Tolerance) {
+			Xs.Add(Box.Min.X);
+		}
+		Ys.Add(Box.Min.Y);
+		Ys.Add(Box.Max.Y);
+		Zs.Add(Box.Min.Z);
+		Zs.Add(Box.Max.Z);
+	}
+	FinishGridCoordinates(Xs, Tolerance);
+	FinishGridCoordinates(Ys, Tolerance);
+	FinishGridCoordinates(Zs, Tolerance);
+
+	const int32 XBack = 0;
+	const int32 XFront = Xs.Num() - 1;
+	const int32 NumCellsY = Ys.Num() - 1;
+	const int32 NumCellsZ = Zs.Num() - 1;
+
+	// which cut-out each face cell belongs to, overlapping cut-outs aren't supported
+	TArray<int32> CellCutout;
+	CellCutout.Init(INDEX_NONE, NumCellsY * NumCellsZ);
+	TArray<FCutout> Cutouts;
+	for (const FBox& Box : Boxes) {
+		FCutout Cutout;
+		Cutout.Box = Box;
+		Cutout.Y0 = GetGridIndex(Ys, Box.Min.Y);
+		Cutout.Y1 = GetGridIndex(Ys, Box.Max.Y);
+		Cutout.Z0 = GetGridIndex(Zs, Box.Min.Z);
+		Cutout.Z1 = GetGridIndex(Zs, Box.Max.Z);
+		Cutout.bThrough = Box.Min.X <= Slab.Min.X + Tolerance;
+		Cutout.XBottom = Cutout.bThrough ? XBack : GetGridIndex(Xs, Box.Min.X);
+		if (Cutout.Y0 >= Cutout.Y1 || Cutout.Z0 >= Cutout.Z1) {
+			continue; // zero sized
+		}
+
+		const int32 CutoutIndex = Cutouts.Add(Cutout);
+		for (int32 Y = Cutout.Y0; Y < Cutout.Y1; Y++) {
+			for (int32 Z = Cutout.Z0; Z < Cutout.Z1; Z++) {
+				int32& Cell = CellCutout[Y * NumCellsZ + Z];
+				if (Cell != INDEX_NONE) {
+					return false;
+				}
+				Cell = CutoutIndex;
+			}
+		}
+	}
+
+	// cut-outs that touch would leave a zero thickness wall between them
+	auto IsOtherCutout = [&](int32 Y, int32 Z, int32 CutoutIndex) {
+		if (Y < 0 || Y >= NumCellsY || Z < 0 || Z >= NumCellsZ) {
+			return false;
+		}
+		const int32 Cell = CellCutout[Y * NumCellsZ + Z];
+		return Cell != INDEX_NONE && Cell != CutoutIndex;
+	};
+	for (int32 CutoutIndex = 0; CutoutIndex < Cutouts.Num(); CutoutIndex++) {
+		const FCutout& Cutout = Cutouts[CutoutIndex];
+		for (int32 Y = Cutout.Y0 - 1; Y <= Cutout.Y1; Y++) {
+			for (int32 Z = Cutout.Z0 - 1; Z <= Cutout.Z1; Z++) {
+				if (IsOtherCutout(Y, Z, CutoutIndex)) {
+					return false;
+				}
+			}
+		}
+	}
+
+	// ================ TRIANGULATE ===================
+	FDynamicMesh3 Result;
+	Result.EnableTriangleGroups();
+	Result.EnableAttributes();
+	Result.Attributes()->EnableMaterialID();
+	FCutoutMeshWriter Writer(Result, Xs, Ys, Zs);
+
+	// X+ face with the holes, X- face with the through holes
+	for (int32 Side = 0; Side < 2; Side++) {
+		const bool bFront = (Side == 0);
+		const int32 X = bFront ? XFront : XBack;
+		Writer.BeginFace(FVector3d(bFront ? 1.0 : -1.0, 0.0, 0.0), SlabFaces[bFront ? 1 : 0]);
+		for (int32 Y = 0; Y < NumCellsY; Y++) {
+			for (int32 Z = 0; Z < NumCellsZ; Z++) {
+				const int32 Cell = CellCutout[Y * NumCellsZ + Z];
+				if (Cell != INDEX_NONE && (bFront || Cutouts[Cell].bThrough)) {
+					continue;
+				}
+				Writer.AddQuad(FIntVector(X, Y, Z), FIntVector(X, Y + 1, Z), FIntVector(X, Y + 1, Z + 1), FIntVector(X, Y, Z + 1));
+			}
+		}
+	}
+
+	// Y-/Y+ sides and Z-/Z+ top and bottom, split at the grid lines so they share the vertices of the X faces
+	for (int32 Side = 0; Side < 2; Side++) {
+		const int32 Y = (Side == 0) ? 0 : NumCellsY;
+		Writer.BeginFace(FVector3d(0.0, Side == 0 ? -1.0 : 1.0, 0.0), SlabFaces[2 + Side]);
+		for (int32 Z = 0; Z < NumCellsZ; Z++) {
+			Writer.AddQuad(FIntVector(XBack, Y, Z), FIntVector(XFront, Y, Z), FIntVector(XFront, Y, Z + 1), FIntVector(XBack, Y, Z + 1));
+		}
+	}
+	for (int32 Side = 0; Side < 2; Side++) {
+		const int32 Z = (Side == 0) ? 0 : NumCellsZ;
+		Writer.BeginFace(FVector3d(0.0, 0.0, Side == 0 ? -1.0 : 1.0), SlabFaces[4 + Side]);
+		for (int32 Y = 0; Y < NumCellsY; Y++) {
+			Writer.AddQuad(FIntVector(XBack, Y, Z), FIntVector(XFront, Y, Z), FIntVector(XFront, Y + 1, Z), FIntVector(XBack, Y + 1, Z));
+		}
+	}
+
+	// Reveals and pocket bottoms. A mesh boolean keeps the attributes of the tool box for these faces, 
+	// so they are taken from the box the window would have been cut with.
+	FDynamicBox Cube;
+	Cube.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
+	for (const FCutout& Cutout : Cutouts) {
+		FDynamicMesh3 ToolMesh;
+		Cube.SetSize(Cutout.Box.GetSize());
+		Cube.SetTranslation(Cutout.Box.GetCenter());
+		Cube.GenerateMesh(ToolMesh);
+
+		// reveal faces point into the hole, the opposite of the tool box face they come from
+		Writer.BeginFace(FVector3d(0.0, 0.0, 1.0), FAxisFaceAttributes::FromMesh(ToolMesh, FVector3d(0.0, 0.0, -1.0)));
+		for (int32 Y = Cutout.Y0; Y < Cutout.Y1; Y++) {
+			Writer.AddQuad(FIntVector(Cutout.XBottom, Y, Cutout.Z0), FIntVector(XFront, Y, Cutout.Z0), FIntVector(XFront, Y + 1, Cutout.Z0), FIntVector(Cutout.XBottom, Y + 1, Cutout.Z0));
+		}
+		Writer.BeginFace(FVector3d(0.0, 0.0, -1.0), FAxisFaceAttributes::FromMesh(ToolMesh, FVector3d(0.0, 0.0, 1.0)));
+		for (int32 Y = Cutout.Y0; Y < Cutout.Y1; Y++) {
+			Writer.AddQuad(FIntVector(Cutout.XBottom, Y, Cutout.Z1), FIntVector(XFront, Y, Cutout.Z1), FIntVector(XFront, Y + 1, Cutout.Z1), FIntVector(Cutout.XBottom, Y + 1, Cutout.Z1));
+		}
+		Writer.BeginFace(FVector3d(0.0, 1.0, 0.0), FAxisFaceAttributes::FromMesh(ToolMesh, FVector3d(0.0, -1.0, 0.0)));
+		for (int32 Z = Cutout.Z0; Z < Cutout.Z1; Z++) {
+			Writer.AddQuad(FIntVector(Cutout.XBottom, Cutout.Y0, Z), FIntVector(XFront, Cutout.Y0, Z), FIntVector(XFront, Cutout.Y0, Z + 1), FIntVector(Cutout.XBottom, Cutout.Y0, Z + 1));
+		}
+		Writer.BeginFace(FVector3d(0.0, -1.0, 0.0), FAxisFaceAttributes::FromMesh(ToolMesh, FVector3d(0.0, 1.0, 0.0)));
+		for (int32 Z = Cutout.Z0; Z < Cutout.Z1; Z++) {
+			Writer.AddQuad(FIntVector(Cutout.XBottom, Cutout.Y1, Z), FIntVector(XFront, Cutout.Y1, Z), FIntVector(XFront, Cutout.Y1, Z + 1), FIntVector(Cutout.XBottom, Cutout.Y1, Z + 1));
+		}
+
+		if (!Cutout.bThrough) {
+			Writer.BeginFace(FVector3d(1.0, 0.0, 0.0), FAxisFaceAttributes::FromMesh(ToolMesh, FVector3d(-1.0, 0.0, 0.0)));
+			for (int32 Y = Cutout.Y0; Y < Cutout.Y1; Y++) {
+				for (int32 Z = Cutout.Z0; Z < Cutout.Z1; Z++) {
+					Writer.AddQuad(FIntVector(Cutout.XBottom, Y, Z), FIntVector(Cutout.XBottom, Y + 1, Z), FIntVector(Cutout.XBottom, Y + 1, Z + 1), FIntVector(Cutout.XBottom, Y, Z + 1));
+				}
+			}
+		}
+	}
+
+	if (Writer.bFailed) {
+		return false;
+	}
+
+	Mesh->SetMesh(MoveTemp(Result));
+	return true;
+}
+
+void BooleanGrid::SetMeshPool(FBuildingMeshPool* InMeshPool)
+{
+	MeshPool = InMeshPool;
 }
 
 BooleanGrid::~BooleanGrid()
@@ -57,6 +57,9 @@ struct PROCEDURALBUILDINGS_API FBooleanGridOptions
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Safe Edge", ToolTip = "Ensure all booleans are at least this far within the geometry"))
 	float SafeEdge = 50;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Cut Mode", ToolTip = "Analytic cuts subtracted rectangles straight out of box shaped meshes, which is much faster than a mesh boolean. Other meshes and modes always use a mesh boolean (the generator batches Box Boolean per box, here it is the same as Boolean)."))
+	EBuildingCutMode CutMode = EBuildingCutMode::Boolean;
 };
 
 
@@ -66,6 +69,8 @@ struct PROCEDURALBUILDINGS_API FBooleanGridOptions
  * HOWTO:
  *	- 
  */
+class FBuildingMeshPool;
+
 class PROCEDURALBUILDINGS_API BooleanGrid
 {
 
@@ -80,8 +85,24 @@ public:
 	int32 GetMaxRowsOrColumns(const FVector& MeshSize);
 	TTuple<TRange<float>, TRange<float>> GetBooleanSizeRange(); 
 	void ApplyBooleans(UDynamicMesh* Mesh, EGeometryScriptBooleanOperation BoolMode = EGeometryScriptBooleanOperation::Subtract);
+
+	// Lay out the boolean tool boxes (windows) for a mesh with the given bounds, in the mesh's space.
+	TArray<FBox> GetBooleanBoxes(const FBox& MeshBounds, EGeometryScriptBooleanOperation BoolMode = EGeometryScriptBooleanOperation::Subtract);
+
+	// Apply the boxes to `Mesh` with a single mesh boolean, the tool mesh is taken from `MeshPool` if there is one
+	static void ApplyMeshBooleans(UDynamicMesh* Mesh, const TArray<FBox>& Boxes, EGeometryScriptBooleanOperation BoolMode, FBuildingMeshPool* MeshPool = nullptr);
+
+	// Subtract the boxes from an axis aligned box mesh (a slab) without a mesh boolean.
+	// The slab face is triangulated with the boxes as rectangular holes and the reveals are emitted down to each box's depth (X-).
+	// Returns false and leaves the mesh untouched if the mesh is not a box, or the boxes don't cut the X+ face from the outside
+	// or overlap each other.
+	static bool ApplyAnalyticCutouts(UDynamicMesh* Mesh, const TArray<FBox>& Boxes);
+
+	// Take scratch meshes from `MeshPool` instead of allocating them, nullptr allocates
+	void SetMeshPool(FBuildingMeshPool* InMeshPool);
 	~BooleanGrid();
 
 private:
 	struct FBooleanGridOptions* Options;
+	FBuildingMeshPool* MeshPool = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,1292 @@
+#include "BuildingBenchmarks.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "BuildingRandom.h"
+#include "BooleanGrid.h"
+#include "DynamicBox.h"
+#include "UDynamicMesh.h"
+#include "MeshQueries.h"
+#include "UVUtilities.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "BuildingGenerator.h"
+#include "BuildingInstances.h"
+#include "BuildingStats.h"
+#include "PanelMeshCache.h"
+#include "LatticeMeshCache.h"
+#include "LatticeGrid.h"
+#include "GeometryScript/MeshBasicEditFunctions.h"
+#include "GeometryScript/MeshTransformFunctions.h"
+#include "GeometryScript/MeshUVFunctions.h"
+#include "Misc/FileHelper.h"
+#include "Misc/AutomationTest.h"
+#include "Algo/Find.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+static TAutoConsoleVariable<float> CVarBenchmarkThreshold(
+	TEXT("Building.Benchmark.Threshold"),
+	10.f,
+	TEXT("Percent a case of Building.Benchmark.Suite may be slower than its baseline before it is reported as a regression."),
+	ECVF_Default);
+
+static FAutoConsoleCommand RandomBenchmarkCommand(
+	TEXT("Building.Benchmark.Random"),
+	TEXT("Compare the throughput of FRandomStream and FBuildingRandom. Usage: Building.Benchmark.Random [NumValues]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumValues = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000000;
+		BuildingBenchmarks::RunRandomBenchmark(FMath::Max(NumValues, 1));
+	}));
+
+static FAutoConsoleCommand WindowBenchmarkCommand(
+	TEXT("Building.Benchmark.Windows"),
+	TEXT("Compare mesh boolean and analytic window cut-outs on a sample panel. Usage: Building.Benchmark.Windows [Iterations]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumIterations = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+		BuildingBenchmarks::RunWindowBenchmark(FMath::Max(NumIterations, 1));
+	}));
+
+static FAutoConsoleCommand BoxWindowBenchmarkCommand(
+	TEXT("Building.Benchmark.BoxWindows"),
+	TEXT("Compare a mesh boolean per panel (serial and concurrent) with one mesh boolean per box. Usage: Building.Benchmark.BoxWindows [Iterations]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumIterations = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20;
+		BuildingBenchmarks::RunBoxWindowBenchmark(FMath::Max(NumIterations, 1));
+	}));
+
+static FAutoConsoleCommand UVBenchmarkCommand(
+	TEXT("Building.Benchmark.UVs"),
+	TEXT("Compare per material id and batched box projection of uvs. Usage: Building.Benchmark.UVs [NumTriangles]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumTriangles = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000000;
+		BuildingBenchmarks::RunUVBenchmark(FMath::Max(NumTriangles, 12));
+	}));
+
+static FAutoConsoleCommand InstancingBenchmarkCommand(
+	TEXT("Building.Benchmark.Instancing"),
+	TEXT("Compare the memory of baked and instanced windows and lattice bars on a sample building. Usage: Building.Benchmark.Instancing [Seed]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Seed = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1234;
+		BuildingBenchmarks::RunInstancingBenchmark(Seed);
+	}));
+
+// iterations of the suite's perf tests, and the default of the console command
+static const int32 SUITE_TEST_ITERATIONS = 20;
+
+static FAutoConsoleCommand SuiteBenchmarkCommand(
+	TEXT("Building.Benchmark.Suite"),
+	TEXT("Time the hot components over parameter sweeps and compare with the baseline, 'save' stores this run as the baseline. Usage: Building.Benchmark.Suite [Iterations] [save]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumIterations = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : SUITE_TEST_ITERATIONS;
+		const bool bSaveBaseline = Args.Contains(TEXT("save"));
+		BuildingBenchmarks::RunSuite(FMath::Max(NumIterations, 1), bSaveBaseline);
+	}));
+
+static void LogRandomResult(const TCHAR* Name, int32 NumValues, double Seconds, double Checksum)
+{
+	const double NsPerValue = (Seconds * 1.0e9) / NumValues;
+	const double MillionsPerSecond = Seconds > 0.0 ? (NumValues / Seconds) / 1.0e6 : 0.0;
+	// the checksum keeps the compiler from discarding the draws, and shows both generators are uniform (~0.5)
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Random - %-28s %10.2f ms  %6.2f ns/value  %8.2f M values/s  (mean %.4f)"),
+		Name, Seconds * 1000.0, NsPerValue, MillionsPerSecond, Checksum / NumValues);
+}
+
+void BuildingBenchmarks::RunRandomBenchmark(int32 NumValues)
+{
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Random - %i values"), NumValues);
+	const int32 Seed = 1234;
+
+	// ============ FRandomStream (sequential) ============
+	{
+		FRandomStream Stream = FRandomStream(Seed);
+		double Sum = 0.0;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumValues; Index++) {
+			Sum += Stream.FRandRange(0.f, 1.f);
+		}
+		LogRandomResult(TEXT("FRandomStream"), NumValues, FPlatformTime::Seconds() - Start, Sum);
+	}
+
+	// ============ FBuildingRandom (element per value) ============
+	const FBuildingRandom Random = FBuildingRandom(Seed).Stage(EBuildingRandomStage::WindowLayout);
+	{
+		double Sum = 0.0;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumValues; Index++) {
+			Sum += Random.Element(Index).FRandRange(0.f, 1.f, 0);
+		}
+		LogRandomResult(TEXT("FBuildingRandom Element"), NumValues, FPlatformTime::Seconds() - Start, Sum);
+	}
+
+	// ============ FBuildingRandom (channels of one element, the window/lattice bar pattern) ============
+	{
+		double Sum = 0.0;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumValues; Index++) {
+			Sum += Random.FRandRange(0.f, 1.f, Index);
+		}
+		LogRandomResult(TEXT("FBuildingRandom Channel"), NumValues, FPlatformTime::Seconds() - Start, Sum);
+	}
+
+	// ============ FBuildingRandom (ParallelFor) ============
+	// not possible with FRandomStream, each value would depend on every value drawn before it
+	{
+		const int32 NumChunks = FMath::Max(FMath::Min(FPlatformMisc::NumberOfCoresIncludingHyperthreads() * 4, NumValues), 1);
+		const int32 ChunkSize = FMath::DivideAndRoundUp(NumValues, NumChunks);
+		TArray<double> ChunkSums;
+		ChunkSums.SetNumZeroed(NumChunks);
+
+		const double Start = FPlatformTime::Seconds();
+		ParallelFor(NumChunks, [&](int32 Chunk)
+		{
+			const int32 First = Chunk * ChunkSize;
+			const int32 Last = FMath::Min(First + ChunkSize, NumValues);
+			double Sum = 0.0;
+			for (int32 Index = First; Index < Last; Index++) {
+				Sum += Random.Element(Index).FRandRange(0.f, 1.f, 0);
+			}
+			ChunkSums[Chunk] = Sum;
+		});
+		const double Seconds = FPlatformTime::Seconds() - Start;
+
+		double Sum = 0.0;
+		for (double ChunkSum : ChunkSums) {
+			Sum += ChunkSum;
+		}
+		LogRandomResult(TEXT("FBuildingRandom ParallelFor"), NumValues, Seconds, Sum);
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Every value is a function of its key alone, drawing the same (seed, box, face, channel) keys forwards, backwards,
+// shuffled and concurrently must give the same values.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuildingRandomOrderTest, "ProceduralBuildings.Random.OrderIndependent",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBuildingRandomOrderTest::RunTest(const FString& Parameters)
+{
+	const int32 Seeds[] = { 1, 1234, -7 };
+	const int32 NumBoxes = 16;
+	const int32 NumFaces = 4;
+	const int32 NumChannels = 4;
+	const int32 NumKeys = UE_ARRAY_COUNT(Seeds) * NumBoxes * NumFaces * NumChannels;
+
+	// a key index is ((seed * NumBoxes + box) * NumFaces + face) * NumChannels + channel
+	auto Draw = [&](int32 KeyIndex)
+	{
+		const int32 Channel = KeyIndex % NumChannels;
+		const int32 Face = (KeyIndex / NumChannels) % NumFaces;
+		const int32 Box = (KeyIndex / (NumChannels * NumFaces)) % NumBoxes;
+		const int32 Seed = Seeds[KeyIndex / (NumChannels * NumFaces * NumBoxes)];
+		return FBuildingRandom(Seed).Stage(EBuildingRandomStage::PanelWindows).Element(Box).Element(Face).GetUInt(Channel);
+	};
+
+	TArray<uint32> Forward;
+	Forward.SetNumUninitialized(NumKeys);
+	for (int32 KeyIndex = 0; KeyIndex < NumKeys; KeyIndex++) {
+		Forward[KeyIndex] = Draw(KeyIndex);
+	}
+
+	TArray<uint32> Backward;
+	Backward.SetNumUninitialized(NumKeys);
+	for (int32 KeyIndex = NumKeys - 1; KeyIndex >= 0; KeyIndex--) {
+		Backward[KeyIndex] = Draw(KeyIndex);
+	}
+
+	TArray<int32> Order;
+	for (int32 KeyIndex = 0; KeyIndex < NumKeys; KeyIndex++) {
+		Order.Add(KeyIndex);
+	}
+	FRandomStream Shuffle = FRandomStream(42);
+	for (int32 Index = Order.Num() - 1; Index > 0; Index--) {
+		Order.Swap(Index, Shuffle.RandRange(0, Index));
+	}
+	TArray<uint32> Shuffled;
+	Shuffled.SetNumUninitialized(NumKeys);
+	for (const int32 KeyIndex : Order) {
+		// values drawn in between for other stages and channels must not shift this one
+		Draw((KeyIndex * 7 + 3) % NumKeys);
+		FBuildingRandom(KeyIndex).Stage(EBuildingRandomStage::WindowLayout).GetUInt(KeyIndex);
+		Shuffled[KeyIndex] = Draw(KeyIndex);
+	}
+
+	TArray<uint32> Concurrent;
+	Concurrent.SetNumUninitialized(NumKeys);
+	ParallelFor(NumKeys, [&](int32 KeyIndex)
+	{
+		Concurrent[KeyIndex] = Draw(Order[KeyIndex]);
+	});
+
+	int32 NumMismatches = 0;
+	for (int32 KeyIndex = 0; KeyIndex < NumKeys; KeyIndex++) {
+		const bool bMatches = Backward[KeyIndex] == Forward[KeyIndex] && Shuffled[KeyIndex] == Forward[KeyIndex] && Concurrent[KeyIndex] == Forward[Order[KeyIndex]];
+		NumMismatches += bMatches ? 0 : 1;
+	}
+	TestEqual(TEXT("Keys whose value depends on the draw order"), NumMismatches, 0);
+
+	// the element keys must actually separate boxes and faces
+	TSet<uint32> Unique = TSet<uint32>(Forward);
+	TestTrue(TEXT("Different keys draw different values"), Unique.Num() > NumKeys * 99 / 100);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
+
+// Cut the windows into a copy of `Slab` `NumIterations` times, returns the average milliseconds and the last result
+static double TimeWindowCuts(const UE::Geometry::FDynamicMesh3& Slab, FBooleanGridOptions Options, EBuildingCutMode CutMode, int32 NumIterations, UE::Geometry::FDynamicMesh3& OutResult)
+{
+	Options.CutMode = CutMode;
+	BooleanGrid Booleans = BooleanGrid(&Options);
+	UDynamicMesh* Mesh = NewObject<UDynamicMesh>();
+
+	double Seconds = 0.0;
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++) {
+		Mesh->SetMesh(Slab);
+		const double Start = FPlatformTime::Seconds();
+		Booleans.ApplyBooleans(Mesh, EGeometryScriptBooleanOperation::Subtract);
+		Seconds += FPlatformTime::Seconds() - Start;
+	}
+	Mesh->ProcessMesh([&](const UE::Geometry::FDynamicMesh3& ReadMesh) {
+		OutResult = ReadMesh;
+	});
+	return (Seconds * 1000.0) / NumIterations;
+}
+
+// The sample panel of the window benchmark and test: a two floor side panel, X is the depth of the panel. The front
+// and back faces get their own material ids so the test can tell which face a triangle came from.
+static UE::Geometry::FDynamicMesh3 MakeWindowSlab()
+{
+	using namespace UE::Geometry;
+	FDynamicBox Cube;
+	Cube.SetSize(FVector(20.f, 1000.f, 800.f));
+	Cube.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
+	FDynamicMesh3 Slab;
+	Cube.GenerateMesh(Slab);
+
+	FDynamicMeshMaterialAttribute* MaterialIDs = Slab.Attributes()->GetMaterialID();
+	for (int32 TriangleID : Slab.TriangleIndicesItr()) {
+		const FVector3d Normal = Slab.GetTriNormal(TriangleID);
+		MaterialIDs->SetValue(TriangleID, Normal.X > 0.5 ? 1 : (Normal.X < -0.5 ? 2 : 0));
+	}
+	return Slab;
+}
+
+static FBooleanGridOptions MakeWindowOptions()
+{
+	FBooleanGridOptions Options;
+	Options.RandomSeed = 1234;
+	Options.BooleanSizeMin = FVector2D(150.f, 200.f);
+	Options.BooleanSizeMax = FVector2D(250.f, 250.f);
+	Options.HorizontalSpacing = 50.f;
+	Options.VerticalSpacing = 150.f;
+	Options.SafeEdge = 50.f;
+	return Options;
+}
+
+// What a cut must preserve: the solid (volume, area, bounds) and, per material id, the surface area and uv bounds
+struct FWindowCutSummary
+{
+	FVector2d VolumeArea = FVector2d::Zero();
+	UE::Geometry::FAxisAlignedBox3d Bounds;
+	TMap<int32, double> MaterialAreas;
+	TMap<int32, FBox2D> MaterialUVBounds;
+
+	explicit FWindowCutSummary(const UE::Geometry::FDynamicMesh3& Mesh)
+	{
+		using namespace UE::Geometry;
+		VolumeArea = TMeshQueries<FDynamicMesh3>::GetVolumeArea(Mesh);
+		Bounds = Mesh.GetBounds(true);
+		const FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.HasAttributes() ? Mesh.Attributes()->GetMaterialID() : nullptr;
+		const FDynamicMeshUVOverlay* UVs = Mesh.HasAttributes() ? Mesh.Attributes()->PrimaryUV() : nullptr;
+		for (int32 TriangleID : Mesh.TriangleIndicesItr()) {
+			const int32 MaterialID = MaterialIDs != nullptr ? MaterialIDs->GetValue(TriangleID) : 0;
+			MaterialAreas.FindOrAdd(MaterialID, 0.0) += Mesh.GetTriArea(TriangleID);
+			if (UVs != nullptr && UVs->IsSetTriangle(TriangleID)) {
+				FBox2D& UVBounds = MaterialUVBounds.FindOrAdd(MaterialID, FBox2D(ForceInit));
+				const FIndex3i Elements = UVs->GetTriangle(TriangleID);
+				for (int32 Corner = 0; Corner < 3; Corner++) {
+					const FVector2f UV = UVs->GetElement(Elements[Corner]);
+					UVBounds += FVector2D(UV.X, UV.Y);
+				}
+			}
+		}
+	}
+};
+
+// Differences between a mesh boolean and an analytic cut of the same windows, empty if they match. The meshes aren't
+// triangulated the same, but they must enclose the same solid with the same materials and uv layout.
+static TArray<FString> CompareWindowCuts(const FWindowCutSummary& Boolean, const FWindowCutSummary& Analytic)
+{
+	const double Tolerance = 0.001; // 0.1%
+	const double UVTolerance = 0.001;
+	auto Matches = [Tolerance](double A, double B) { return FMath::Abs(A - B) <= FMath::Max(FMath::Abs(A), 1.0) * Tolerance; };
+
+	TArray<FString> Differences;
+	if (!Matches(Boolean.VolumeArea.X, Analytic.VolumeArea.X)) {
+		Differences.Add(FString::Printf(TEXT("volume %.1f / %.1f"), Boolean.VolumeArea.X, Analytic.VolumeArea.X));
+	}
+	if (!Matches(Boolean.VolumeArea.Y, Analytic.VolumeArea.Y)) {
+		Differences.Add(FString::Printf(TEXT("area %.1f / %.1f"), Boolean.VolumeArea.Y, Analytic.VolumeArea.Y));
+	}
+	if (!Boolean.Bounds.Min.Equals(Analytic.Bounds.Min, 0.01) || !Boolean.Bounds.Max.Equals(Analytic.Bounds.Max, 0.01)) {
+		Differences.Add(TEXT("bounds"));
+	}
+
+	TSet<int32> MaterialIDs;
+	for (const TPair<int32, double>& Area : Boolean.MaterialAreas) {
+		MaterialIDs.Add(Area.Key);
+	}
+	for (const TPair<int32, double>& Area : Analytic.MaterialAreas) {
+		MaterialIDs.Add(Area.Key);
+	}
+	for (const int32 MaterialID : MaterialIDs) {
+		const double BooleanArea = Boolean.MaterialAreas.FindRef(MaterialID);
+		const double AnalyticArea = Analytic.MaterialAreas.FindRef(MaterialID);
+		if (!Matches(BooleanArea, AnalyticArea)) {
+			Differences.Add(FString::Printf(TEXT("material %i area %.1f / %.1f"), MaterialID, BooleanArea, AnalyticArea));
+		}
+		const FBox2D* BooleanUVs = Boolean.MaterialUVBounds.Find(MaterialID);
+		const FBox2D* AnalyticUVs = Analytic.MaterialUVBounds.Find(MaterialID);
+		if ((BooleanUVs == nullptr) != (AnalyticUVs == nullptr)) {
+			Differences.Add(FString::Printf(TEXT("material %i uvs set on one mesh only"), MaterialID));
+		}
+		else if (BooleanUVs != nullptr && (!BooleanUVs->Min.Equals(AnalyticUVs->Min, UVTolerance) || !BooleanUVs->Max.Equals(AnalyticUVs->Max, UVTolerance))) {
+			Differences.Add(FString::Printf(TEXT("material %i uv bounds %s / %s"), MaterialID, *BooleanUVs->ToString(), *AnalyticUVs->ToString()));
+		}
+	}
+	return Differences;
+}
+
+static const TCHAR* WindowCaseNames[] = { TEXT("Through"), TEXT("Pocket") };
+static const float WindowCaseDepths[] = { 0.f, 15.f };
+
+void BuildingBenchmarks::RunWindowBenchmark(int32 NumIterations)
+{
+	using namespace UE::Geometry;
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Windows - %i iterations"), NumIterations);
+
+	const FDynamicMesh3 Slab = MakeWindowSlab();
+	FBooleanGridOptions Options = MakeWindowOptions();
+	for (int32 Case = 0; Case < 2; Case++) {
+		Options.Depth = WindowCaseDepths[Case];
+
+		FDynamicMesh3 BooleanResult;
+		FDynamicMesh3 AnalyticResult;
+		const double BooleanMs = TimeWindowCuts(Slab, Options, EBuildingCutMode::Boolean, NumIterations, BooleanResult);
+		const double AnalyticMs = TimeWindowCuts(Slab, Options, EBuildingCutMode::Analytic, NumIterations, AnalyticResult);
+		const TArray<FString> Differences = CompareWindowCuts(FWindowCutSummary(BooleanResult), FWindowCutSummary(AnalyticResult));
+
+		UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Windows - %-8s Boolean %8.3f ms (%i tris)  Analytic %8.3f ms (%i tris)  %.1fx faster  %s"),
+			WindowCaseNames[Case], BooleanMs, BooleanResult.TriangleCount(), AnalyticMs, AnalyticResult.TriangleCount(), AnalyticMs > 0.0 ? BooleanMs / AnalyticMs : 0.0,
+			Differences.Num() == 0 ? TEXT("PASS") : *FString::Printf(TEXT("FAIL (%s)"), *FString::Join(Differences, TEXT(", "))));
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuildingAnalyticWindowCutTest, "ProceduralBuildings.Windows.AnalyticMatchesBoolean",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBuildingAnalyticWindowCutTest::RunTest(const FString& Parameters)
+{
+	using namespace UE::Geometry;
+	const FDynamicMesh3 Slab = MakeWindowSlab();
+	FBooleanGridOptions Options = MakeWindowOptions();
+	for (int32 Case = 0; Case < 2; Case++) {
+		Options.Depth = WindowCaseDepths[Case];
+
+		FDynamicMesh3 BooleanResult;
+		FDynamicMesh3 AnalyticResult;
+		TimeWindowCuts(Slab, Options, EBuildingCutMode::Boolean, 1, BooleanResult);
+		TimeWindowCuts(Slab, Options, EBuildingCutMode::Analytic, 1, AnalyticResult);
+		for (const FString& Difference : CompareWindowCuts(FWindowCutSummary(BooleanResult), FWindowCutSummary(AnalyticResult))) {
+			AddError(FString::Printf(TEXT("%s windows: analytic cut differs from the mesh boolean, %s"), WindowCaseNames[Case], *Difference));
+		}
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
+
+// The four side panels of a box in panel space (as BuildSidePanel builds them) with their windows and placement on the box
+struct FBoxWindowSample
+{
+	TArray<UE::Geometry::FDynamicMesh3> Slabs;
+	TArray<FTransform> SlabToBox;
+	TArray<FBooleanGridOptions> Options;
+	TArray<UDynamicMesh*> PanelMeshes;
+};
+
+static FBoxWindowSample MakeBoxWindowSample(const FVector& BoxSize)
+{
+	FDynamicBuildingPanelOptions PanelOptions;
+	PanelOptions.bPanelNorth = true;
+	PanelOptions.bPanelEast = true;
+	PanelOptions.bPanelSouth = true;
+	PanelOptions.bPanelWest = true;
+
+	FBoxWindowSample Sample;
+	for (const FVector& Face : PanelOptions.GetSideVectors()) {
+		const FSizeAndTransform Panel = PanelOptions.GetPanelSizeAndTransform(Face, BoxSize);
+		FDynamicBox Cube;
+		Cube.SetSize(Panel.Size);
+		Cube.GenerateMesh(Sample.Slabs.AddDefaulted_GetRef());
+		Sample.SlabToBox.Add(Panel.Transform * PanelOptions.GetPanelBoxTransform(Face, BoxSize));
+
+		// pocket windows, every panel gets its own layout
+		FBooleanGridOptions& Options = Sample.Options.AddDefaulted_GetRef();
+		Options.RandomSeed = 1234 + Sample.Options.Num();
+		Options.CutMode = EBuildingCutMode::Boolean;
+		Options.Depth = 15.f;
+		Options.BooleanSizeMin = FVector2D(150.f, 200.f);
+		Options.BooleanSizeMax = FVector2D(250.f, 250.f);
+		Options.HorizontalSpacing = 50.f;
+		Options.VerticalSpacing = 150.f;
+		Options.SafeEdge = 50.f;
+
+		UDynamicMesh* PanelMesh = NewObject<UDynamicMesh>();
+		PanelMesh->AddToRoot();
+		Sample.PanelMeshes.Add(PanelMesh);
+	}
+	return Sample;
+}
+
+static void ReleaseBoxWindowSample(FBoxWindowSample& Sample)
+{
+	for (UDynamicMesh* PanelMesh : Sample.PanelMeshes) {
+		PanelMesh->RemoveFromRoot();
+	}
+	Sample.PanelMeshes.Reset();
+}
+
+// A mesh boolean per panel, then the cut panels are placed on the box (EBuildingCutMode::Boolean)
+static void CutBoxWindowsPerPanel(FBoxWindowSample& Sample, UDynamicMesh* OutMesh, bool bParallel)
+{
+	ParallelFor(Sample.Slabs.Num(), [&](int32 PanelIndex)
+	{
+		UDynamicMesh* PanelMesh = Sample.PanelMeshes[PanelIndex];
+		PanelMesh->SetMesh(Sample.Slabs[PanelIndex]);
+		BooleanGrid(&Sample.Options[PanelIndex]).ApplyBooleans(PanelMesh, EGeometryScriptBooleanOperation::Subtract);
+		UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(PanelMesh, Sample.SlabToBox[PanelIndex]);
+	}, bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	OutMesh->Reset();
+	for (UDynamicMesh* PanelMesh : Sample.PanelMeshes) {
+		UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(OutMesh, PanelMesh, FTransform::Identity);
+	}
+}
+
+// The panels are placed on the box uncut, then one mesh boolean cuts all their windows (EBuildingCutMode::BoxBoolean).
+// Returns the number of windows.
+static int32 CutBoxWindowsBatched(FBoxWindowSample& Sample, UDynamicMesh* OutMesh)
+{
+	OutMesh->Reset();
+	TArray<FBox> Windows;
+	for (int32 PanelIndex = 0; PanelIndex < Sample.Slabs.Num(); PanelIndex++) {
+		const FDynamicMesh3& Slab = Sample.Slabs[PanelIndex];
+		for (const FBox& Window : BooleanGrid(&Sample.Options[PanelIndex]).GetBooleanBoxes(FBox(Slab.GetBounds(true)))) {
+			Windows.Add(Window.TransformBy(Sample.SlabToBox[PanelIndex]));
+		}
+		UDynamicMesh* PanelMesh = Sample.PanelMeshes[PanelIndex];
+		PanelMesh->SetMesh(Slab);
+		UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(PanelMesh, Sample.SlabToBox[PanelIndex]);
+		UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(OutMesh, PanelMesh, FTransform::Identity);
+	}
+	BooleanGrid::ApplyMeshBooleans(OutMesh, Windows, EGeometryScriptBooleanOperation::Subtract);
+	return Windows.Num();
+}
+
+void BuildingBenchmarks::RunBoxWindowBenchmark(int32 NumIterations)
+{
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark BoxWindows - %i iterations, 4 panels per box"), NumIterations);
+
+	UDynamicMesh* Mesh = NewObject<UDynamicMesh>();
+	Mesh->AddToRoot();
+	for (const float BoxWidth : { 1000.f, 2000.f, 4000.f }) {
+		FBoxWindowSample Sample = MakeBoxWindowSample(FVector(BoxWidth, BoxWidth, 800.f));
+
+		const TCHAR* PathNames[] = { TEXT("PerPanel"), TEXT("Parallel"), TEXT("Batched") };
+		double Ms[3] = { 0.0, 0.0, 0.0 };
+		int32 NumTriangles[3] = { 0, 0, 0 };
+		int32 NumWindows = 0;
+		for (int32 Path = 0; Path < 3; Path++) {
+			double Seconds = 0.0;
+			for (int32 Iteration = 0; Iteration < NumIterations; Iteration++) {
+				const double Start = FPlatformTime::Seconds();
+				if (Path == 2) {
+					NumWindows = CutBoxWindowsBatched(Sample, Mesh);
+				}
+				else {
+					CutBoxWindowsPerPanel(Sample, Mesh, Path == 1);
+				}
+				Seconds += FPlatformTime::Seconds() - Start;
+			}
+			Ms[Path] = (Seconds * 1000.0) / NumIterations;
+			NumTriangles[Path] = Mesh->GetTriangleCount();
+		}
+		ReleaseBoxWindowSample(Sample);
+
+		UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark BoxWindows - %5icm %3i windows  %s %8.3f ms (%i tris)  %s %8.3f ms (%i tris, %.1fx)  %s %8.3f ms (%i tris, %.1fx)"),
+			FMath::RoundToInt(BoxWidth), NumWindows,
+			PathNames[0], Ms[0], NumTriangles[0],
+			PathNames[1], Ms[1], NumTriangles[1], Ms[1] > 0.0 ? Ms[0] / Ms[1] : 0.0,
+			PathNames[2], Ms[2], NumTriangles[2], Ms[2] > 0.0 ? Ms[0] / Ms[2] : 0.0);
+	}
+	Mesh->RemoveFromRoot();
+}
+
+// A "building" of boxes stacked into a grid, every box gets one of `NumMaterials` material ids
+static UE::Geometry::FDynamicMesh3 MakeUVSample(int32 NumTriangles, int32 NumMaterials)
+{
+	using namespace UE::Geometry;
+	FDynamicMesh3 Building;
+	FDynamicBox Cube;
+	Cube.SetSize(FVector(80.f, 80.f, 280.f));
+	const int32 NumBoxes = FMath::DivideAndRoundUp(NumTriangles, 12);
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumBoxes)));
+	for (int32 BoxIndex = 0; BoxIndex < NumBoxes; BoxIndex++) {
+		Cube.SetTranslation(FVector((BoxIndex % GridSize) * 100.f, 0.f, (BoxIndex / GridSize) * 300.f));
+		Cube.GenerateMesh(Building);
+	}
+	FDynamicMeshMaterialAttribute* BuildingMaterials = Building.Attributes()->GetMaterialID();
+	for (int32 TriangleID : Building.TriangleIndicesItr()) {
+		BuildingMaterials->SetValue(TriangleID, (TriangleID / 12) % NumMaterials);
+	}
+	return Building;
+}
+
+// Box project the uvs of the whole of `Mesh` with `Transform` through the engine's SetMeshUVsFromBoxProjection and
+// through UUVUtilities, and describe the triangle corners whose uvs differ by more than `Tolerance`. Empty if they match.
+static TArray<FString> CompareBoxProjections(const UE::Geometry::FDynamicMesh3& Mesh, const FTransform& Transform, float Tolerance)
+{
+	using namespace UE::Geometry;
+	UDynamicMesh* EngineMesh = NewObject<UDynamicMesh>();
+	EngineMesh->SetMesh(Mesh);
+	UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(EngineMesh, 0, Transform, 2);
+
+	// one projection for every material id, so every triangle is projected like the engine does
+	FDynamicMesh3 FastMesh = Mesh;
+	TArray<FUVBoxProjection> Projections;
+	const FDynamicMeshMaterialAttribute* MaterialIDs = FastMesh.Attributes()->GetMaterialID();
+	TSet<int32> SeenIDs;
+	for (int32 TriangleID : FastMesh.TriangleIndicesItr()) {
+		const int32 MaterialID = MaterialIDs->GetValue(TriangleID);
+		if (!SeenIDs.Contains(MaterialID)) {
+			SeenIDs.Add(MaterialID);
+			FUVBoxProjection& Projection = Projections.AddDefaulted_GetRef();
+			Projection.MaterialID = MaterialID;
+			Projection.Transform = Transform;
+		}
+	}
+	UUVUtilities::SetMeshUVsFromBoxProjections(FastMesh, Projections);
+
+	TArray<FString> Differences;
+	int32 NumCorners = 0;
+	int32 NumDifferent = 0;
+	EngineMesh->ProcessMesh([&](const FDynamicMesh3& ReadMesh)
+	{
+		const FDynamicMeshUVOverlay* EngineUVs = ReadMesh.Attributes()->PrimaryUV();
+		const FDynamicMeshUVOverlay* FastUVs = FastMesh.Attributes()->PrimaryUV();
+		for (int32 TriangleID : ReadMesh.TriangleIndicesItr()) {
+			if (!EngineUVs->IsSetTriangle(TriangleID) || !FastUVs->IsSetTriangle(TriangleID)) {
+				Differences.Add(FString::Printf(TEXT("triangle %i has no uvs"), TriangleID));
+				continue;
+			}
+			const FIndex3i EngineTriangle = EngineUVs->GetTriangle(TriangleID);
+			const FIndex3i FastTriangle = FastUVs->GetTriangle(TriangleID);
+			for (int32 Corner = 0; Corner < 3; Corner++) {
+				const FVector2f EngineUV = EngineUVs->GetElement(EngineTriangle[Corner]);
+				const FVector2f FastUV = FastUVs->GetElement(FastTriangle[Corner]);
+				NumCorners++;
+				if (!EngineUV.Equals(FastUV, Tolerance)) {
+					if (NumDifferent == 0) {
+						Differences.Add(FString::Printf(TEXT("triangle %i (normal %s) corner %i: engine %s, batched %s"),
+							TriangleID, *ReadMesh.GetTriNormal(TriangleID).ToString(), Corner, *EngineUV.ToString(), *FastUV.ToString()));
+					}
+					NumDifferent++;
+				}
+			}
+		}
+	});
+	if (NumDifferent > 0) {
+		Differences.Add(FString::Printf(TEXT("%i of %i corners differ"), NumDifferent, NumCorners));
+	}
+	return Differences;
+}
+
+// uvs are fractions of the projection box, well below a texel of a 4k texture
+static const float UV_PROJECTION_TOLERANCE = 1.e-4f;
+
+void BuildingBenchmarks::RunUVBenchmark(int32 NumTriangles)
+{
+	using namespace UE::Geometry;
+	const int32 NumMaterials = 4;
+	const FDynamicMesh3 Building = MakeUVSample(NumTriangles, NumMaterials);
+
+	const FBox Bounds = FBox(Building.GetBounds(true));
+	TArray<FUVBoxProjection> Projections;
+	for (int32 MaterialID = 0; MaterialID < NumMaterials; MaterialID++) {
+		FUVBoxProjection Projection;
+		Projection.MaterialID = MaterialID;
+		Projection.Transform = FTransform(Bounds.Min + FVector(MaterialID * 10.f));
+		Projection.Transform.SetScale3D(FVector(1000.f));
+		Projections.Add(Projection);
+	}
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark UVs - %i triangles, %i material ids"), Building.TriangleCount(), NumMaterials);
+
+	// ============ one projection per material id ============
+	// a SetMeshUVsFromBoxProjection call per id over the whole mesh, what the generator did before the batched projection
+	double PerIdSeconds = 0.0;
+	{
+		UDynamicMesh* Mesh = NewObject<UDynamicMesh>();
+		Mesh->SetMesh(Building);
+		const double Start = FPlatformTime::Seconds();
+		for (const FUVBoxProjection& Projection : Projections) {
+			UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(Mesh, 0, Projection.Transform, 2);
+		}
+		PerIdSeconds = FPlatformTime::Seconds() - Start;
+	}
+
+	// ============ batched ============
+	double BatchedSeconds = 0.0;
+	{
+		FDynamicMesh3 Mesh = Building;
+		const double Start = FPlatformTime::Seconds();
+		UUVUtilities::SetMeshUVsFromBoxProjections(Mesh, Projections);
+		BatchedSeconds = FPlatformTime::Seconds() - Start;
+		UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark UVs - batched uv elements: %i"), Mesh.Attributes()->PrimaryUV()->ElementCount());
+	}
+
+	const TArray<FString> Differences = CompareBoxProjections(Building, Projections[0].Transform, UV_PROJECTION_TOLERANCE);
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark UVs - per id %.2f ms, batched %.2f ms (%.1fx)  %s"),
+		PerIdSeconds * 1000.0, BatchedSeconds * 1000.0, BatchedSeconds > 0.0 ? PerIdSeconds / BatchedSeconds : 0.0,
+		Differences.Num() == 0 ? TEXT("PASS") : *FString::Printf(TEXT("FAIL (%s)"), *FString::Join(Differences, TEXT(", "))));
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// The batched projection replaces SetMeshUVsFromBoxProjection, every triangle corner must get the engine's uv. The
+// sample has boxes turned off the projection axes and a turned, non uniform projection box as well as the generator's.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuildingBoxProjectionTest, "ProceduralBuildings.UVs.BatchedMatchesEngine",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBuildingBoxProjectionTest::RunTest(const FString& Parameters)
+{
+	using namespace UE::Geometry;
+	FDynamicMesh3 Mesh = MakeUVSample(1200, 4);
+	FDynamicBox Turned;
+	Turned.SetSize(FVector(200.f, 120.f, 300.f));
+	for (int32 Index = 0; Index < 4; Index++) {
+		Turned.SetTranslation(FVector(Index * 300.f, 500.f, 100.f));
+		Turned.SetRotation(FRotator(Index * 10.f, 30.f + Index * 17.f, 0.f));
+		Turned.GenerateMesh(Mesh);
+	}
+
+	const FBox Bounds = FBox(Mesh.GetBounds(true));
+	FTransform Generator = FTransform(Bounds.Min);
+	Generator.SetScale3D(FVector(1000.f));
+	FTransform TurnedBox = FTransform(FRotator(0.f, 25.f, 10.f), Bounds.GetCenter(), FVector(500.f, 800.f, 1200.f));
+	const TCHAR* Names[] = { TEXT("Generator projection"), TEXT("Turned projection") };
+	const FTransform Transforms[] = { Generator, TurnedBox };
+	for (int32 Case = 0; Case < 2; Case++) {
+		for (const FString& Difference : CompareBoxProjections(Mesh, Transforms[Case], UV_PROJECTION_TOLERANCE)) {
+			AddError(FString::Printf(TEXT("%s: batched uvs differ from SetMeshUVsFromBoxProjection, %s"), Names[Case], *Difference));
+		}
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
+
+// A building with windowed panels on every side and framing
+static FDynamicBuildingRecipe MakeSampleRecipe(int32 Seed)
+{
+	FDynamicBuildingRecipe Recipe;
+	Recipe.RandomSeed = Seed;
+	Recipe.PanelOptions.bPanelNorth = true;
+	Recipe.PanelOptions.bPanelEast = true;
+	Recipe.PanelOptions.bPanelSouth = true;
+	Recipe.PanelOptions.bPanelWest = true;
+	Recipe.PanelOptions.WindowDepth = 20.f;
+	Recipe.BoxOptions.bHasFraming = true;
+	return Recipe;
+}
+
+void BuildingBenchmarks::RunInstancingBenchmark(int32 Seed)
+{
+	using namespace UE::Geometry;
+
+	FDynamicBuildingRecipe Recipe = MakeSampleRecipe(Seed);
+
+	const TCHAR* ModeNames[] = { TEXT("Baked"), TEXT("Instanced") };
+	const EBuildingDetailOutput Modes[] = { EBuildingDetailOutput::Baked, EBuildingDetailOutput::Instanced };
+	int64 MeshBytes[2] = { 0, 0 };
+	FBuildingInstances Instances[2];
+	for (int32 Mode = 0; Mode < 2; Mode++) {
+		Recipe.DetailOutput = Modes[Mode];
+		UDynamicMesh* Mesh = NewObject<UDynamicMesh>();
+		TArray<UMaterialInterface*> Materials;
+
+		const double Start = FPlatformTime::Seconds();
+		BuildingGenerator Generator = BuildingGenerator(&Recipe);
+		Generator.Generate(Mesh, Materials, &Instances[Mode]);
+		const double Seconds = FPlatformTime::Seconds() - Start;
+
+		Mesh->ProcessMesh([&](const FDynamicMesh3& ReadMesh)
+		{
+			MeshBytes[Mode] = FPanelMeshCache::EstimateMeshBytes(ReadMesh);
+			UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Instancing - %-9s %8.2f ms  %8i tris  %8i verts  mesh %9.1f KB  %6i instances (%i insets, %i glass, %i bars) %8.1f KB"),
+				ModeNames[Mode], Seconds * 1000.0, ReadMesh.TriangleCount(), ReadMesh.VertexCount(), MeshBytes[Mode] / 1024.0,
+				Instances[Mode].Num(), Instances[Mode].WindowInsets.Num(), Instances[Mode].WindowGlass.Num(), Instances[Mode].LatticeBars.Num(),
+				Instances[Mode].GetInstanceBytes() / 1024.0);
+		});
+	}
+
+	// the unit meshes are shared by every building, they aren't counted
+	const int64 BakedBytes = MeshBytes[0] + Instances[0].GetInstanceBytes();
+	const int64 InstancedBytes = MeshBytes[1] + Instances[1].GetInstanceBytes();
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Instancing - saved %.1f KB per building (%.1f%%)"),
+		(BakedBytes - InstancedBytes) / 1024.0, BakedBytes > 0 ? (100.0 * (BakedBytes - InstancedBytes)) / BakedBytes : 0.0);
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Differences between the vertex, triangle, uv and material id buffers of two meshes, empty if they are identical.
+// Only the first difference of each buffer is reported.
+static TArray<FString> CompareMeshBuffers(const UE::Geometry::FDynamicMesh3& A, const UE::Geometry::FDynamicMesh3& B)
+{
+	using namespace UE::Geometry;
+	TArray<FString> Differences;
+	if (A.MaxVertexID() != B.MaxVertexID() || A.MaxTriangleID() != B.MaxTriangleID()) {
+		Differences.Add(FString::Printf(TEXT("%i / %i vertex ids, %i / %i triangle ids"), A.MaxVertexID(), B.MaxVertexID(), A.MaxTriangleID(), B.MaxTriangleID()));
+		return Differences;
+	}
+	for (int32 VertexID = 0; VertexID < A.MaxVertexID(); VertexID++) {
+		if (A.IsVertex(VertexID) != B.IsVertex(VertexID) || (A.IsVertex(VertexID) && A.GetVertex(VertexID) != B.GetVertex(VertexID))) {
+			Differences.Add(FString::Printf(TEXT("vertex %i"), VertexID));
+			break;
+		}
+	}
+	for (int32 TriangleID = 0; TriangleID < A.MaxTriangleID(); TriangleID++) {
+		if (A.IsTriangle(TriangleID) != B.IsTriangle(TriangleID) || (A.IsTriangle(TriangleID) && A.GetTriangle(TriangleID) != B.GetTriangle(TriangleID))) {
+			Differences.Add(FString::Printf(TEXT("triangle %i"), TriangleID));
+			break;
+		}
+	}
+
+	if (A.HasAttributes() != B.HasAttributes()) {
+		Differences.Add(TEXT("attributes set on one mesh only"));
+		return Differences;
+	}
+	if (!A.HasAttributes()) {
+		return Differences;
+	}
+	const FDynamicMeshUVOverlay* UVsA = A.Attributes()->PrimaryUV();
+	const FDynamicMeshUVOverlay* UVsB = B.Attributes()->PrimaryUV();
+	if ((UVsA == nullptr) != (UVsB == nullptr) || (UVsA != nullptr && UVsA->MaxElementID() != UVsB->MaxElementID())) {
+		Differences.Add(TEXT("uv element count"));
+	}
+	else if (UVsA != nullptr) {
+		for (int32 ElementID = 0; ElementID < UVsA->MaxElementID(); ElementID++) {
+			if (UVsA->IsElement(ElementID) != UVsB->IsElement(ElementID) || (UVsA->IsElement(ElementID) && UVsA->GetElement(ElementID) != UVsB->GetElement(ElementID))) {
+				Differences.Add(FString::Printf(TEXT("uv element %i"), ElementID));
+				break;
+			}
+		}
+		for (int32 TriangleID : A.TriangleIndicesItr()) {
+			if (UVsA->GetTriangle(TriangleID) != UVsB->GetTriangle(TriangleID)) {
+				Differences.Add(FString::Printf(TEXT("uv triangle %i"), TriangleID));
+				break;
+			}
+		}
+	}
+
+	const FDynamicMeshMaterialAttribute* MaterialsA = A.Attributes()->GetMaterialID();
+	const FDynamicMeshMaterialAttribute* MaterialsB = B.Attributes()->GetMaterialID();
+	if ((MaterialsA == nullptr) != (MaterialsB == nullptr)) {
+		Differences.Add(TEXT("material ids set on one mesh only"));
+	}
+	else if (MaterialsA != nullptr) {
+		for (int32 TriangleID : A.TriangleIndicesItr()) {
+			if (MaterialsA->GetValue(TriangleID) != MaterialsB->GetValue(TriangleID)) {
+				Differences.Add(FString::Printf(TEXT("material id of triangle %i"), TriangleID));
+				break;
+			}
+		}
+	}
+	return Differences;
+}
+
+// Boxes and panels are seeded by (building seed, box, face) and merged in box order, so building them concurrently
+// must give the same mesh, id for id, as building them one after the other.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuildingParallelGenerationTest, "ProceduralBuildings.Generator.ParallelMatchesSerial",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBuildingParallelGenerationTest::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* ParallelVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Building.Generator.Parallel"));
+	if (!TestNotNull(TEXT("Building.Generator.Parallel"), ParallelVar)) {
+		return false;
+	}
+	const bool bWasParallel = ParallelVar->GetBool();
+
+	FDynamicBuildingRecipe Recipe = MakeSampleRecipe(1234);
+	Recipe.PanelOptions.bPanelRoof = true;
+
+	UDynamicMesh* Meshes[2] = { NewObject<UDynamicMesh>(), NewObject<UDynamicMesh>() };
+	TArray<UMaterialInterface*> MaterialSets[2];
+	for (int32 Run = 0; Run < 2; Run++) {
+		// the caches would hand the second run the first run's panels and lattices
+		FPanelMeshCache::Get().Empty();
+		FLatticeMeshCache::Get().Empty();
+		ParallelVar->Set(Run == 1);
+		BuildingGenerator(&Recipe).Generate(Meshes[Run], MaterialSets[Run]);
+	}
+	ParallelVar->Set(bWasParallel);
+
+	TestTrue(TEXT("Building has triangles"), Meshes[0]->GetTriangleCount() > 0);
+	TestTrue(TEXT("Material sets match"), MaterialSets[0] == MaterialSets[1]);
+	Meshes[0]->ProcessMesh([&](const UE::Geometry::FDynamicMesh3& Serial)
+	{
+		Meshes[1]->ProcessMesh([&](const UE::Geometry::FDynamicMesh3& Parallel)
+		{
+			for (const FString& Difference : CompareMeshBuffers(Serial, Parallel)) {
+				AddError(FString::Printf(TEXT("Parallel generation differs from serial, %s"), *Difference));
+			}
+		});
+	});
+	return true;
+}
+
+// A layout whose boxes all have the same size, so each one is stacked `Step` (its height plus the spacing) above the last
+static FDynamicBuildingRecipe MakeLayoutRecipe(double BuildingHeight)
+{
+	FDynamicBuildingRecipe Recipe = MakeSampleRecipe(1234);
+	Recipe.BuildingSize.Z = BuildingHeight;
+	Recipe.BoxOptions.NumFloorsVariance = 0;
+	Recipe.BoxOptions.bVaryBoxSizePercent = false;
+	return Recipe;
+}
+
+// Check the boxes are stacked `Step` apart, fit in the usable height, and that the stack height counts the first box
+// that didn't fit when boxes were dropped. Returns the number of boxes.
+static int32 CheckLayoutStack(FAutomationTestBase& Test, const TCHAR* Name, const FBuildingLayout& Layout, double Step)
+{
+	const int32 NumBoxes = Layout.Boxes.Num();
+	Test.TestTrue(FString::Printf(TEXT("%s, no more than MaxNumBoxes boxes"), Name), NumBoxes <= Layout.MaxNumBoxes);
+	for (int32 Index = 0; Index < NumBoxes; Index++) {
+		const FBuildingBoxLayout& Box = Layout.Boxes[Index];
+		Test.TestEqual(FString::Printf(TEXT("%s, box %i index"), Name, Index), Box.BoxNum, Index);
+		Test.TestEqual(FString::Printf(TEXT("%s, box %i Z"), Name, Index), Box.Z, Index * Step, 1.e-3);
+		Test.TestTrue(FString::Printf(TEXT("%s, box %i fits"), Name, Index), Box.Z + Step < Layout.UsableHeight);
+	}
+	if (NumBoxes < Layout.MaxNumBoxes) {
+		// kept as it always was, the vertical alignment is computed from this height
+		Test.TestEqual(FString::Printf(TEXT("%s, stack height includes the dropped box"), Name), Layout.StackHeight, (NumBoxes + 1) * Step, 1.e-3);
+		Test.TestTrue(FString::Printf(TEXT("%s, dropped box doesn't fit"), Name), Layout.StackHeight >= Layout.UsableHeight);
+	}
+	else {
+		Test.TestEqual(FString::Printf(TEXT("%s, stack height"), Name), Layout.StackHeight, NumBoxes * Step, 1.e-3);
+	}
+	return NumBoxes;
+}
+
+// The layout is what Generate builds from: a box per MaxNumBoxes stacked bottom to top, minus the ones that would go
+// past the usable height.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuildingLayoutTest, "ProceduralBuildings.Layout.Stacking",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBuildingLayoutTest::RunTest(const FString& Parameters)
+{
+	// a building tall enough for a single box gives the height of every box
+	FDynamicBuildingRecipe Recipe = MakeLayoutRecipe(1000000.0);
+	Recipe.BoxOptions.bExplicitNumberOfBoxes = true;
+	Recipe.BoxOptions.NumberOfBoxes = 1;
+	const FBuildingLayout Single = BuildingGenerator(&Recipe).MakeLayout();
+	if (!TestEqual(TEXT("Single box"), Single.Boxes.Num(), 1)) {
+		return false;
+	}
+	const double Step = Single.Boxes[0].Height + Recipe.BoxOptions.VerticalSpacing;
+	TestTrue(TEXT("Box is at least as tall as its floors"), Single.Boxes[0].Height >= Recipe.BoxOptions.NumFloors * Recipe.BoxOptions.FloorHeight);
+
+	// explicit boxes that all fit
+	Recipe.BoxOptions.NumberOfBoxes = 3;
+	TestEqual(TEXT("Explicit, all boxes kept"), CheckLayoutStack(*this, TEXT("Explicit"), BuildingGenerator(&Recipe).MakeLayout(), Step), 3);
+
+	// explicit boxes that don't, the stack stops at the first box that reaches the top
+	Recipe = MakeLayoutRecipe(10000.0);
+	Recipe.BoxOptions.bExplicitNumberOfBoxes = true;
+	Recipe.BoxOptions.NumberOfBoxes = 50;
+	const int32 NumFit = FMath::CeilToInt(10000.0 / Step) - 1;
+	TestEqual(TEXT("Explicit, boxes dropped"), CheckLayoutStack(*this, TEXT("Explicit dropped"), BuildingGenerator(&Recipe).MakeLayout(), Step), NumFit);
+
+	// the box count from the building height doesn't count the spacing, the top boxes are dropped
+	Recipe.BoxOptions.bExplicitNumberOfBoxes = false;
+	const FBuildingLayout FromHeight = BuildingGenerator(&Recipe).MakeLayout();
+	TestEqual(TEXT("From height, MaxNumBoxes"), FromHeight.MaxNumBoxes, 10000 / int32(Recipe.BoxOptions.NumFloors * Recipe.BoxOptions.FloorHeight));
+	TestEqual(TEXT("From height, boxes dropped"), CheckLayoutStack(*this, TEXT("From height"), FromHeight, Step), NumFit);
+
+	// only part of the height is usable
+	Recipe.BoxOptions.bSpecifyVerticalSpawnRange = true;
+	Recipe.BoxOptions.VerticalSpawnPercent = 50;
+	const FBuildingLayout SpawnRange = BuildingGenerator(&Recipe).MakeLayout();
+	TestEqual(TEXT("Spawn range, usable height"), SpawnRange.UsableHeight, 5000.0, 1.e-3);
+	TestEqual(TEXT("Spawn range, boxes"), CheckLayoutStack(*this, TEXT("Spawn range"), SpawnRange, Step), FMath::CeilToInt(5000.0 / Step) - 1);
+
+	// a building lower than a single box has no boxes at all
+	Recipe = MakeLayoutRecipe(FMath::FloorToDouble(Step * 0.5));
+	TestEqual(TEXT("Too low, no boxes"), CheckLayoutStack(*this, TEXT("Too low"), BuildingGenerator(&Recipe).MakeLayout(), Step), 0);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
+
+// written by the suite cases so the compiler can't discard the work being timed
+static volatile double GBenchmarkSink = 0.0;
+
+// One case of the suite, `Detail` describes the case's output (eg. number of windows) so a change in the work done
+// isn't mistaken for a change in speed
+struct FSuiteCase
+{
+	FString Name;
+	FString Detail;
+	TFunction<void()> Run;
+};
+
+// Median milliseconds of `NumIterations` runs, after one warm up run
+static double TimeMedianMs(const TFunction<void()>& Run, int32 NumIterations)
+{
+	Run();
+	TArray<double> Samples;
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++) {
+		const double Start = FPlatformTime::Seconds();
+		Run();
+		Samples.Add((FPlatformTime::Seconds() - Start) * 1000.0);
+	}
+	Samples.Sort();
+	return Samples[Samples.Num() / 2];
+}
+
+static TMap<FString, double> LoadBaseline(const FString& FileName)
+{
+	TMap<FString, double> Baseline;
+	FString JsonString;
+	TSharedPtr<FJsonObject> Root;
+	if (!FFileHelper::LoadFileToString(JsonString, *FileName) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonString), Root) || !Root.IsValid()) {
+		return Baseline;
+	}
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Case : Root->Values) {
+		Baseline.Add(Case.Key, Case.Value->AsNumber());
+	}
+	return Baseline;
+}
+
+static bool SaveBaseline(const FString& FileName, const TMap<FString, double>& Results)
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	for (const TPair<FString, double>& Case : Results) {
+		Root->SetNumberField(Case.Key, Case.Value);
+	}
+	FString JsonString;
+	FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&JsonString));
+	return FFileHelper::SaveStringToFile(JsonString, *FileName);
+}
+
+FString BuildingBenchmarks::GetBaselineFileName()
+{
+	return FPaths::ProjectSavedDir() / TEXT("BuildingBenchmarks") / TEXT("SuiteBaseline.json");
+}
+
+// The meshes and samples the cases of a suite run work on, kept alive until the run is done
+struct FSuiteContext
+{
+	TArray<UDynamicMesh*> CaseMeshes;
+	TArray<TSharedRef<FBoxWindowSample>> BoxWindowSamples;
+
+	UDynamicMesh* NewCaseMesh()
+	{
+		UDynamicMesh* Mesh = NewObject<UDynamicMesh>();
+		Mesh->AddToRoot();
+		CaseMeshes.Add(Mesh);
+		return Mesh;
+	}
+
+	~FSuiteContext()
+	{
+		for (UDynamicMesh* Mesh : CaseMeshes) {
+			Mesh->RemoveFromRoot();
+		}
+		for (const TSharedRef<FBoxWindowSample>& Sample : BoxWindowSamples) {
+			ReleaseBoxWindowSample(Sample.Get());
+		}
+	}
+};
+
+// BooleanGrid::ApplyBooleans by window count
+static void AddApplyBooleansCases(FSuiteContext& Context, TArray<FSuiteCase>& Cases)
+{
+	using namespace UE::Geometry;
+	// wider panels fit more windows, the same options are used for every width
+	FBooleanGridOptions WindowOptions;
+	WindowOptions.RandomSeed = 1234;
+	WindowOptions.Depth = 15.f;
+	WindowOptions.BooleanSizeMin = FVector2D(150.f, 200.f);
+	WindowOptions.BooleanSizeMax = FVector2D(250.f, 250.f);
+	WindowOptions.HorizontalSpacing = 50.f;
+	WindowOptions.VerticalSpacing = 150.f;
+	WindowOptions.SafeEdge = 50.f;
+	for (const float PanelWidth : { 1000.f, 2000.f, 4000.f, 8000.f }) {
+		FDynamicBox Cube;
+		Cube.SetSize(FVector(20.f, PanelWidth, 800.f));
+		Cube.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
+		TSharedRef<FDynamicMesh3> Slab = MakeShared<FDynamicMesh3>();
+		Cube.GenerateMesh(*Slab);
+
+		for (const EBuildingCutMode CutMode : { EBuildingCutMode::Analytic, EBuildingCutMode::Boolean }) {
+			TSharedRef<FBooleanGridOptions> Options = MakeShared<FBooleanGridOptions>(WindowOptions);
+			Options->CutMode = CutMode;
+			const int32 NumWindows = BooleanGrid(&Options.Get()).GetBooleanBoxes(FBox(Slab->GetBounds(true))).Num();
+
+			UDynamicMesh* Mesh = Context.NewCaseMesh();
+			Cases.Add({
+				FString::Printf(TEXT("ApplyBooleans.%s.%icm"), CutMode == EBuildingCutMode::Analytic ? TEXT("Analytic") : TEXT("Boolean"), FMath::RoundToInt(PanelWidth)),
+				FString::Printf(TEXT("%i windows"), NumWindows),
+				[Slab, Options, Mesh]()
+				{
+					Mesh->SetMesh(*Slab);
+					BooleanGrid(&Options.Get()).ApplyBooleans(Mesh, EGeometryScriptBooleanOperation::Subtract);
+				} });
+		}
+	}
+}
+
+// Box windows, a boolean per panel (serial and concurrent) or one per box
+static void AddBoxWindowsCases(FSuiteContext& Context, TArray<FSuiteCase>& Cases)
+{
+	using namespace UE::Geometry;
+	for (const float BoxWidth : { 1000.f, 4000.f }) {
+		TSharedRef<FBoxWindowSample> Sample = MakeShared<FBoxWindowSample>(MakeBoxWindowSample(FVector(BoxWidth, BoxWidth, 800.f)));
+		Context.BoxWindowSamples.Add(Sample);
+		const int32 NumWindows = CutBoxWindowsBatched(Sample.Get(), Context.NewCaseMesh());
+		const FString Detail = FString::Printf(TEXT("%i windows"), NumWindows);
+
+		UDynamicMesh* Mesh = Context.NewCaseMesh();
+		Cases.Add({ FString::Printf(TEXT("BoxWindows.PerPanel.%icm"), FMath::RoundToInt(BoxWidth)), Detail,
+			[Sample, Mesh]() { CutBoxWindowsPerPanel(Sample.Get(), Mesh, false); } });
+		Cases.Add({ FString::Printf(TEXT("BoxWindows.Parallel.%icm"), FMath::RoundToInt(BoxWidth)), Detail,
+			[Sample, Mesh]() { CutBoxWindowsPerPanel(Sample.Get(), Mesh, true); } });
+		Cases.Add({ FString::Printf(TEXT("BoxWindows.Batched.%icm"), FMath::RoundToInt(BoxWidth)), Detail,
+			[Sample, Mesh]() { CutBoxWindowsBatched(Sample.Get(), Mesh); } });
+	}
+}
+
+// LatticeGrid::ApplyLattice by density
+static void AddApplyLatticeCases(FSuiteContext& Context, TArray<FSuiteCase>& Cases)
+{
+	using namespace UE::Geometry;
+	// the four sides of a 40m box, closer spacing means more rows and columns
+	const FBox LatticeBox = FBox(FVector(-2000.f, -2000.f, 0.f), FVector(2000.f, 2000.f, 4000.f));
+	TArray<FLatticeFaceFrame> LatticeFaces;
+	for (const FVector& Direction : { FVector::ForwardVector, FVector::RightVector, FVector::BackwardVector, FVector::LeftVector }) {
+		LatticeFaces.Add(FLatticeFaceFrame::FromBox(LatticeBox, Direction));
+	}
+	for (const float Spacing : { 1000.f, 500.f, 250.f, 125.f }) {
+		TSharedRef<FLatticeGridOptions> Options = MakeShared<FLatticeGridOptions>();
+		Options->Spacing = FVector2D(Spacing);
+		Options->bHasBorder = true;
+
+		UDynamicMesh* Mesh = Context.NewCaseMesh();
+		TArray<UMaterialInterface*> MaterialSet;
+		LatticeGrid(&Options.Get()).ApplyLattice(Mesh, LatticeFaces, MaterialSet);
+		Cases.Add({
+			FString::Printf(TEXT("ApplyLattice.%icm"), FMath::RoundToInt(Spacing)),
+			FString::Printf(TEXT("%i tris"), Mesh->GetTriangleCount()),
+			[Options, Mesh, LatticeFaces]()
+			{
+				TArray<UMaterialInterface*> Materials;
+				Mesh->Reset();
+				LatticeGrid(&Options.Get()).ApplyLattice(Mesh, LatticeFaces, Materials);
+			} });
+	}
+}
+
+// UUVUtilities::GetMeshUVTransform by mode
+static void AddGetMeshUVTransformCases(FSuiteContext& Context, TArray<FSuiteCase>& Cases)
+{
+	const int32 NumTransforms = 10000;
+	for (const EBuildingUVScaleMode ScaleMode : { EBuildingUVScaleMode::Fixed, EBuildingUVScaleMode::MinExtent, EBuildingUVScaleMode::AvgExtent }) {
+		for (const EBuildingUVOriginMode OriginMode : { EBuildingUVOriginMode::MinCoordinate, EBuildingUVOriginMode::Random }) {
+			Cases.Add({
+				FString::Printf(TEXT("GetMeshUVTransform.%s.%s"), *StaticEnum<EBuildingUVScaleMode>()->GetNameStringByValue((int64)ScaleMode), *StaticEnum<EBuildingUVOriginMode>()->GetNameStringByValue((int64)OriginMode)),
+				FString::Printf(TEXT("%i transforms"), NumTransforms),
+				[ScaleMode, OriginMode, NumTransforms]()
+				{
+					const FBuildingRandom Random = FBuildingRandom(1234).Stage(EBuildingRandomStage::BoxUVs);
+					double Sink = 0.0;
+					for (int32 Index = 0; Index < NumTransforms; Index++) {
+						FBox Bounds = FBox(FVector(0.f), FVector(1000.f + Index, 2000.f, 3000.f));
+						Sink += UUVUtilities::GetMeshUVTransform(Bounds, ScaleMode, OriginMode, Random.Element(Index), 2000.f).GetLocation().X;
+					}
+					GBenchmarkSink = Sink;
+				} });
+		}
+	}
+}
+
+// FDynamicBuildingPanelOptions helpers by building size
+static void AddPanelSizeAndTransformCases(FSuiteContext& Context, TArray<FSuiteCase>& Cases)
+{
+	const int32 NumPanelQueries = 10000;
+	for (const float BuildingSize : { 1000.f, 10000.f, 50000.f }) {
+		Cases.Add({
+			FString::Printf(TEXT("PanelSizeAndTransform.%icm"), FMath::RoundToInt(BuildingSize)),
+			FString::Printf(TEXT("%i boxes x 4 panels"), NumPanelQueries),
+			[BuildingSize, NumPanelQueries]()
+			{
+				FDynamicBuildingPanelOptions Options;
+				Options.bPanelNorth = true;
+				Options.bPanelEast = true;
+				Options.bPanelSouth = true;
+				Options.bPanelWest = true;
+				const TArray<FVector> Faces = Options.GetSideVectors();
+				double Sink = 0.0;
+				for (int32 Index = 0; Index < NumPanelQueries; Index++) {
+					const FVector BoxSize = FVector(BuildingSize, BuildingSize * 0.5f, 1600.f + Index % 7);
+					for (const FVector& Face : Faces) {
+						const FSizeAndTransform Panel = Options.GetPanelSizeAndTransform(Face, BoxSize);
+						Sink += Panel.Size.Y + (Panel.Transform * Options.GetPanelBoxTransform(Face, BoxSize)).GetLocation().X;
+					}
+				}
+				GBenchmarkSink = Sink;
+			} });
+	}
+}
+
+// A parameter sweep of the suite, its cases are named "<Sweep>.<Parameters>"
+struct FSuiteSweep
+{
+	const TCHAR* Name;
+	void (*AddCases)(FSuiteContext& Context, TArray<FSuiteCase>& Cases);
+};
+
+static const FSuiteSweep SuiteSweeps[] = {
+	{ TEXT("ApplyBooleans"), &AddApplyBooleansCases },
+	{ TEXT("BoxWindows"), &AddBoxWindowsCases },
+	{ TEXT("ApplyLattice"), &AddApplyLatticeCases },
+	{ TEXT("GetMeshUVTransform"), &AddGetMeshUVTransformCases },
+	{ TEXT("PanelSizeAndTransform"), &AddPanelSizeAndTransformCases },
+};
+
+// Time every case and compare it with `Baseline`, the times go to `OutResults` and a description of every case more
+// than the threshold slower than its baseline to `OutRegressions`. Cases without a baseline are only logged.
+static void RunSuiteCases(const TArray<FSuiteCase>& Cases, int32 NumIterations, const TMap<FString, double>& Baseline, TMap<FString, double>& OutResults, TArray<FString>& OutRegressions)
+{
+	const double Threshold = FMath::Max(CVarBenchmarkThreshold.GetValueOnAnyThread(), 0.f) * 0.01;
+	for (const FSuiteCase& Case : Cases) {
+		const double Ms = TimeMedianMs(Case.Run, NumIterations);
+		OutResults.Add(Case.Name, Ms);
+
+		const double* BaselineMs = Baseline.Find(Case.Name);
+		if (BaselineMs == nullptr || *BaselineMs <= 0.0) {
+			UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Suite - %-40s %10.3f ms  %-22s  (no baseline)"), *Case.Name, Ms, *Case.Detail);
+			continue;
+		}
+		const double Change = (Ms - *BaselineMs) / *BaselineMs;
+		const bool bRegression = Change > Threshold;
+		if (bRegression) {
+			OutRegressions.Add(FString::Printf(TEXT("%s %.3f ms, baseline %.3f ms (%+.1f%%, threshold %.0f%%)"),
+				*Case.Name, Ms, *BaselineMs, Change * 100.0, Threshold * 100.0));
+		}
+		UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Suite - %-40s %10.3f ms  %-22s  baseline %10.3f ms  %+6.1f%%  %s"),
+			*Case.Name, Ms, *Case.Detail, *BaselineMs, Change * 100.0, bRegression ? TEXT("REGRESSION") : TEXT("ok"));
+	}
+}
+
+int32 BuildingBenchmarks::RunSuite(int32 NumIterations, bool bSaveBaseline)
+{
+	FSuiteContext Context;
+	TArray<FSuiteCase> Cases;
+	for (const FSuiteSweep& Sweep : SuiteSweeps) {
+		Sweep.AddCases(Context, Cases);
+	}
+
+	const FString BaselineFile = GetBaselineFileName();
+	const TMap<FString, double> Baseline = LoadBaseline(BaselineFile);
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Suite - %i cases, %i iterations, threshold %.0f%%, baseline %s (%i cases)"),
+		Cases.Num(), NumIterations, FMath::Max(CVarBenchmarkThreshold.GetValueOnAnyThread(), 0.f), *BaselineFile, Baseline.Num());
+
+	TMap<FString, double> Results;
+	TArray<FString> Regressions;
+	RunSuiteCases(Cases, NumIterations, Baseline, Results, Regressions);
+
+	if (bSaveBaseline) {
+		if (SaveBaseline(BaselineFile, Results)) {
+			UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Suite - baseline saved to %s"), *BaselineFile);
+		}
+		else {
+			UE_LOG(LogBuildingGeneration, Error, TEXT("Benchmark Suite - can't write %s"), *BaselineFile);
+		}
+	}
+
+	if (Regressions.Num() > 0) {
+		UE_LOG(LogBuildingGeneration, Warning, TEXT("Benchmark Suite - %i of %i cases regressed"), Regressions.Num(), Cases.Num());
+	}
+	else {
+		UE_LOG(LogBuildingGeneration, Display, TEXT("Benchmark Suite - no regressions"));
+	}
+	return Regressions.Num();
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Every sweep of the suite is a perf test, compared with the saved baseline (Building.Benchmark.Suite 20 save).
+// A case slower than its baseline by more than Building.Benchmark.Threshold percent fails the test.
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FBuildingBenchmarkSuiteTest, "ProceduralBuildings.Benchmark.Suite",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+void FBuildingBenchmarkSuiteTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const FSuiteSweep& Sweep : SuiteSweeps) {
+		OutBeautifiedNames.Add(Sweep.Name);
+		OutTestCommands.Add(Sweep.Name);
+	}
+}
+
+bool FBuildingBenchmarkSuiteTest::RunTest(const FString& Parameters)
+{
+	const FSuiteSweep* Sweep = Algo::FindByPredicate(SuiteSweeps, [&Parameters](const FSuiteSweep& Candidate) { return Parameters == Candidate.Name; });
+	if (Sweep == nullptr) {
+		AddError(FString::Printf(TEXT("Unknown sweep %s"), *Parameters));
+		return false;
+	}
+
+	FSuiteContext Context;
+	TArray<FSuiteCase> Cases;
+	Sweep->AddCases(Context, Cases);
+
+	const TMap<FString, double> Baseline = LoadBaseline(GetBaselineFileName());
+	TMap<FString, double> Results;
+	TArray<FString> Regressions;
+	RunSuiteCases(Cases, SUITE_TEST_ITERATIONS, Baseline, Results, Regressions);
+
+	for (const FSuiteCase& Case : Cases) {
+		if (!Baseline.Contains(Case.Name)) {
+			AddWarning(FString::Printf(TEXT("%s has no baseline, save one with Building.Benchmark.Suite %i save"), *Case.Name, SUITE_TEST_ITERATIONS));
+		}
+	}
+	for (const FString& Regression : Regressions) {
+		AddError(FString::Printf(TEXT("Regression: %s"), *Regression));
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
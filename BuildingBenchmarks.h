@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Micro benchmarks for the building pipeline, run from the console and written to the log.
+ *
+ * HOWTO:
+ *	Building.Benchmark.Random 10000000
+ *	Building.Benchmark.Windows 100
+ *	Building.Benchmark.BoxWindows 20
+ *	Building.Benchmark.UVs 1000000
+ *	Building.Benchmark.Instancing 1234
+ *	Building.Benchmark.Suite 20 save
+ */
+class PROCEDURALBUILDINGS_API BuildingBenchmarks
+{
+public:
+	// Throughput of FRandomStream against FBuildingRandom (on one thread and with ParallelFor) for `NumValues` draws
+	static void RunRandomBenchmark(int32 NumValues);
+
+	// Time of cutting the windows of a sample panel with a mesh boolean against analytic cut-outs, for through and
+	// pocket windows. Also checks both produce the same solid, material areas and uv bounds, the automation test
+	// ProceduralBuildings.Windows.AnalyticMatchesBoolean fails on the same check.
+	static void RunWindowBenchmark(int32 NumIterations);
+
+	// Time of cutting the windows of a box with windowed panels on all four sides: a mesh boolean per panel one after
+	// the other (the generator's Boolean cut mode without ParallelFor), a mesh boolean per panel run concurrently, and
+	// the panels placed first with a single mesh boolean for all their windows (BoxBoolean), for a few box widths.
+	static void RunBoxWindowBenchmark(int32 NumIterations);
+
+	// Time of box projecting the uvs of 4 material ids on a mesh of `NumTriangles`, a SetMeshUVsFromBoxProjection call
+	// per id against the batched UUVUtilities::SetMeshUVsFromBoxProjections, and whether both give the same uvs
+	static void RunUVBenchmark(int32 NumTriangles);
+
+	// Generate a sample building (panels with windows on every side, framing on every box) baked and instanced, and 
+	// report the instance counts and the memory the instanced output saves.
+	static void RunInstancingBenchmark(int32 Seed);
+
+	// Parameter sweeps of the hot components: window cut-outs by window count, per panel and per box window booleans, lattices by density, uv transforms by 
+	// mode and the panel size/transform helpers by building size. Each case reports the median of `NumIterations` runs
+	// and is compared with the saved baseline, a case more than `Building.Benchmark.Threshold` percent slower is a 
+	// regression. `bSaveBaseline` replaces the baseline with this run. Returns the number of regressions.
+	// Every sweep also runs as the perf test ProceduralBuildings.Benchmark.Suite.<Sweep>.
+	static int32 RunSuite(int32 NumIterations, bool bSaveBaseline);
+
+	// Json file the suite baseline is kept in, case name to milliseconds
+	static FString GetBaselineFileName();
+};
@@ -11,6 +11,23 @@ enum class EBuildingBooleanShapes : uint8
 	Rectangle
 };
 
+// How window (boolean) cut-outs are applied to a panel
+UENUM(BlueprintType)
+enum class EBuildingCutMode : uint8
+{
+	Boolean, // mesh boolean (CSG) with every window as a tool box
+	Analytic, // triangulate the slab with the windows as holes, falls back to Boolean if the mesh isn't a box
+	BoxBoolean // one mesh boolean per box, with the windows of all of its side panels as tool boxes
+};
+
+// How windows and lattice bars are output
+UENUM(BlueprintType)
+enum class EBuildingDetailOutput : uint8
+{
+	Baked, // windows and lattice bars are part of the building mesh
+	Instanced // windows and lattice bars are instances of shared unit meshes, panels are left uncut
+};
+
 UENUM(BlueprintType)
 enum class EBuildingRowCol : uint8
 {
@@ -0,0 +1,256 @@
+#include "BuildingExport.h"
+#include "DynamicBuilding.h"
+#include "BuildingGenerator.h"
+#include "BuildingStats.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "Components/DynamicMeshComponent.h"
+#include "UDynamicMesh.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#if WITH_EDITOR
+#include "MeshDescription.h"
+#include "StaticMeshAttributes.h"
+#include "DynamicMeshToMeshDescription.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#endif
+
+using namespace UE::Geometry;
+
+static FAutoConsoleCommandWithWorldAndArgs ExportAllCommand(
+	TEXT("Building.ExportAll"),
+	TEXT("Bake every building in the level into a static mesh asset. Usage: Building.ExportAll [PackagePath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const FString PackagePath = Args.Num() > 0 ? Args[0] : TEXT("/Game/Buildings");
+		BuildingExport::ExportWorld(World, PackagePath);
+	}));
+
+FString BuildingExport::GetAssetName(const ADynamicBuilding* Building)
+{
+	return FString::Printf(TEXT("SM_%s"), *Building->GetActorNameOrLabel());
+}
+
+int32 BuildingExport::ExportWorld(UWorld* World, const FString& PackagePath)
+{
+	if (World == nullptr) {
+		return 0;
+	}
+	TArray<ADynamicBuilding*> Buildings;
+	for (TActorIterator<ADynamicBuilding> It(World); It; ++It) {
+		Buildings.Add(*It);
+	}
+	return ExportBuildings(Buildings, PackagePath);
+}
+
+#if WITH_EDITOR
+
+// Everything needed to build the static mesh of one building
+struct FBuildingExportJob
+{
+	ADynamicBuilding* Building = nullptr;
+	FString AssetName;
+
+	// copies of the generated LOD meshes, with the material ids of each LOD remapped into `Materials`
+	TArray<FDynamicMesh3> LODMeshes;
+	TArray<TArray<int32>> LODMaterialRemaps;
+	TArray<UMaterialInterface*> Materials;
+
+	// slot of triangles whose material id has no material, the dynamic mesh draws them with the default material
+	int32 DefaultSlot = 0;
+
+	TArray<FMeshDescription> LODDescriptions;
+	UPackage* Package = nullptr;
+	UStaticMesh* StaticMesh = nullptr;
+};
+
+static FName GetSlotName(int32 Slot)
+{
+	return FName(*FString::Printf(TEXT("Slot%i"), Slot));
+}
+
+// Copy the meshes and materials out of a building, game thread only
+static bool GatherExportJob(ADynamicBuilding* Building, FBuildingExportJob& Job)
+{
+	Job.Building = Building;
+	Job.AssetName = BuildingExport::GetAssetName(Building);
+	for (int32 LODIndex = 0; LODIndex < BuildingGenerator::MAX_LODS; LODIndex++) {
+		UDynamicMeshComponent* Component = Building->GetLODComponent(LODIndex);
+		if (Component == nullptr || Component->GetDynamicMesh() == nullptr) {
+			break;
+		}
+		FDynamicMesh3 Mesh;
+		Component->GetDynamicMesh()->ProcessMesh([&Mesh](const FDynamicMesh3& Source) { Mesh = Source; });
+		if (Mesh.TriangleCount() == 0) {
+			break;
+		}
+		Job.LODMeshes.Add(MoveTemp(Mesh));
+
+		TArray<int32>& Remap = Job.LODMaterialRemaps.AddDefaulted_GetRef();
+		for (int32 MaterialIndex = 0; MaterialIndex < Component->GetNumMaterials(); MaterialIndex++) {
+			Remap.Add(Job.Materials.AddUnique(Component->GetMaterial(MaterialIndex)));
+		}
+	}
+	Job.DefaultSlot = Job.Materials.AddUnique(nullptr);
+	return Job.LODMeshes.Num() > 0;
+}
+
+// Convert the LOD meshes of a job to mesh descriptions, doesn't touch any UObject so jobs can run in parallel
+static void ConvertExportJob(FBuildingExportJob& Job)
+{
+	Job.LODDescriptions.SetNum(Job.LODMeshes.Num());
+	for (int32 LODIndex = 0; LODIndex < Job.LODMeshes.Num(); LODIndex++) {
+		FDynamicMesh3& Mesh = Job.LODMeshes[LODIndex];
+		const TArray<int32>& Remap = Job.LODMaterialRemaps[LODIndex];
+		if (Mesh.HasAttributes() && Mesh.Attributes()->HasMaterialID()) {
+			FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.Attributes()->GetMaterialID();
+			for (int32 TriangleID : Mesh.TriangleIndicesItr()) {
+				const int32 MaterialID = MaterialIDs->GetValue(TriangleID);
+				MaterialIDs->SetValue(TriangleID, Remap.IsValidIndex(MaterialID) ? Remap[MaterialID] : Job.DefaultSlot);
+			}
+		}
+
+		FMeshDescription& Description = Job.LODDescriptions[LODIndex];
+		FStaticMeshAttributes Attributes(Description);
+		Attributes.Register();
+		FDynamicMeshToMeshDescription Converter;
+		Converter.Convert(&Mesh, Description);
+
+		// the converter makes a polygon group per material id, name the groups after the slots so each section gets its material
+		TPolygonGroupAttributesRef<FName> SlotNames = Attributes.GetPolygonGroupMaterialSlotNames();
+		for (const FPolygonGroupID GroupID : Description.PolygonGroups().GetElementIDs()) {
+			SlotNames[GroupID] = GetSlotName(GroupID.GetValue());
+		}
+		Mesh.Clear();
+	}
+}
+
+// Create (or replace) the static mesh asset of a job and commit its LODs, game thread only. The mesh isn't built yet.
+static bool CreateExportAsset(FBuildingExportJob& Job, const FString& PackagePath)
+{
+	const FString PackageName = PackagePath / Job.AssetName;
+	Job.Package = CreatePackage(*PackageName);
+	if (Job.Package == nullptr) {
+		return false;
+	}
+	Job.Package->FullyLoad();
+
+	Job.StaticMesh = FindObject<UStaticMesh>(Job.Package, *Job.AssetName);
+	const bool bNewAsset = (Job.StaticMesh == nullptr);
+	if (bNewAsset) {
+		Job.StaticMesh = NewObject<UStaticMesh>(Job.Package, *Job.AssetName, RF_Public | RF_Standalone | RF_Transactional);
+	}
+	else {
+		Job.StaticMesh->Modify();
+		Job.StaticMesh->SetNumSourceModels(0);
+	}
+
+	TArray<FStaticMaterial>& StaticMaterials = Job.StaticMesh->GetStaticMaterials();
+	StaticMaterials.Reset();
+	for (int32 Slot = 0; Slot < Job.Materials.Num(); Slot++) {
+		StaticMaterials.Add(FStaticMaterial(Job.Materials[Slot], GetSlotName(Slot), GetSlotName(Slot)));
+	}
+
+	for (int32 LODIndex = 0; LODIndex < Job.LODDescriptions.Num(); LODIndex++) {
+		// the generator writes normals, only the tangents are left to the build
+		FStaticMeshSourceModel& SourceModel = Job.StaticMesh->AddSourceModel();
+		SourceModel.BuildSettings.bRecomputeNormals = false;
+		SourceModel.BuildSettings.bRecomputeTangents = true;
+
+		FMeshDescription* Description = Job.StaticMesh->CreateMeshDescription(LODIndex);
+		*Description = MoveTemp(Job.LODDescriptions[LODIndex]);
+		Job.StaticMesh->CommitMeshDescription(LODIndex);
+	}
+	Job.LODDescriptions.Reset();
+
+	if (bNewAsset) {
+		FAssetRegistryModule::AssetCreated(Job.StaticMesh);
+	}
+	return true;
+}
+
+static bool SaveExportAsset(FBuildingExportJob& Job)
+{
+	const FString FileName = FPackageName::LongPackageNameToFilename(Job.Package->GetName(), FPackageName::GetAssetPackageExtension());
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	SaveArgs.SaveFlags = SAVE_NoError;
+	return UPackage::SavePackage(Job.Package, Job.StaticMesh, *FileName, SaveArgs);
+}
+
+int32 BuildingExport::ExportBuildings(const TArray<ADynamicBuilding*>& Buildings, const FString& PackagePath)
+{
+	check(IsInGameThread());
+	const double StartTime = FPlatformTime::Seconds();
+
+	// ======== GATHER ========
+	TArray<FBuildingExportJob> Jobs;
+	Jobs.Reserve(Buildings.Num());
+	for (ADynamicBuilding* Building : Buildings) {
+		if (Building == nullptr || Building->IsGenerating()) {
+			continue;
+		}
+		FBuildingExportJob Job;
+		if (!GatherExportJob(Building, Job)) {
+			UE_LOG(LogBuildingGeneration, Warning, TEXT("Export - %s has no generated mesh, apply changes to regenerate it before exporting"), *Building->GetActorNameOrLabel());
+			continue;
+		}
+		Jobs.Add(MoveTemp(Job));
+	}
+	const double GatherTime = FPlatformTime::Seconds();
+
+	// ======== CONVERT ========
+	ParallelFor(Jobs.Num(), [&Jobs](int32 JobIndex)
+	{
+		ConvertExportJob(Jobs[JobIndex]);
+	});
+	const double ConvertTime = FPlatformTime::Seconds();
+
+	// ======== BUILD ========
+	TArray<UStaticMesh*> StaticMeshes;
+	for (FBuildingExportJob& Job : Jobs) {
+		if (CreateExportAsset(Job, PackagePath)) {
+			StaticMeshes.Add(Job.StaticMesh);
+		}
+	}
+	// builds the render data of all the meshes concurrently
+	UStaticMesh::BatchBuild(StaticMeshes, true);
+	const double BuildTime = FPlatformTime::Seconds();
+
+	// ======== SAVE ========
+	int32 NumSaved = 0;
+	for (FBuildingExportJob& Job : Jobs) {
+		if (Job.StaticMesh == nullptr) {
+			continue;
+		}
+		Job.StaticMesh->PostEditChange();
+		Job.StaticMesh->MarkPackageDirty();
+		if (!SaveExportAsset(Job)) {
+			UE_LOG(LogBuildingGeneration, Error, TEXT("Export - failed to save %s"), *Job.Package->GetName());
+			continue;
+		}
+		Job.Building->UseExportedMesh(Job.StaticMesh);
+		NumSaved++;
+	}
+
+	UE_LOG(LogBuildingGeneration, Display, TEXT("Export - %i of %i buildings saved to %s, gather %.1f ms, convert %.1f ms, build %.1f ms, save %.1f ms"),
+		NumSaved, Buildings.Num(), *PackagePath, (GatherTime - StartTime) * 1000.0, (ConvertTime - GatherTime) * 1000.0,
+		(BuildTime - ConvertTime) * 1000.0, (FPlatformTime::Seconds() - BuildTime) * 1000.0);
+	return NumSaved;
+}
+
+#else
+
+int32 BuildingExport::ExportBuildings(const TArray<ADynamicBuilding*>& Buildings, const FString& PackagePath)
+{
+	UE_LOG(LogBuildingGeneration, Warning, TEXT("Export - static mesh assets can only be exported in the editor"));
+	return 0;
+}
+
+#endif
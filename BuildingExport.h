@@ -0,0 +1,38 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ADynamicBuilding;
+class UStaticMesh;
+class UWorld;
+
+/**
+ * Bakes generated buildings into static mesh assets, so a finished city loads cooked static meshes instead of the
+ * dynamic meshes (or regenerating them).
+ *
+ * Every generated LOD of a building becomes a LOD of its static mesh and the material sets of the LODs are merged into
+ * the static mesh's material slots. A batch runs in three steps: the meshes are copied out of the buildings on the game
+ * thread, converted to mesh descriptions in parallel, then the assets are built and saved one at a time on the game
+ * thread (creating and saving packages isn't thread safe).
+ *
+ * Editor only, without the editor nothing is exported.
+ *
+ * HOWTO:
+ *	BuildingExport::ExportBuildings({ Building }, TEXT("/Game/Buildings"));
+ *	BuildingExport::ExportWorld(GetWorld(), TEXT("/Game/Buildings"));
+ *	Building.ExportAll /Game/Buildings
+ */
+class PROCEDURALBUILDINGS_API BuildingExport
+{
+public:
+	// Bake each building into a static mesh asset in `PackagePath` (eg. /Game/Buildings), an existing asset of the same
+	// name is replaced. Buildings switch to showing their static mesh (see ADynamicBuilding::UseExportedMesh).
+	// Returns the number of assets saved.
+	static int32 ExportBuildings(const TArray<ADynamicBuilding*>& Buildings, const FString& PackagePath);
+
+	// Bake every building in `World`
+	static int32 ExportWorld(UWorld* World, const FString& PackagePath);
+
+	// Name of the static mesh asset of a building
+	static FString GetAssetName(const ADynamicBuilding* Building);
+};
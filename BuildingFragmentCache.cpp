@@ -0,0 +1,42 @@
+#include "BuildingFragmentCache.h"
+#include "Misc/ScopeLock.h"
+
+FBuildingBoxFragmentPtr FBuildingFragmentCache::Find(int32 BoxIndex, uint64 Key) const
+{
+	FScopeLock ScopeLock(&Lock);
+	const FBuildingBoxFragmentPtr* Found = Fragments.Find(BoxIndex);
+	if (Found != nullptr && Found->IsValid() && (*Found)->Key == Key) {
+		NumHits++;
+		return *Found;
+	}
+	NumMisses++;
+	return nullptr;
+}
+
+void FBuildingFragmentCache::Store(int32 BoxIndex, FBuildingBoxFragmentPtr Fragment)
+{
+	FScopeLock ScopeLock(&Lock);
+	Fragments.Add(BoxIndex, Fragment);
+}
+
+void FBuildingFragmentCache::Trim(int32 NumBoxes)
+{
+	FScopeLock ScopeLock(&Lock);
+	for (auto It = Fragments.CreateIterator(); It; ++It) {
+		if (It.Key() >= NumBoxes) {
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FBuildingFragmentCache::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+	Fragments.Empty();
+}
+
+int32 FBuildingFragmentCache::Num() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Fragments.Num();
+}
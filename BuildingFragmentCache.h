@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "HAL/CriticalSection.h"
+#include "BuildingInstances.h"
+
+class UMaterialInterface;
+
+/**
+ * The generated geometry of a single box (box, floor, roof, panels and lattice) in box space.
+ *
+ * Material ID 0 keeps its meaning of "the default material", any material the box allocated itself is stored 
+ * in `Materials` and referenced by a local ID starting at 1. When the fragment is stitched into the building,
+ * local ID N is remapped to the building material at `Offset + N - 1`.
+ */
+struct PROCEDURALBUILDINGS_API FBuildingBoxFragment
+{
+	// hash of everything the geometry was generated from, if it matches the fragment can be reused.
+	uint64 Key = 0;
+
+	UE::Geometry::FDynamicMesh3 Mesh;
+
+	// materials allocated by the box, local material ID (i + 1) maps to Materials[i]
+	TArray<UMaterialInterface*> Materials;
+
+	// the highest point of the box or its roof (box space), used to stack the next box.
+	double TopZ = 0.0;
+
+	// the box geometry's own bounds, without floor, roof, panels or lattice.
+	FBox BoxBounds = FBox(ForceInit);
+
+	// windows and lattice bars of the box in box space, when they are output as instances
+	FBuildingInstances Instances;
+};
+
+typedef TSharedPtr<const FBuildingBoxFragment, ESPMode::ThreadSafe> FBuildingBoxFragmentPtr;
+
+/**
+ * Holds the last generated fragment for each box index of a building.
+ * Generation looks fragments up by box index and key, only boxes whose key changed are regenerated.
+ * 
+ * Thread safe, a superseded background generation may still be reading from the cache when a new one starts.
+ */
+class PROCEDURALBUILDINGS_API FBuildingFragmentCache
+{
+public:
+	// Returns the fragment for `BoxIndex` if it was generated with `Key`, otherwise nullptr
+	FBuildingBoxFragmentPtr Find(int32 BoxIndex, uint64 Key) const;
+
+	void Store(int32 BoxIndex, FBuildingBoxFragmentPtr Fragment);
+
+	// Discard fragments for boxes at or after `NumBoxes`, they are no longer part of the building
+	void Trim(int32 NumBoxes);
+
+	void Empty();
+
+	int32 Num() const;
+
+	// Running totals, useful to see how much work incremental regeneration is saving
+	int32 GetNumHits() const { return NumHits; }
+	int32 GetNumMisses() const { return NumMisses; }
+
+private:
+	mutable FCriticalSection Lock;
+	TMap<int32, FBuildingBoxFragmentPtr> Fragments;
+
+	mutable int32 NumHits = 0;
+	mutable int32 NumMisses = 0;
+};
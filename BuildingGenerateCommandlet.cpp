@@ -0,0 +1,266 @@
+#include "BuildingGenerateCommandlet.h"
+#include "BuildingGenerator.h"
+#include "BuildingGenerationStats.h"
+#include "BuildingStats.h"
+#include "BuildingInstances.h"
+#include "DynamicBuilding.h"
+#include "PanelMeshCache.h"
+#include "LatticeMeshCache.h"
+#include "UDynamicMesh.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "JsonObjectConverter.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+static const int32 NUM_STAGES = static_cast<int32>(EBuildingGenerationStage::Num);
+
+// One generation of one recipe, a row of the report
+struct FBuildingGenerateResult
+{
+	int32 RecipeIndex = 0;
+	int32 Seed = 0;
+	int32 Iteration = 0;
+	double WallMs = 0.0;
+	// wall time of each stage, and its CPU time summed over the worker threads
+	double StageMs[NUM_STAGES] = {};
+	double StageCpuMs[NUM_STAGES] = {};
+	int32 NumTriangles = 0;
+	int32 NumVertices = 0;
+	int64 MeshBytes = 0;
+	int32 NumInstances = 0;
+	// physical memory the process used more after the generation than before it (the mesh, instances and cache
+	// entries it left behind), and the peak of the whole process so far, which isn't per recipe
+	int64 UsedPhysicalDelta = 0;
+	uint64 ProcessPeakUsedPhysical = 0;
+	int32 NumMeshRequests = 0;
+	int32 NumMeshesAllocated = 0;
+	int32 PeakMeshesInUse = 0;
+	int32 NumVerticesBeforeFinalize = 0;
+	int32 NumTrianglesBeforeFinalize = 0;
+	int64 MeshBytesBeforeFinalize = 0;
+};
+
+// Buildings from plain boxes up to panels with windows and framing on every side
+static TArray<FDynamicBuildingRecipe> MakeSampleRecipes()
+{
+	TArray<FDynamicBuildingRecipe> Recipes;
+
+	FDynamicBuildingRecipe& Plain = Recipes.AddDefaulted_GetRef();
+	Plain.RandomSeed = 1;
+	Plain.BoxOptions.bHasFraming = false;
+
+	FDynamicBuildingRecipe& Framed = Recipes.AddDefaulted_GetRef();
+	Framed.RandomSeed = 2;
+
+	FDynamicBuildingRecipe& Panels = Recipes.AddDefaulted_GetRef();
+	Panels.RandomSeed = 3;
+	Panels.PanelOptions.bPanelNorth = true;
+	Panels.PanelOptions.bPanelEast = true;
+	Panels.PanelOptions.bPanelSouth = true;
+	Panels.PanelOptions.bPanelWest = true;
+	Panels.PanelOptions.bPanelRoof = true;
+	Panels.PanelOptions.WindowDepth = 20.f;
+
+	FDynamicBuildingRecipe& Instanced = Recipes.Add_GetRef(Panels);
+	Instanced.RandomSeed = 4;
+	Instanced.DetailOutput = EBuildingDetailOutput::Instanced;
+
+	FDynamicBuildingRecipe& Tall = Recipes.Add_GetRef(Panels);
+	Tall.RandomSeed = 5;
+	Tall.BuildingSize = FVector(10000, 10000, 40000);
+	Tall.BoxOptions.bVaryBoxSizePercent = true;
+	Tall.BoxOptions.VarySizePercent = FVector2D(20);
+
+	return Recipes;
+}
+
+static FString MakeCsvReport(const TArray<FBuildingGenerateResult>& Results)
+{
+	FString Csv = TEXT("Recipe,Seed,Iteration,WallMs");
+	for (int32 Stage = 0; Stage < NUM_STAGES; Stage++) {
+		Csv += FString::Printf(TEXT(",%sMs"), FBuildingGenerationStats::GetStageName(static_cast<EBuildingGenerationStage>(Stage)));
+	}
+	for (int32 Stage = 0; Stage < NUM_STAGES; Stage++) {
+		Csv += FString::Printf(TEXT(",%sCpuMs"), FBuildingGenerationStats::GetStageName(static_cast<EBuildingGenerationStage>(Stage)));
+	}
+	Csv += TEXT(",Triangles,Vertices,MeshKB,Instances,UsedDeltaMB,ProcessPeakUsedMB,MeshRequests,MeshesAllocated,PeakMeshesInUse,VerticesBeforeFinalize,TrianglesBeforeFinalize,MeshKBBeforeFinalize\n");
+
+	for (const FBuildingGenerateResult& Result : Results) {
+		Csv += FString::Printf(TEXT("%i,%i,%i,%.3f"), Result.RecipeIndex, Result.Seed, Result.Iteration, Result.WallMs);
+		for (int32 Stage = 0; Stage < NUM_STAGES; Stage++) {
+			Csv += FString::Printf(TEXT(",%.3f"), Result.StageMs[Stage]);
+		}
+		for (int32 Stage = 0; Stage < NUM_STAGES; Stage++) {
+			Csv += FString::Printf(TEXT(",%.3f"), Result.StageCpuMs[Stage]);
+		}
+		Csv += FString::Printf(TEXT(",%i,%i,%.1f,%i,%.1f,%.1f,%i,%i,%i,%i,%i,%.1f\n"), Result.NumTriangles, Result.NumVertices, Result.MeshBytes / 1024.0,
+			Result.NumInstances, Result.UsedPhysicalDelta / (1024.0 * 1024.0), Result.ProcessPeakUsedPhysical / (1024.0 * 1024.0), Result.NumMeshRequests, Result.NumMeshesAllocated,
+			Result.PeakMeshesInUse, Result.NumVerticesBeforeFinalize, Result.NumTrianglesBeforeFinalize, Result.MeshBytesBeforeFinalize / 1024.0);
+	}
+	return Csv;
+}
+
+static FString MakeJsonReport(const TArray<FBuildingGenerateResult>& Results)
+{
+	TArray<TSharedPtr<FJsonValue>> Rows;
+	for (const FBuildingGenerateResult& Result : Results) {
+		TSharedRef<FJsonObject> Row = MakeShared<FJsonObject>();
+		Row->SetNumberField(TEXT("Recipe"), Result.RecipeIndex);
+		Row->SetNumberField(TEXT("Seed"), Result.Seed);
+		Row->SetNumberField(TEXT("Iteration"), Result.Iteration);
+		Row->SetNumberField(TEXT("WallMs"), Result.WallMs);
+
+		TSharedRef<FJsonObject> Stages = MakeShared<FJsonObject>();
+		TSharedRef<FJsonObject> CpuStages = MakeShared<FJsonObject>();
+		for (int32 Stage = 0; Stage < NUM_STAGES; Stage++) {
+			const TCHAR* StageName = FBuildingGenerationStats::GetStageName(static_cast<EBuildingGenerationStage>(Stage));
+			Stages->SetNumberField(StageName, Result.StageMs[Stage]);
+			CpuStages->SetNumberField(StageName, Result.StageCpuMs[Stage]);
+		}
+		Row->SetObjectField(TEXT("StageMs"), Stages);
+		Row->SetObjectField(TEXT("StageCpuMs"), CpuStages);
+		Row->SetNumberField(TEXT("Triangles"), Result.NumTriangles);
+		Row->SetNumberField(TEXT("Vertices"), Result.NumVertices);
+		Row->SetNumberField(TEXT("MeshKB"), Result.MeshBytes / 1024.0);
+		Row->SetNumberField(TEXT("Instances"), Result.NumInstances);
+		Row->SetNumberField(TEXT("UsedDeltaMB"), Result.UsedPhysicalDelta / (1024.0 * 1024.0));
+		Row->SetNumberField(TEXT("ProcessPeakUsedMB"), Result.ProcessPeakUsedPhysical / (1024.0 * 1024.0));
+		Row->SetNumberField(TEXT("MeshRequests"), Result.NumMeshRequests);
+		Row->SetNumberField(TEXT("MeshesAllocated"), Result.NumMeshesAllocated);
+		Row->SetNumberField(TEXT("PeakMeshesInUse"), Result.PeakMeshesInUse);
+		Row->SetNumberField(TEXT("VerticesBeforeFinalize"), Result.NumVerticesBeforeFinalize);
+		Row->SetNumberField(TEXT("TrianglesBeforeFinalize"), Result.NumTrianglesBeforeFinalize);
+		Row->SetNumberField(TEXT("MeshKBBeforeFinalize"), Result.MeshBytesBeforeFinalize / 1024.0);
+		Rows.Add(MakeShared<FJsonValueObject>(Row));
+	}
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Rows, Writer);
+	return Json;
+}
+
+UBuildingGenerateCommandlet::UBuildingGenerateCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UBuildingGenerateCommandlet::Main(const FString& Params)
+{
+	FString RecipesFile;
+	FString ReportFile = FPaths::ProjectSavedDir() / TEXT("BuildingGenerate.csv");
+	int32 NumIterations = 1;
+	int32 LOD = 0;
+	FParse::Value(*Params, TEXT("recipes="), RecipesFile);
+	FParse::Value(*Params, TEXT("report="), ReportFile);
+	FParse::Value(*Params, TEXT("iterations="), NumIterations);
+	FParse::Value(*Params, TEXT("lod="), LOD);
+	const bool bSerial = FParse::Param(*Params, TEXT("serial"));
+	const bool bWarmCache = FParse::Param(*Params, TEXT("warmcache"));
+	NumIterations = FMath::Max(NumIterations, 1);
+
+	// ================ RECIPES ===================
+	TArray<FDynamicBuildingRecipe> Recipes;
+	if (RecipesFile.IsEmpty()) {
+		Recipes = MakeSampleRecipes();
+	}
+	else {
+		FString JsonString;
+		if (!FFileHelper::LoadFileToString(JsonString, *RecipesFile)) {
+			UE_LOG(LogBuildingGeneration, Error, TEXT("BuildingGenerate - can't read %s"), *RecipesFile);
+			return 1;
+		}
+		if (!FJsonObjectConverter::JsonArrayStringToUStruct(JsonString, &Recipes, 0, 0)) {
+			UE_LOG(LogBuildingGeneration, Error, TEXT("BuildingGenerate - %s isn't a json array of FDynamicBuildingRecipe"), *RecipesFile);
+			return 1;
+		}
+	}
+	UE_LOG(LogBuildingGeneration, Display, TEXT("BuildingGenerate - %i recipes, %i iterations, LOD %i%s"), Recipes.Num(), NumIterations, LOD, bSerial ? TEXT(", single thread") : TEXT(""));
+
+	IConsoleVariable* ParallelVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Building.Generator.Parallel"));
+	const bool bWasParallel = ParallelVar != nullptr && ParallelVar->GetBool();
+	if (bSerial && ParallelVar != nullptr) {
+		ParallelVar->Set(false);
+	}
+
+	// ================ GENERATE ===================
+	TArray<FBuildingGenerateResult> Results;
+	for (int32 RecipeIndex = 0; RecipeIndex < Recipes.Num(); RecipeIndex++) {
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++) {
+			if (!bWarmCache) {
+				FPanelMeshCache::Get().Empty();
+				FLatticeMeshCache::Get().Empty();
+			}
+
+			// the generator takes a mutable recipe, copy it so every run starts from the loaded one
+			FDynamicBuildingRecipe Recipe = Recipes[RecipeIndex];
+			UDynamicMesh* Mesh = NewObject<UDynamicMesh>();
+			TArray<UMaterialInterface*> Materials;
+			FBuildingInstances Instances;
+			FBuildingGenerationStats Stats;
+
+			BuildingGenerator Generator = BuildingGenerator(&Recipe);
+			Generator.SetLOD(LOD);
+			Generator.SetStats(&Stats);
+			const uint64 UsedBefore = FPlatformMemory::GetStats().UsedPhysical;
+			const double Start = FPlatformTime::Seconds();
+			Generator.Generate(Mesh, Materials, &Instances);
+			const double End = FPlatformTime::Seconds();
+			const FPlatformMemoryStats MemoryAfter = FPlatformMemory::GetStats();
+
+			FBuildingGenerateResult& Result = Results.AddDefaulted_GetRef();
+			Result.WallMs = (End - Start) * 1000.0;
+			Result.RecipeIndex = RecipeIndex;
+			Result.Seed = Recipe.RandomSeed;
+			Result.Iteration = Iteration;
+			for (int32 Stage = 0; Stage < NUM_STAGES; Stage++) {
+				Result.StageMs[Stage] = Stats.GetStageMs(static_cast<EBuildingGenerationStage>(Stage));
+				Result.StageCpuMs[Stage] = Stats.GetStageCpuMs(static_cast<EBuildingGenerationStage>(Stage));
+			}
+			Mesh->ProcessMesh([&Result](const UE::Geometry::FDynamicMesh3& ReadMesh)
+			{
+				Result.NumTriangles = ReadMesh.TriangleCount();
+				Result.NumVertices = ReadMesh.VertexCount();
+				Result.MeshBytes = FPanelMeshCache::EstimateMeshBytes(ReadMesh);
+			});
+			Result.NumInstances = Instances.Num();
+			Result.UsedPhysicalDelta = static_cast<int64>(MemoryAfter.UsedPhysical) - static_cast<int64>(UsedBefore);
+			Result.ProcessPeakUsedPhysical = MemoryAfter.PeakUsedPhysical;
+			Result.NumMeshRequests = Stats.NumMeshRequests;
+			Result.NumMeshesAllocated = Stats.NumMeshesAllocated;
+			Result.PeakMeshesInUse = Stats.PeakMeshesInUse;
+			Result.NumVerticesBeforeFinalize = Stats.NumVerticesBeforeFinalize;
+			Result.NumTrianglesBeforeFinalize = Stats.NumTrianglesBeforeFinalize;
+			Result.MeshBytesBeforeFinalize = Stats.MeshBytesBeforeFinalize;
+
+			UE_LOG(LogBuildingGeneration, Display, TEXT("BuildingGenerate - recipe %i (seed %i) iteration %i: %.2f ms, %i tris, %i verts, %i instances, used %+.1f MB, %i of %i meshes allocated"),
+				RecipeIndex, Result.Seed, Iteration, Result.WallMs, Result.NumTriangles, Result.NumVertices, Result.NumInstances,
+				Result.UsedPhysicalDelta / (1024.0 * 1024.0), Result.NumMeshesAllocated, Result.NumMeshRequests);
+
+			// the generator's scratch meshes aren't referenced anymore
+			CollectGarbage(RF_NoFlags);
+		}
+	}
+
+	if (ParallelVar != nullptr) {
+		ParallelVar->Set(bWasParallel);
+	}
+
+	// ================ REPORT ===================
+	const bool bJson = ReportFile.EndsWith(TEXT(".json"));
+	const FString Report = bJson ? MakeJsonReport(Results) : MakeCsvReport(Results);
+	if (!FFileHelper::SaveStringToFile(Report, *ReportFile)) {
+		UE_LOG(LogBuildingGeneration, Error, TEXT("BuildingGenerate - can't write %s"), *ReportFile);
+		return 1;
+	}
+	UE_LOG(LogBuildingGeneration, Display, TEXT("BuildingGenerate - report written to %s"), *ReportFile);
+	return 0;
+}
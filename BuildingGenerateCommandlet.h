@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BuildingGenerateCommandlet.generated.h"
+
+/**
+ * Generates buildings without the editor UI and writes a timing report, eg. on a build machine without a GPU.
+ *
+ * Every recipe runs the same pipeline as ADynamicBuilding::Generate (without a fragment cache, and with empty panel
+ * and lattice caches unless -warmcache is given) and is reported with the wall and CPU time of each stage (see
+ * FBuildingGenerationStats), its triangle and vertex counts, its scratch meshes (see FBuildingMeshPool), the physical
+ * memory the process used more after it than before it, and the peak memory of the whole process so far.
+ *
+ * Recipes are a json array of FDynamicBuildingRecipe objects, without -recipes a set of sample recipes is generated.
+ * The report is a csv file, or json if the file name ends in .json.
+ *
+ * HOWTO:
+ *	UnrealEditor-Cmd Project.uproject -run=BuildingGenerate -nullrhi -recipes=Recipes.json -report=Report.csv
+ *	  -iterations=N   generate each recipe N times (default 1)
+ *	  -lod=N          generate LOD N (default 0)
+ *	  -serial         build on a single thread, the stage times then add up to the generation's wall time
+ *	  -warmcache      keep the panel and lattice caches between runs
+ */
+UCLASS()
+class PROCEDURALBUILDINGS_API UBuildingGenerateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBuildingGenerateCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
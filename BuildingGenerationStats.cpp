@@ -0,0 +1,162 @@
+#include "BuildingGenerationStats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Misc/ScopeLock.h"
+
+FBuildingGenerationStats::FBuildingGenerationStats()
+{
+	Reset();
+}
+
+void FBuildingGenerationStats::Reset()
+{
+	for (std::atomic<uint64>& Cycles : StageCpuCycles) {
+		Cycles = 0;
+	}
+	{
+		FScopeLock ScopeLock(&WallLock);
+		for (int32 Stage = 0; Stage < static_cast<int32>(EBuildingGenerationStage::Num); Stage++) {
+			StageWallCycles[Stage] = 0;
+			StageActiveSince[Stage] = 0;
+			StageNumActive[Stage] = 0;
+		}
+	}
+	NumMeshRequests = 0;
+	NumMeshesAllocated = 0;
+	PeakMeshesInUse = 0;
+	NumVerticesBeforeFinalize = 0;
+	NumTrianglesBeforeFinalize = 0;
+	MeshBytesBeforeFinalize = 0;
+	NumVerticesAfterFinalize = 0;
+	NumTrianglesAfterFinalize = 0;
+	MeshBytesAfterFinalize = 0;
+}
+
+void FBuildingGenerationStats::BeginStage(EBuildingGenerationStage Stage, uint64 Cycles)
+{
+	if (Stage >= EBuildingGenerationStage::Num) {
+		return;
+	}
+	const int32 Index = static_cast<int32>(Stage);
+	FScopeLock ScopeLock(&WallLock);
+	if (StageNumActive[Index]++ == 0) {
+		StageActiveSince[Index] = Cycles;
+	}
+}
+
+void FBuildingGenerationStats::EndStage(EBuildingGenerationStage Stage, uint64 StartCycles, uint64 Cycles)
+{
+	if (Stage >= EBuildingGenerationStage::Num) {
+		return;
+	}
+	const int32 Index = static_cast<int32>(Stage);
+	StageCpuCycles[Index] += Cycles - StartCycles;
+
+	FScopeLock ScopeLock(&WallLock);
+	if (StageNumActive[Index] > 0 && --StageNumActive[Index] == 0) {
+		StageWallCycles[Index] += Cycles - StageActiveSince[Index];
+	}
+}
+
+double FBuildingGenerationStats::GetStageMs(EBuildingGenerationStage Stage) const
+{
+	if (Stage >= EBuildingGenerationStage::Num) {
+		return 0.0;
+	}
+	FScopeLock ScopeLock(&WallLock);
+	return FPlatformTime::ToMilliseconds64(StageWallCycles[static_cast<int32>(Stage)]);
+}
+
+double FBuildingGenerationStats::GetStageCpuMs(EBuildingGenerationStage Stage) const
+{
+	if (Stage >= EBuildingGenerationStage::Num) {
+		return 0.0;
+	}
+	return FPlatformTime::ToMilliseconds64(StageCpuCycles[static_cast<int32>(Stage)]);
+}
+
+double FBuildingGenerationStats::GetTotalCpuMs() const
+{
+	double TotalMs = 0.0;
+	for (int32 Stage = 0; Stage < static_cast<int32>(EBuildingGenerationStage::Num); Stage++) {
+		TotalMs += GetStageCpuMs(static_cast<EBuildingGenerationStage>(Stage));
+	}
+	return TotalMs;
+}
+
+const TCHAR* FBuildingGenerationStats::GetStageName(EBuildingGenerationStage Stage)
+{
+	switch (Stage) {
+	case EBuildingGenerationStage::Core:
+		return TEXT("Core");
+	case EBuildingGenerationStage::Boxes:
+		return TEXT("Boxes");
+	case EBuildingGenerationStage::Panels:
+		return TEXT("Panels");
+	case EBuildingGenerationStage::Booleans:
+		return TEXT("Booleans");
+	case EBuildingGenerationStage::Lattice:
+		return TEXT("Lattice");
+	case EBuildingGenerationStage::Materials:
+		return TEXT("Materials");
+	case EBuildingGenerationStage::Merge:
+		return TEXT("Merge");
+	case EBuildingGenerationStage::Finalize:
+		return TEXT("Finalize");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+FBuildingStageTimer::FBuildingStageTimer(FBuildingGenerationStats* InStats, EBuildingGenerationStage InStage)
+	: Stats(InStats)
+	, Stage(InStage)
+	, StartCycles(InStats != nullptr ? FPlatformTime::Cycles64() : 0)
+{
+	if (Stats != nullptr) {
+		Stats->BeginStage(Stage, StartCycles);
+	}
+	BeginTraceEvent();
+}
+
+FBuildingStageTimer::~FBuildingStageTimer()
+{
+	Pause();
+}
+
+void FBuildingStageTimer::Switch(EBuildingGenerationStage InStage)
+{
+	EndTraceEvent();
+	if (Stats != nullptr) {
+		const uint64 Now = FPlatformTime::Cycles64();
+		Stats->EndStage(Stage, StartCycles, Now);
+		Stats->BeginStage(InStage, Now);
+		StartCycles = Now;
+	}
+	Stage = InStage;
+	BeginTraceEvent();
+}
+
+void FBuildingStageTimer::Pause()
+{
+	Switch(EBuildingGenerationStage::Num);
+}
+
+void FBuildingStageTimer::BeginTraceEvent()
+{
+#if CPUPROFILERTRACE_ENABLED
+	if (Stage < EBuildingGenerationStage::Num && UE_TRACE_CHANNELEXPR_IS_ENABLED(CpuChannel)) {
+		FCpuProfilerTrace::OutputBeginDynamicEvent(FBuildingGenerationStats::GetStageName(Stage));
+		bTraceEventOpen = true;
+	}
+#endif
+}
+
+void FBuildingStageTimer::EndTraceEvent()
+{
+#if CPUPROFILERTRACE_ENABLED
+	if (bTraceEventOpen) {
+		FCpuProfilerTrace::OutputEndEvent();
+		bTraceEventOpen = false;
+	}
+#endif
+}
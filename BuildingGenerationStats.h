@@ -0,0 +1,107 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+// Stages of the building pipeline, every stage is timed separately (see FBuildingGenerationStats)
+enum class EBuildingGenerationStage : uint8
+{
+	Core,		// the building core box
+	Boxes,		// box layout, floor, box and roof geometry
+	Panels,		// side panel slabs and their placement
+	Booleans,	// window cut-outs (analytic or mesh boolean) and instanced window layout
+	Lattice,	// lattice layout, geometry and materials
+	Materials,	// material ids and uvs of the core and boxes
+	Merge,		// collecting panels into boxes and boxes into the building
+	Finalize,	// welding and compacting the finished mesh
+	Num
+};
+
+/**
+ * Time spent in each stage of a generation. A worker charges its time to one stage at a time, and every stage has two
+ * times: the wall time, while at least one thread was working on the stage, and the CPU time, summed over every thread
+ * that worked on it. Boxes and panels are built concurrently, so the wall times of their stages overlap and the CPU
+ * times add up to more than the generation took. With `Building.Generator.Parallel 0` both are the same and add up to
+ * the wall time of the generation.
+ *
+ * HOWTO:
+ *	FBuildingGenerationStats Stats;
+ *	Generator.SetStats(&Stats);
+ *	Generator.Generate(Mesh, MaterialSet);
+ *	Stats.GetStageMs(EBuildingGenerationStage::Booleans);
+ */
+struct PROCEDURALBUILDINGS_API FBuildingGenerationStats
+{
+	FBuildingGenerationStats();
+
+	std::atomic<uint64> StageCpuCycles[static_cast<int32>(EBuildingGenerationStage::Num)];
+
+	// Scratch meshes of the generation (see FBuildingMeshPool): meshes asked for, meshes actually allocated and the
+	// most in use at one time
+	int32 NumMeshRequests = 0;
+	int32 NumMeshesAllocated = 0;
+	int32 PeakMeshesInUse = 0;
+
+	// Size of the building mesh before and after the finalize stage (see `bFinalizeMesh`), the same if it didn't run
+	int32 NumVerticesBeforeFinalize = 0;
+	int32 NumTrianglesBeforeFinalize = 0;
+	int64 MeshBytesBeforeFinalize = 0;
+	int32 NumVerticesAfterFinalize = 0;
+	int32 NumTrianglesAfterFinalize = 0;
+	int64 MeshBytesAfterFinalize = 0;
+
+	void Reset();
+
+	// A thread started working on `Stage` at `Cycles`, see FBuildingStageTimer
+	void BeginStage(EBuildingGenerationStage Stage, uint64 Cycles);
+
+	// A thread stopped working on `Stage` at `Cycles`, it started at `StartCycles`
+	void EndStage(EBuildingGenerationStage Stage, uint64 StartCycles, uint64 Cycles);
+
+	// Wall time of a stage, from the first thread starting work on it to the last one stopping (gaps excluded)
+	double GetStageMs(EBuildingGenerationStage Stage) const;
+
+	// CPU time of a stage, summed over every thread
+	double GetStageCpuMs(EBuildingGenerationStage Stage) const;
+
+	// CPU time of every stage
+	double GetTotalCpuMs() const;
+
+	static const TCHAR* GetStageName(EBuildingGenerationStage Stage);
+
+private:
+	// the wall time of a stage runs while it has threads working on it
+	mutable FCriticalSection WallLock;
+	uint64 StageWallCycles[static_cast<int32>(EBuildingGenerationStage::Num)];
+	uint64 StageActiveSince[static_cast<int32>(EBuildingGenerationStage::Num)];
+	int32 StageNumActive[static_cast<int32>(EBuildingGenerationStage::Num)];
+};
+
+/**
+ * Charges the time between construction (or the last `Switch`) and destruction to a stage of `Stats`, and wraps the
+ * stage in a CPU trace event so the stages show up in Unreal Insights.
+ * Only traces if `Stats` is nullptr, so the generator can always time itself.
+ */
+class PROCEDURALBUILDINGS_API FBuildingStageTimer
+{
+public:
+	FBuildingStageTimer(FBuildingGenerationStats* InStats, EBuildingGenerationStage InStage);
+	~FBuildingStageTimer();
+
+	// Charge the time so far to the current stage and start timing `InStage`
+	void Switch(EBuildingGenerationStage InStage);
+
+	// Charge the time so far to the current stage and stop timing until the next `Switch`, eg. while waiting on other
+	// workers that time themselves
+	void Pause();
+
+private:
+	FBuildingGenerationStats* Stats;
+	EBuildingGenerationStage Stage;
+	uint64 StartCycles;
+	bool bTraceEventOpen = false;
+
+	void BeginTraceEvent();
+	void EndTraceEvent();
+};
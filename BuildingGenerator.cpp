@@ -0,0 +1,1106 @@
+#include "BuildingGenerator.h"
+#include <functional> // std::hash
+#include <string>
+#include "BuildingEnums.h"
+#include "GeometryScript/MeshPrimitiveFunctions.h"
+#include "GeometryScript/MeshBasicEditFunctions.h"
+#include "GeometryScript/MeshTransformFunctions.h"
+#include "GeometryScript/MeshQueryFunctions.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h" // FDynamicMeshMaterialAttribute
+#include "DynamicMesh/DynamicMesh3.h"
+#include "UDynamicMesh.h"
+#include "DynamicBox.h"
+#include "BooleanGrid.h"
+#include "LatticeGrid.h"
+#include "UVUtilities.h"
+#include "FaceClassMaterials.h"
+#include "Hash/CityHash.h"
+#include "PanelMeshCache.h"
+#include "BuildingRandom.h"
+#include "BuildingStats.h"
+#include "BuildingMeshPool.h"
+#include "LatticeMeshCache.h"
+#include "Operations/MergeCoincidentMeshEdges.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include <atomic>
+
+static TAutoConsoleVariable<bool> CVarBuildingParallel(
+	TEXT("Building.Generator.Parallel"),
+	true,
+	TEXT("Build the boxes and side panels of a building concurrently. The output is identical either way."),
+	ECVF_Default);
+
+// FDynamicBox writes into the FDynamicMesh3 directly, no UObject is created per floor, roof or panel
+static void AppendDynamicBox(UDynamicMesh* Mesh, const FDynamicBox& Box)
+{
+	Mesh->EditMesh([&](FDynamicMesh3& EditMesh)
+	{
+		Box.GenerateMesh(EditMesh);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
+}
+
+static EParallelForFlags GetParallelForFlags()
+{
+	return CVarBuildingParallel.GetValueOnAnyThread() ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+}
+
+// Scratch meshes a box holds at once: box, floor, roof, panels and fragment, then a mesh and a window boolean tool
+// per side panel (the lattice needs fewer)
+static const int32 SCRATCH_MESHES_PER_BOX = 13;
+
+BuildingGenerator::BuildingGenerator()
+	: Recipe(nullptr)
+{
+}
+
+BuildingGenerator::BuildingGenerator(FDynamicBuildingRecipe* Recipe)
+	: Recipe(Recipe)
+{
+}
+
+void BuildingGenerator::SetCancelCallback(TFunction<bool()> InShouldCancel)
+{
+	ShouldCancel = MoveTemp(InShouldCancel);
+}
+
+bool BuildingGenerator::IsCancelled() const
+{
+	return ShouldCancel && ShouldCancel();
+}
+
+void BuildingGenerator::SetLOD(int32 InLOD)
+{
+	LOD = FMath::Clamp(InLOD, 0, MAX_LODS - 1);
+}
+
+void BuildingGenerator::SetStats(FBuildingGenerationStats* InStats)
+{
+	Stats = InStats;
+}
+
+void BuildingGenerator::SetMeshPool(FBuildingMeshPool* InMeshPool)
+{
+	MeshPool = InMeshPool;
+}
+
+int32 BuildingGenerator::GetNumScratchMeshes(int32 NumBoxes)
+{
+	const int32 NumConcurrentBoxes = CVarBuildingParallel.GetValueOnAnyThread() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1;
+	// plus the two meshes the boxes are merged with
+	return FMath::Min(NumBoxes, NumConcurrentBoxes) * SCRATCH_MESHES_PER_BOX + 2;
+}
+
+bool BuildingGenerator::IsInstancedOutput() const
+{
+	return LOD == 0 && Recipe->DetailOutput == EBuildingDetailOutput::Instanced;
+}
+
+bool BuildingGenerator::IsBoxBooleanCut() const
+{
+	// LOD > 0 panels have no windows and instanced windows aren't cut
+	const FDynamicBuildingPanelOptions& mPanelOptions = Recipe->PanelOptions;
+	const bool bInstanceWindows = IsInstancedOutput() && mPanelOptions.WindowBoolMode == EGeometryScriptBooleanOperation::Subtract;
+	return LOD == 0 && !bInstanceWindows && mPanelOptions.WindowCutMode == EBuildingCutMode::BoxBoolean;
+}
+
+EDynamicBoxFaces BuildingGenerator::GetHiddenBoxFaces() const
+{
+	FDynamicBuildingPanelOptions& mPanelOptions = Recipe->PanelOptions;
+	if (!mPanelOptions.bCullHiddenFaces) {
+		return EDynamicBoxFaces::None;
+	}
+
+	// panels without holes: uncut (coarser LODs and instanced windows), windows added onto the panel, or windows that stop short of the back
+	const bool bUncutPanels = LOD > 0 || (IsInstancedOutput() && mPanelOptions.WindowBoolMode == EGeometryScriptBooleanOperation::Subtract);
+	const bool bBlindWindows = mPanelOptions.WindowBoolMode == EGeometryScriptBooleanOperation::Subtract
+		&& mPanelOptions.WindowDepth > 0.f && mPanelOptions.WindowDepth + 1.f < mPanelOptions.Thickness; // see BooleanGrid, a depth of 0 cuts through
+	const bool bUnionWindows = mPanelOptions.WindowBoolMode == EGeometryScriptBooleanOperation::Union;
+	if (!bUncutPanels && !bBlindWindows && !bUnionWindows) {
+		return EDynamicBoxFaces::None;
+	}
+
+	EDynamicBoxFaces HiddenFaces = EDynamicBoxFaces::None;
+	const TSet<FVector> SidePanelVectors = mPanelOptions.GetSidePanelVectors();
+	// the side panels reach up to the roof and down to the floor, with all four the top and bottom gaps are closed
+	if (SidePanelVectors.Num() == 4) {
+		if (mPanelOptions.bPanelRoof) {
+			HiddenFaces |= EDynamicBoxFaces::Top;
+		}
+		if (mPanelOptions.bPanelFloor) {
+			HiddenFaces |= EDynamicBoxFaces::Bottom;
+		}
+	}
+	// a side is closed in by its panel, the panels on either side of it, the roof and the floor
+	if (mPanelOptions.bPanelRoof && mPanelOptions.bPanelFloor) {
+		for (const FVector& Face : SidePanelVectors) {
+			if (mPanelOptions.HasPanelToLeft(Face) && mPanelOptions.HasPanelToRight(Face)) {
+				HiddenFaces |= FDynamicBox::GetFaceForDirection(Face);
+			}
+		}
+	}
+	return HiddenFaces;
+}
+
+FBuildingLayout BuildingGenerator::MakeLayout() const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BuildingGenerator::MakeLayout);
+	FBuildingLayout Layout;
+	if (Recipe == nullptr) {
+		return Layout;
+	}
+	const int32 RandomSeed = Recipe->RandomSeed;
+	const FVector& mBuildingSize = Recipe->BuildingSize;
+	FDynamicBuildingGenericBoxOptions& mBoxOptions = Recipe->BoxOptions;
+
+	const float FloorHeight = mBoxOptions.FloorHeight;
+	const float VerticalSpacing = mBoxOptions.VerticalSpacing;
+	const int32 BuildingXSize = mBuildingSize.X;
+	const int32 BuildingYSize = mBuildingSize.Y;
+	const int32 BuildingHeight = mBuildingSize.Z;
+	
+	const TRange<int32> NumFloorsRange = TRange<int32>::Inclusive(
+		FMath::Max(mBoxOptions.NumFloors, 1),
+		mBoxOptions.NumFloorsVariance + FMath::Max(mBoxOptions.NumFloors, 1)
+	);
+
+	
+	FVector2D BoxScale = FVector2D(mBoxOptions.Scale.X * 0.01, mBoxOptions.Scale.Y * 0.01);
+	FVector2D BoxVarySize = mBoxOptions.VarySizePercent * 0.01;
+
+	FVector2D BoxBaseSize = FVector2D(BuildingXSize * BoxScale.X, BuildingYSize * BoxScale.Y);
+
+	const TRange<int32> BoxSizeXRange = TRange<int32>::Inclusive(
+		FMath::Max(BoxBaseSize.X, 1),
+		FMath::Max(BoxBaseSize.X + (BoxBaseSize.X * BoxVarySize.X), 1)
+	);
+
+	const TRange<int32> BoxSizeYRange = TRange<int32>::Inclusive(
+		FMath::Max(BoxBaseSize.Y, 1),
+		FMath::Max(BoxBaseSize.Y + (BoxBaseSize.Y * BoxVarySize.Y), 1)
+	);
+
+	const TRange<int32> BoxHeightRange = TRange<int32>::Inclusive(
+		NumFloorsRange.GetLowerBoundValue() * FloorHeight, 
+		NumFloorsRange.GetUpperBoundValue() * FloorHeight
+	);
+
+	int32 MaxNumBoxes = 1;
+	int32 UsableBuildingHeight = BuildingHeight;
+	if (mBoxOptions.bExplicitNumberOfBoxes) {
+		MaxNumBoxes = mBoxOptions.NumberOfBoxes;
+	} 
+	else if (mBoxOptions.bSpecifyVerticalSpawnRange) {
+		UsableBuildingHeight = (mBoxOptions.VerticalSpawnPercent * 0.01) * BuildingHeight;
+		MaxNumBoxes = FMath::Max(UsableBuildingHeight / BoxHeightRange.GetUpperBoundValue(), 1);
+	}
+	else {
+		MaxNumBoxes = FMath::Max(BuildingHeight / BoxHeightRange.GetUpperBoundValue(), 1);
+	}
+
+	UE_LOG(LogBuildingGeneration, Verbose, TEXT("GenerateBoxes - MaxNumBoxes = %i"), MaxNumBoxes);
+
+// TODO consider mirror, repeat, vertical alignment, vertical spawn percent.
+// TODO horizontal alignment, offset
+// TODO switch percents to be meters
+// TODO panels need a control-arm holding them to the building
+// TODO switch the building itself to be composed of meshes - one big mesh creates intersections, and other problems.
+// TODO consider new settings min-building-core-size, building-core-shrinks-with-floors
+// TODO add material channels
+// TODO refactor roof logic
+// TODO create Templated Container for repition modes
+//   
+
+	double CumulativeBoxHeight = 0.f;
+
+	// everything but a box's resolved size, floors and seed is shared by all boxes, hash it once.
+	const uint64 BoxOptionsHash = GetBoxOptionsHash();
+
+	// ================ BOX LAYOUT ===================
+	// Each box draws its size, floors and rotation from its own stream, so boxes don't depend on each other
+	Layout.MaxNumBoxes = MaxNumBoxes;
+	Layout.UsableHeight = UsableBuildingHeight;
+	Layout.Boxes.Reserve(MaxNumBoxes);
+	for (int32 BoxNum = 0; BoxNum < MaxNumBoxes; BoxNum++) {
+		FBuildingBoxLayout Box;
+		Box.BoxNum = BoxNum;
+		const FBuildingRandom BoxRandom = GetBoxRandom(BoxNum, EBuildingRandomStage::BoxLayout);
+
+		// ================ BOX SIZE / NUM FLOORS ===================
+		FVector BoxSizeActual = FVector::Zero(); // holds the calculated size of the box after modifiers like scaling variation and randomness have been applied
+		int NumFloors = mBoxOptions.NumFloors;
+		if (mBoxOptions.NumFloorsVariance > 0) {
+			NumFloors = BoxRandom.RandRange(NumFloorsRange.GetLowerBoundValue(), NumFloorsRange.GetUpperBoundValue(), 0);
+			BoxSizeActual.Z = FloorHeight * NumFloors;
+		}
+		else {
+			BoxSizeActual.Z = BoxHeightRange.GetUpperBoundValue();
+		}
+
+		// vary the box size by percent
+		if (mBoxOptions.bVaryBoxSizePercent) {
+			BoxSizeActual.X = BoxRandom.FRandRange(BoxSizeXRange.GetLowerBoundValue(), BoxSizeXRange.GetUpperBoundValue(), 1);
+			BoxSizeActual.Y = BoxRandom.FRandRange(BoxSizeYRange.GetLowerBoundValue(), BoxSizeYRange.GetUpperBoundValue(), 2);
+		}
+		else {
+			BoxSizeActual.X = BoxBaseSize.X;
+			BoxSizeActual.Y = BoxBaseSize.Y;
+		}
+
+		// Current Box Rotation
+		FRotator BoxRotation = FRotator::ZeroRotator;
+		if (mBoxOptions.ZRotation != 0.f) {
+			if (mBoxOptions.RotationRandomizeInIncrements) {
+				float RotMultiplier = 360.f / mBoxOptions.ZRotation;
+				float RandMultiplier = BoxRandom.RandRange(1, RotMultiplier, 3);
+				BoxRotation.Yaw = RandMultiplier * mBoxOptions.ZRotation;
+			}
+			else if (mBoxOptions.RotationRandomizeFromSet.Num()) {
+				TSet<float>& RandSet = mBoxOptions.RotationRandomizeFromSet;
+				int32 RandIndex = BoxRandom.FRandRange(0, RandSet.GetMaxIndex(), 3);
+				BoxRotation.Yaw = RandSet[FSetElementId::FromInteger(RandIndex)];
+			}
+			else {
+				BoxRotation.Yaw = mBoxOptions.ZRotation;
+			}
+		}
+
+		Box.Size = BoxSizeActual;
+		Box.NumFloors = NumFloors;
+		Box.Rotation = BoxRotation;
+		Box.Key = GetBoxFragmentKey(BoxNum, BoxSizeActual, NumFloors, BoxOptionsHash);
+
+		// ================ BOX STACK ===================
+		Box.Z = CumulativeBoxHeight;
+		Box.Height = GetBoxHeight(BoxSizeActual);
+
+		// the current total height of all boxes added together.
+		// this value, is where the next box will spawn.
+		CumulativeBoxHeight += (Box.Height + VerticalSpacing);
+
+		// make sure we aren't exceeding our usable space, a box that doesn't fit is never built
+		if (CumulativeBoxHeight >= UsableBuildingHeight) {
+			UE_LOG(LogBuildingGeneration, Verbose, TEXT("GenerateBoxes - Stopping at Box [%i]  Height: %f Will Exceed Usable Building Height: %i"), BoxNum, CumulativeBoxHeight, BuildingHeight);
+			break;
+		}
+		Layout.Boxes.Add(Box);
+	}
+	// the stack height includes the box that didn't fit, the alignment has always been computed from it
+	Layout.StackHeight = CumulativeBoxHeight;
+
+
+	// ================ VERTICAL ALIGNMENT ===================
+	FVector BoxesOrigin = FVector();
+
+	using VAlign = EBuildingVAlignmentChoices;
+
+	VAlign Alignment = mBoxOptions.VAlignment;
+
+	if (Alignment == VAlign::Random) {
+		TArray<VAlign> RandChoices = { VAlign::Top, VAlign::Middle, VAlign::Bottom };
+
+		//int RandIndex = CombinedSeed % (RandChoices.Num() - 1)
+
+		// hash the internal name of our enum (just needs to be consistent across builds on the same platform)
+		const char* TypeName = typeid(typename EBuildingVAlignmentChoices).name();
+		std::string VAlignString = std::string(TypeName);
+		std::hash<std::string> hasher;
+		size_t VModeSeed = hasher(TypeName);
+		uint32 VAlignSeed = static_cast<uint32>(VModeSeed + RandomSeed);
+		uint32 RandIndex = VAlignSeed % (RandChoices.Num() - 1);
+		Alignment = RandChoices[RandIndex];
+	}
+
+	switch (Alignment) {
+	case EBuildingVAlignmentChoices::Middle:
+		BoxesOrigin.Z = FMath::Max((BuildingHeight - Layout.StackHeight) / 2, 0.0);
+		break;
+	case EBuildingVAlignmentChoices::Top:
+		BoxesOrigin.Z = FMath::Max(BuildingHeight - Layout.StackHeight, 0.0);
+		break; 
+	case EBuildingVAlignmentChoices::Bottom:
+	default:
+		BoxesOrigin.Z = 0;
+	}
+	Layout.BoxesOrigin = BoxesOrigin;
+
+	return Layout;
+}
+
+double BuildingGenerator::GetBoxHeight(const FVector& BoxSize) const
+{
+	// the floor panel sits at the bottom of the box, the roof panel `RoofStandoff` above it (see BuildBoxFragment)
+	FDynamicBuildingPanelOptions& mPanelOptions = Recipe->PanelOptions;
+	const double FloorTop = mPanelOptions.bPanelFloor ? mPanelOptions.GetFloorSizeAndTransform(BoxSize).Size.Z : 0.0;
+	const double BoxTop = FloorTop + BoxSize.Z;
+	if (!mPanelOptions.bPanelRoof) {
+		return BoxTop;
+	}
+	const FSizeAndTransform Roof = mPanelOptions.GetRoofSizeAndTransform(BoxSize);
+	return FMath::Max(BoxTop, BoxTop + Roof.Transform.GetTranslation().Z + Roof.Size.Z);
+}
+
+bool BuildingGenerator::Generate(UDynamicMesh* Mesh, TArray<UMaterialInterface*>& MaterialSet, FBuildingInstances* OutInstances)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BuildingGenerator::Generate);
+	if (Mesh == nullptr) {
+		UE_LOG(LogBuildingGeneration, Error, TEXT("BuildingGenerator Mesh = nullptr"));
+		return false;
+	}
+	if (Recipe == nullptr) {
+		UE_LOG(LogBuildingGeneration, Error, TEXT("BuildingGenerator Recipe = nullptr"));
+		return false;
+	}
+
+	// local aliases for the recipe keep the pipeline code readable.
+	const int32 RandomSeed = Recipe->RandomSeed;
+	const FVector& mBuildingSize = Recipe->BuildingSize;
+	const TMap<EBuildingMaterialSlots, UMaterialInterface*>& MaterialSlots = Recipe->MaterialSlots;
+	const EBuildingUVScaleMode UVScaleMode = Recipe->UVScaleMode;
+	const float UVSize = Recipe->UVSize;
+	const EBuildingUVOriginMode UVOriginMode = Recipe->UVOriginMode;
+	FDynamicBuildingGenericBoxOptions& mBoxOptions = Recipe->BoxOptions;
+	FDynamicBuildingPanelOptions& mPanelOptions = Recipe->PanelOptions;
+
+	FBuildingStageTimer Timer(Stats, EBuildingGenerationStage::Core);
+
+	// every scratch mesh of this generation comes from one pool, unless the caller shares a pool between generations
+	FBuildingMeshPool GenerationMeshPool;
+	TGuardValue<FBuildingMeshPool*> MeshPoolGuard(MeshPool, MeshPool != nullptr ? MeshPool : &GenerationMeshPool);
+
+	// Reset Mesh Geometry...
+	Mesh->Reset();
+
+
+	// Reset material slots
+	MaterialSet.Empty();
+
+	if (OutInstances != nullptr) {
+		OutInstances->Reset();
+	}
+
+	// all seed based randomization is based on FBuildingRandom
+	// this keeps random parts of the generation consistent unless the seed is changed.
+	const FBuildingRandom CoreUVRandom = FBuildingRandom(RandomSeed).Stage(EBuildingRandomStage::CoreUVs);
+
+	FGeometryScriptPrimitiveOptions options = FGeometryScriptPrimitiveOptions();
+	options.bFlipOrientation = false;
+	options.PolygroupMode = EGeometryScriptPrimitivePolygroupMode::PerFace;
+	options.UVMode = EGeometryScriptPrimitiveUVMode::Uniform;
+
+	FVector InEngineUnits = mBuildingSize;
+
+	// Create the building core geometry
+	FDynamicBox CoreBox;
+	CoreBox.SetGeometryOptions(options);
+	CoreBox.SetSize(InEngineUnits);
+	CoreBox.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Base);
+	// the core stands on the ground
+	if (Recipe->PanelOptions.bCullHiddenFaces) {
+		CoreBox.SetHiddenFaces(EDynamicBoxFaces::Bottom);
+		INC_DWORD_STAT(STAT_BuildingFacesCulled);
+	}
+	AppendDynamicBox(Mesh, CoreBox);
+	if (OutInstances != nullptr) {
+		OutInstances->AddCollisionBox(FBox(FVector(-0.5 * InEngineUnits.X, -0.5 * InEngineUnits.Y, 0.0), FVector(0.5 * InEngineUnits.X, 0.5 * InEngineUnits.Y, InEngineUnits.Z)));
+	}
+
+	FBox BuildingBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(Mesh);
+
+	// ============== Mesh MATERIALS ==========================
+	// The box is tagged with its face classes, one pass assigns the material ids and uvs of every slot
+	TArray<FFaceClassMaterialRule> CoreMaterials;
+
+	// ------------- TOP / BOTTOM ----------------------------
+	if (!MaterialSlots.Contains(EBuildingMaterialSlots::All)
+		&& MaterialSlots.Contains(EBuildingMaterialSlots::Top_Bottom)) {
+		// allocate a new material id
+		int32 TopBotMatId = MaterialSet.Num();
+		MaterialSet.Add(MaterialSlots[EBuildingMaterialSlots::Top_Bottom]);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Building MatId[%i] (Top_Bottom)"), TopBotMatId);
+
+		FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BuildingBounds, UVScaleMode, UVOriginMode, CoreUVRandom.Element(0), UVSize);
+		CoreMaterials.Add({ EBuildingFaceClass::TopBottom, INDEX_NONE, TopBotMatId, true, UVTransform });
+	}
+
+	// ------------- SIDES -----------------------------------
+	if (!MaterialSlots.Contains(EBuildingMaterialSlots::All)
+		&& MaterialSlots.Contains(EBuildingMaterialSlots::All_Sides)) {
+		// allocate a new material id
+		int32 SidesMatId = MaterialSet.Num();
+		MaterialSet.Add(MaterialSlots[EBuildingMaterialSlots::All_Sides]);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Building MatId[%i] (All_Sides)"), SidesMatId);
+
+		FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BuildingBounds, UVScaleMode, UVOriginMode, CoreUVRandom.Element(1), UVSize);
+		CoreMaterials.Add({ EBuildingFaceClass::Side, INDEX_NONE, SidesMatId, true, UVTransform });
+	}
+
+	int32 BuildingAllMatId = -1;
+	if (MaterialSlots.Contains(EBuildingMaterialSlots::All)) {
+		BuildingAllMatId = MaterialSet.Num();
+		MaterialSet.Add(MaterialSlots[EBuildingMaterialSlots::All]);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Building MatId[%i] (All)"), BuildingAllMatId);
+	}
+	else if (MaterialSlots.IsEmpty()) {
+		UE_LOG(LogBuildingGeneration, Verbose, TEXT("Building MaterialSlots empty, MaterialID 0 will be applied to mesh as a default"));
+		BuildingAllMatId = 0;
+	}
+
+	// map the rest of the cube
+	if (BuildingAllMatId != -1) {
+		FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BuildingBounds, UVScaleMode, UVOriginMode, CoreUVRandom.Element(2), UVSize);
+		CoreMaterials.Add({ EBuildingFaceClass::All, 0, BuildingAllMatId, true, UVTransform });
+	}
+	Timer.Switch(EBuildingGenerationStage::Materials);
+	FaceClassMaterials::ApplyMaterials(Mesh, CoreMaterials);
+	Timer.Switch(EBuildingGenerationStage::Boxes);
+
+	// ===========================================================================================================
+	// ===========================================================================================================
+	// ===========================================================================================================
+
+	// ================ BOX LAYOUT ===================
+	// Every box is placed before any is built, boxes that don't fit in the building are never built
+	const FBuildingLayout Layout = MakeLayout();
+	if (IsInGameThread()) {
+		// the box workers can't create UObjects, have every scratch mesh they need ready
+		MeshPool->Reserve(GetNumScratchMeshes(Layout.Boxes.Num()));
+	}
+	UE_LOG(LogBuildingGeneration, Verbose, TEXT("GenerateBoxes - %i of %i boxes fit"), Layout.Boxes.Num(), Layout.MaxNumBoxes);
+
+	// ================ BOX FRAGMENTS ===================
+	// Only rebuild a box (floor, box, lattice, roof, panels) if one of its inputs changed since the last generation,
+	// the boxes that do need building are built concurrently.
+	TArray<FBuildingBoxFragmentPtr> Fragments;
+	Fragments.SetNum(Layout.Boxes.Num());
+	TArray<int32> BoxesToBuild;
+	for (const FBuildingBoxLayout& Box : Layout.Boxes) {
+		Fragments[Box.BoxNum] = FragmentCache.IsValid() ? FragmentCache->Find(Box.BoxNum, Box.Key) : nullptr;
+		if (!Fragments[Box.BoxNum].IsValid()) {
+			BoxesToBuild.Add(Box.BoxNum);
+		}
+	}
+
+	// the box workers time themselves
+	Timer.Pause();
+	ParallelFor(BoxesToBuild.Num(), [&](int32 BuildIndex)
+	{
+		const FBuildingBoxLayout& Box = Layout.Boxes[BoxesToBuild[BuildIndex]];
+		FBuildingBoxFragmentPtr Fragment = BuildBoxFragment(Box);
+		if (Fragment.IsValid() && FragmentCache.IsValid()) {
+			FragmentCache->Store(Box.BoxNum, Fragment);
+		}
+		Fragments[Box.BoxNum] = Fragment;
+	}, GetParallelForFlags());
+	Timer.Switch(EBuildingGenerationStage::Merge);
+
+	if (IsCancelled()) {
+		UE_LOG(LogBuildingGeneration, Log, TEXT("GenerateBoxes - Cancelled"));
+		return false;
+	}
+
+	// ================ BOX MERGE ===================
+	// Fragments are stitched in box order, which keeps the material set and vertex order independent of the build order
+	FScopedBuildingMesh BoxesScratch(MeshPool);
+	FScopedBuildingMesh AppendScratch(MeshPool);
+	UDynamicMesh* BoxesMesh = BoxesScratch.Get();
+	UDynamicMesh* ScratchMesh = AppendScratch.Get();
+	FBuildingInstances BoxesInstances;
+	for (int32 BoxIndex = 0; BoxIndex < Layout.Boxes.Num(); BoxIndex++) {
+		const FBuildingBoxLayout& Box = Layout.Boxes[BoxIndex];
+		FBuildingBoxFragmentPtr Fragment = Fragments[BoxIndex];
+		if (!Fragment.IsValid()) {
+			return false; // cancelled while building
+		}
+		// the layout stacks the boxes with the same height the fragment was built to
+		checkSlow(FMath::IsNearlyEqual(Fragment->TopZ, Box.Height, 0.01));
+
+		// BoxTransform will control how the current box is attached to the overall structure
+		const FTransform BoxTransform = Layout.GetBoxStackTransform(BoxIndex);
+
+		const FBox& BoxBounds = Fragment->BoxBounds;
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("GenerateBoxes[%i]  Size: %s Z Position: %f, S: %s, C: %s, E: %s, MAX: %s"), Box.BoxNum, *(Box.Size.ToString()), Box.Z, *(BoxBounds.GetSize().ToString()), *(BoxBounds.GetCenter().ToString()), *(BoxBounds.GetExtent().ToString()), *(BoxBounds.Max.ToString()));
+
+		// the box transform should place the box at the correct vertical position and rotation.
+		AppendBoxFragment(BoxesMesh, ScratchMesh, *Fragment, BoxTransform, MaterialSet);
+		BoxesInstances.Append(Fragment->Instances, BoxTransform);
+	} // end of Box creation loop
+
+	const int32 NumBoxesBuilt = BoxesToBuild.Num();
+	const int32 NumBoxesReused = Layout.Boxes.Num() - NumBoxesBuilt;
+
+	if (FragmentCache.IsValid()) {
+		FragmentCache->Trim(Layout.Boxes.Num());
+	}
+	INC_DWORD_STAT_BY(STAT_BuildingFragmentCacheHits, NumBoxesReused);
+	UE_LOG(LogBuildingGeneration, Log, TEXT("GenerateBoxes - Built %i boxes, reused %i cached boxes"), NumBoxesBuilt, NumBoxesReused);
+
+	const FTransform BoxesTransform = FTransform(Layout.BoxesOrigin);
+
+	// add BoxesMesh to Mesh...
+	UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
+		Mesh,
+		BoxesMesh,
+		BoxesTransform
+	);
+
+	// ======== FINALIZE ========
+	Timer.Switch(EBuildingGenerationStage::Finalize);
+	if (Recipe->bFinalizeMesh) {
+		FinalizeMesh(Mesh);
+	}
+	else if (Stats != nullptr) {
+		Mesh->ProcessMesh([this](const FDynamicMesh3& ReadMesh)
+		{
+			Stats->NumVerticesBeforeFinalize = Stats->NumVerticesAfterFinalize = ReadMesh.VertexCount();
+			Stats->NumTrianglesBeforeFinalize = Stats->NumTrianglesAfterFinalize = ReadMesh.TriangleCount();
+			Stats->MeshBytesBeforeFinalize = Stats->MeshBytesAfterFinalize = FPanelMeshCache::EstimateMeshBytes(ReadMesh);
+		});
+	}
+
+	INC_DWORD_STAT_BY(STAT_BuildingTrianglesEmitted, Mesh->GetTriangleCount());
+	if (Stats != nullptr) {
+		Stats->NumMeshRequests = MeshPool->GetNumRequests();
+		Stats->NumMeshesAllocated = MeshPool->GetNumAllocated();
+		Stats->PeakMeshesInUse = MeshPool->GetPeakInUse();
+	}
+	MeshPool->LogStats(TEXT("GenerateBoxes"));
+
+	if (OutInstances != nullptr) {
+		OutInstances->Append(BoxesInstances, BoxesTransform);
+		UE_LOG(LogBuildingGeneration, Log, TEXT("GenerateBoxes - %i instances (%i window insets, %i glass, %i lattice bars)"), OutInstances->Num(), OutInstances->WindowInsets.Num(), OutInstances->WindowGlass.Num(), OutInstances->LatticeBars.Num());
+	}
+
+	return true;
+}
+
+void BuildingGenerator::SetFragmentCache(TSharedPtr<FBuildingFragmentCache, ESPMode::ThreadSafe> InCache)
+{
+	FragmentCache = InCache;
+}
+
+FBuildingRandom BuildingGenerator::GetBoxRandom(int32 BoxNum, EBuildingRandomStage Stage) const
+{
+	return FBuildingRandom(Recipe->RandomSeed).Stage(Stage).Element(BoxNum);
+}
+
+int32 BuildingGenerator::GetPanelSeed(int32 BoxNum, const FVector& Face) const
+{
+	const FBuildingRandom WindowRandom = GetBoxRandom(BoxNum, EBuildingRandomStage::PanelWindows);
+	if (Recipe->PanelOptions.bWindowsUniform) {
+		return WindowRandom.GetSeed(); // every panel of the box shares its windows
+	}
+
+	// the face index is stable (north, east, south, west), unlike the iteration order of the enabled panels
+	const int32 FaceIndex = Recipe->PanelOptions.GetSideVectors().IndexOfByKey(Face);
+	return WindowRandom.Element(FaceIndex).GetSeed();
+}
+
+uint64 BuildingGenerator::GetBoxOptionsHash() const
+{
+	// Hash the text export of the option structs, this picks up every property (including material references)
+	// without having to keep a hand written hash in sync with the structs.
+	FString BoxText;
+	FString PanelText;
+	FDynamicBuildingGenericBoxOptions::StaticStruct()->ExportText(BoxText, &Recipe->BoxOptions, nullptr, nullptr, PPF_None, nullptr);
+	FDynamicBuildingPanelOptions::StaticStruct()->ExportText(PanelText, &Recipe->PanelOptions, nullptr, nullptr, PPF_None, nullptr);
+
+	// the output mode and LOD decide if windows and lattice are part of the fragment geometry
+	const FString Combined = BoxText + TEXT("|") + PanelText + TEXT("|") + FString::FromInt(static_cast<int32>(Recipe->DetailOutput)) + TEXT("|") + FString::FromInt(LOD);
+	return CityHash64(reinterpret_cast<const char*>(*Combined), Combined.Len() * sizeof(TCHAR));
+}
+
+void BuildingGenerator::FinalizeMesh(UDynamicMesh* Mesh)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BuildingGenerator::FinalizeMesh);
+	int32 VerticesBefore = 0;
+	int32 TrianglesBefore = 0;
+	int64 BytesBefore = 0;
+	int32 VerticesAfter = 0;
+	int32 TrianglesAfter = 0;
+	int64 BytesAfter = 0;
+
+	Mesh->EditMesh([&](FDynamicMesh3& EditMesh)
+	{
+		VerticesBefore = EditMesh.VertexCount();
+		TrianglesBefore = EditMesh.TriangleCount();
+		BytesBefore = FPanelMeshCache::EstimateMeshBytes(EditMesh);
+
+		// every box, panel and cut-out is appended as a separate piece, weld the open edges that line up. Only the 
+		// positions are welded, uv, normal and material seams along a welded edge are kept as they are.
+		FMergeCoincidentMeshEdges Welder(&EditMesh);
+		Welder.Apply();
+
+		// booleans, culling and welding leave holes in the id space, a compact copy renumbers the vertices, triangles
+		// and overlay elements and only allocates what's used
+		FDynamicMesh3 Compacted;
+		Compacted.CompactCopy(EditMesh);
+		EditMesh = MoveTemp(Compacted);
+
+		VerticesAfter = EditMesh.VertexCount();
+		TrianglesAfter = EditMesh.TriangleCount();
+		BytesAfter = FPanelMeshCache::EstimateMeshBytes(EditMesh);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
+
+	if (Stats != nullptr) {
+		Stats->NumVerticesBeforeFinalize = VerticesBefore;
+		Stats->NumTrianglesBeforeFinalize = TrianglesBefore;
+		Stats->MeshBytesBeforeFinalize = BytesBefore;
+		Stats->NumVerticesAfterFinalize = VerticesAfter;
+		Stats->NumTrianglesAfterFinalize = TrianglesAfter;
+		Stats->MeshBytesAfterFinalize = BytesAfter;
+	}
+	UE_LOG(LogBuildingGeneration, Log, TEXT("FinalizeMesh - %i -> %i verts, %i -> %i tris, %.1f -> %.1f KB"),
+		VerticesBefore, VerticesAfter, TrianglesBefore, TrianglesAfter, BytesBefore / 1024.0, BytesAfter / 1024.0);
+}
+
+uint64 BuildingGenerator::GetBoxFragmentKey(int32 BoxNum, const FVector& BoxSizeActual, int32 NumFloors, uint64 OptionsHash) const
+{
+	struct FBoxKeyData
+	{
+		double SizeX;
+		double SizeY;
+		double SizeZ;
+		int32 NumFloors;
+		int32 RandomSeed;
+		int32 BoxNum;
+	};
+
+	FBoxKeyData KeyData;
+	FMemory::Memzero(KeyData);
+	KeyData.SizeX = BoxSizeActual.X;
+	KeyData.SizeY = BoxSizeActual.Y;
+	KeyData.SizeZ = BoxSizeActual.Z;
+	KeyData.NumFloors = NumFloors;
+	KeyData.RandomSeed = Recipe->RandomSeed;
+	KeyData.BoxNum = BoxNum; // the box seed is derived from the building seed and box index
+
+	return CityHash64WithSeed(reinterpret_cast<const char*>(&KeyData), sizeof(KeyData), OptionsHash);
+}
+
+void BuildingGenerator::AppendBoxFragment(UDynamicMesh* TargetMesh, UDynamicMesh* ScratchMesh, const FBuildingBoxFragment& Fragment, const FTransform& Transform, TArray<UMaterialInterface*>& MaterialSet)
+{
+	// the fragment is shared with the cache, copy it before remapping its material ids
+	ScratchMesh->SetMesh(Fragment.Mesh);
+
+	if (Fragment.Materials.Num() > 0) {
+		const int32 MaterialOffset = MaterialSet.Num();
+		MaterialSet.Append(Fragment.Materials);
+
+		ScratchMesh->EditMesh([&](FDynamicMesh3& EditMesh)
+		{
+			using namespace UE::Geometry;
+			FDynamicMeshMaterialAttribute* MaterialIDs = EditMesh.HasAttributes() ? EditMesh.Attributes()->GetMaterialID() : nullptr;
+			if (MaterialIDs == nullptr) {
+				return;
+			}
+			for (int32 TriangleID : EditMesh.TriangleIndicesItr())
+			{
+				// local id N was the fragment's N-1th material, 0 stays the default material
+				const int32 LocalID = MaterialIDs->GetValue(TriangleID);
+				if (LocalID > 0) {
+					MaterialIDs->SetValue(TriangleID, MaterialOffset + LocalID - 1);
+				}
+			}
+		}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
+	}
+
+	UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
+		TargetMesh,
+		ScratchMesh,
+		Transform
+	);
+}
+
+FBuildingBoxFragmentPtr BuildingGenerator::BuildBoxFragment(const FBuildingBoxLayout& Box)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BuildingGenerator::BuildBoxFragment);
+	const int32 BoxNum = Box.BoxNum;
+	const FVector& BoxSizeActual = Box.Size;
+	FDynamicBuildingGenericBoxOptions& mBoxOptions = Recipe->BoxOptions;
+	FDynamicBuildingPanelOptions& mPanelOptions = Recipe->PanelOptions;
+
+	if (IsCancelled()) {
+		return nullptr;
+	}
+	FBuildingStageTimer Timer(Stats, EBuildingGenerationStage::Boxes);
+
+	// Each box has its own random elements, so a box's geometry only depends on its own inputs (and can be cached)
+	const FBuildingRandom BoxUVRandom = GetBoxRandom(BoxNum, EBuildingRandomStage::BoxUVs);
+
+	// Local material set, index 0 is a placeholder so that material id 0 keeps meaning "default material"
+	// see FBuildingBoxFragment
+	TArray<UMaterialInterface*> FragmentMaterials;
+	FragmentMaterials.Add(nullptr);
+
+	// boxes are built concurrently, each one gets its own scratch meshes from the pool
+	FScopedBuildingMesh BoxScratch(MeshPool);
+	FScopedBuildingMesh FloorScratch(MeshPool);
+	FScopedBuildingMesh RoofScratch(MeshPool);
+	FScopedBuildingMesh PanelScratch(MeshPool);
+	FScopedBuildingMesh FragmentScratch(MeshPool);
+	UDynamicMesh* BoxMesh = BoxScratch.Get();
+	UDynamicMesh* FloorMesh = FloorScratch.Get();
+	UDynamicMesh* RoofMesh = RoofScratch.Get();
+	UDynamicMesh* PanelMesh = PanelScratch.Get();
+	UDynamicMesh* FragmentMesh = FragmentScratch.Get();
+
+	TSet<FVector> SidePanelVectors = mPanelOptions.GetSidePanelVectors();
+
+	// ================ FLOOR PANEL ===========================
+	FBox FloorBounds = FBox(ForceInit);
+	if (mPanelOptions.bPanelFloor) {
+		FSizeAndTransform Floor = mPanelOptions.GetFloorSizeAndTransform(BoxSizeActual);
+		FDynamicBox Cube;
+		Cube.SetSize(Floor.Size);
+		AppendDynamicBox(FloorMesh, Cube);
+
+		/*
+		UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
+			BoxMesh,
+			FloorMesh,
+			Floor.Transform
+		);*/
+
+		// TODO this logic is replaced by bounding size logic
+		//BoxHeight += Floor.Size.Z;
+		//BoxHeight += Floor.Transform.GetTranslation().Z;
+
+		// transform the floor in place, it is now in the correct relative position.
+		UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(FloorMesh, Floor.Transform);
+		// GetMeshBoundingBox - this means the implementation of creating the floor mesh can change and we'll still know how to 
+		// space/stack things properly.
+		FloorBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(FloorMesh);
+	}
+
+	// ================ BOX GEOMETRY ==========================
+	FDynamicBox BoxCube;
+	BoxCube.SetSize(BoxSizeActual);
+	BoxCube.SetTranslation(FVector(0.f, 0.f, FloorBounds.Max.Z));
+	const EDynamicBoxFaces HiddenFaces = GetHiddenBoxFaces();
+	BoxCube.SetHiddenFaces(HiddenFaces);
+	INC_DWORD_STAT_BY(STAT_BuildingFacesCulled, FMath::CountBits(static_cast<uint64>(HiddenFaces)));
+	AppendDynamicBox(BoxMesh, BoxCube);
+
+	// the bounds of the whole box, a fully enclosed box has no faces left to measure
+	const FBox BoxBounds(FVector(-0.5f * BoxSizeActual.X, -0.5f * BoxSizeActual.Y, FloorBounds.Max.Z),
+		FVector(0.5f * BoxSizeActual.X, 0.5f * BoxSizeActual.Y, FloorBounds.Max.Z + BoxSizeActual.Z));
+
+	// ============== BOX MATERIALS ==========================
+	TArray<FFaceClassMaterialRule> BoxMaterials;
+
+	// ------------- TOP / BOTTOM ----------------------------
+	if (!mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::All)
+		&& mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::Top_Bottom)) {
+		// allocate a new material id
+		int32 TopBotMatId = FragmentMaterials.Num();
+		FragmentMaterials.Add(mBoxOptions.MaterialSlots[EBuildingBoxMaterialSlots::Top_Bottom]);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Box MatId[%i] (Top_Bottom)"), TopBotMatId);
+
+		FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BoxBounds, mBoxOptions.UVScaleMode, mBoxOptions.UVOriginMode, BoxUVRandom.Element(0), mBoxOptions.UVSize);
+		BoxMaterials.Add({ EBuildingFaceClass::TopBottom, INDEX_NONE, TopBotMatId, true, UVTransform });
+	}
+
+	// ------------- SIDES -----------------------------------
+	if (!mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::All)
+		&& mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::All_Sides)) {
+		// allocate a new material id
+		int32 SidesMatId = FragmentMaterials.Num();
+		FragmentMaterials.Add(mBoxOptions.MaterialSlots[EBuildingBoxMaterialSlots::All_Sides]);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Box MatId[%i] (All_Sides)"), SidesMatId);
+
+		FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BoxBounds, mBoxOptions.UVScaleMode, mBoxOptions.UVOriginMode, BoxUVRandom.Element(1), mBoxOptions.UVSize);
+		BoxMaterials.Add({ EBuildingFaceClass::Side, INDEX_NONE, SidesMatId, true, UVTransform });
+	}
+
+	int8 GlobalMatId = -1;
+	if (mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::All)) {
+		GlobalMatId = FragmentMaterials.Num();
+		FragmentMaterials.Add(mBoxOptions.MaterialSlots[EBuildingBoxMaterialSlots::All]);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Box MatId[%i] (All)"), GlobalMatId);
+	}
+	else if (mBoxOptions.MaterialSlots.IsEmpty()) {
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("Box MaterialSlots empty, MaterialID 0 will be applied to mesh as a default"));
+		GlobalMatId = 0;
+	}
+
+	// map the rest of the cube
+	if (GlobalMatId != -1) {
+		FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BoxBounds, mBoxOptions.UVScaleMode, mBoxOptions.UVOriginMode, BoxUVRandom.Element(2), mBoxOptions.UVSize);
+		BoxMaterials.Add({ EBuildingFaceClass::All, 0, GlobalMatId, true, UVTransform });
+	}
+	Timer.Switch(EBuildingGenerationStage::Materials);
+	FaceClassMaterials::ApplyMaterials(BoxMesh, BoxMaterials);
+
+	// TODO add OPTIONAL chamfer
+
+	
+
+	// ================ BOX LATTICE ==========================
+	Timer.Switch(EBuildingGenerationStage::Lattice);
+	FBuildingInstances FragmentInstances;
+	if (mBoxOptions.bHasFraming && LOD < 2) {
+		LatticeGrid Lattice = LatticeGrid(&(mBoxOptions.FramingOptions));
+		Lattice.SetFlat(LOD > 0);
+		Lattice.SetMeshPool(MeshPool);
+		Lattice.SetMeshCache(&FLatticeMeshCache::Get());
+		// one lattice per side of the box, placed on the faces of the bare box, hidden sides get none
+		TArray<FLatticeFaceFrame> LatticeFaces;
+		for (const FVector& Direction : mPanelOptions.GetSideVectors()) {
+			if (EnumHasAnyFlags(HiddenFaces, FDynamicBox::GetFaceForDirection(Direction))) {
+				continue;
+			}
+			LatticeFaces.Add(FLatticeFaceFrame::FromBox(BoxBounds, Direction));
+		}
+		if (IsInstancedOutput()) {
+			Lattice.AddLatticeInstances(LatticeFaces, FragmentInstances);
+		}
+		else {
+			Lattice.ApplyLattice(BoxMesh, LatticeFaces, FragmentMaterials);
+		}
+	}
+
+	// ================ ROOF PANEL ===========================
+	Timer.Switch(EBuildingGenerationStage::Boxes);
+	FBox RoofBounds = FBox(ForceInit);
+	if (mPanelOptions.bPanelRoof) {
+		FSizeAndTransform Roof = mPanelOptions.GetRoofSizeAndTransform(BoxSizeActual);
+		FDynamicBox Cube;
+		Cube.SetSize(Roof.Size);
+		AppendDynamicBox(RoofMesh, Cube);
+
+		Roof.Transform.AddToTranslation(FVector(0.f, 0.f, BoxBounds.Max.Z));
+
+		// transform the roof in place, it is now in the correct relative position.
+		UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(RoofMesh, Roof.Transform);
+		// GetMeshBoundingBox - this means the implementation of creating the floor mesh can change and we'll still know how to 
+		// space/stack things properly.
+		RoofBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(RoofMesh);
+	}
+
+	// simple collision of the box and its slabs, the side panels add their own
+	FragmentInstances.AddCollisionBox(BoxBounds);
+	if (mPanelOptions.bPanelFloor) {
+		FragmentInstances.AddCollisionBox(FloorBounds);
+	}
+	if (mPanelOptions.bPanelRoof) {
+		FragmentInstances.AddCollisionBox(RoofBounds);
+	}
+
+	// ================ SIDE PANELS ===================
+	// Panels only depend on their box and face, build them concurrently and append them in face order
+	TArray<FVector> PanelFaces = SidePanelVectors.Array();
+	TArray<UDynamicMesh*> PanelMeshes;
+	for (int32 PanelIndex = 0; PanelIndex < PanelFaces.Num(); PanelIndex++) {
+		PanelMeshes.Add(FBuildingMeshPool::Acquire(MeshPool));
+	}
+	TArray<FBuildingInstances> PanelInstances;
+	PanelInstances.SetNum(PanelFaces.Num());
+	TArray<TArray<FBox>> PanelWindows;
+	PanelWindows.SetNum(PanelFaces.Num());
+
+	// the panel workers time themselves
+	Timer.Pause();
+	std::atomic<bool> bPanelsCancelled = false;
+	ParallelFor(PanelFaces.Num(), [&](int32 PanelIndex)
+	{
+		if (!BuildSidePanel(Box, PanelFaces[PanelIndex], PanelMeshes[PanelIndex], PanelInstances[PanelIndex], PanelWindows[PanelIndex])) {
+			bPanelsCancelled = true;
+		}
+	}, GetParallelForFlags());
+
+	if (bPanelsCancelled) {
+		for (UDynamicMesh* SidePanel : PanelMeshes) {
+			FBuildingMeshPool::Release(MeshPool, SidePanel);
+		}
+		return nullptr;
+	}
+	Timer.Switch(EBuildingGenerationStage::Merge);
+
+	for (UDynamicMesh* SidePanel : PanelMeshes) {
+		UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
+			PanelMesh,
+			SidePanel,
+			FTransform::Identity
+		);
+		FBuildingMeshPool::Release(MeshPool, SidePanel);
+	}
+	for (const FBuildingInstances& Instances : PanelInstances) {
+		FragmentInstances.Append(Instances, FTransform::Identity);
+	}
+
+	// ================ BOX WINDOWS ===================
+	// the panels are in place, cut the windows of all of them with one mesh boolean (one BVH build and one cleanup
+	// instead of one per panel)
+	TArray<FBox> BoxWindows;
+	for (const TArray<FBox>& Windows : PanelWindows) {
+		BoxWindows.Append(Windows);
+	}
+	if (BoxWindows.Num() > 0) {
+		Timer.Switch(EBuildingGenerationStage::Booleans);
+		BooleanGrid::ApplyMeshBooleans(PanelMesh, BoxWindows, mPanelOptions.WindowBoolMode, MeshPool);
+		Timer.Switch(EBuildingGenerationStage::Merge);
+	}
+
+	// ================ COLLECT FRAGMENT ===================
+	for (auto BMesh : { BoxMesh, FloorMesh, RoofMesh, PanelMesh }) {
+		UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
+			FragmentMesh,
+			BMesh,
+			FTransform::Identity
+		);
+	}
+
+	TSharedPtr<FBuildingBoxFragment, ESPMode::ThreadSafe> Fragment = MakeShared<FBuildingBoxFragment, ESPMode::ThreadSafe>();
+	Fragment->Key = Box.Key;
+	Fragment->BoxBounds = BoxBounds;
+	Fragment->TopZ = FMath::Max(RoofBounds.Max.Z, BoxBounds.Max.Z);
+	Fragment->Materials.Append(FragmentMaterials.GetData() + 1, FragmentMaterials.Num() - 1);
+	Fragment->Instances = MoveTemp(FragmentInstances);
+	// pool meshes keep the ids of larger meshes they held before, the cached copy only keeps the live ones
+	FragmentMesh->ProcessMesh([&](const FDynamicMesh3& ReadMesh)
+	{
+		Fragment->Mesh.CompactCopy(ReadMesh);
+	});
+
+	return Fragment;
+}
+
+BuildingGenerator::~BuildingGenerator()
+{
+}
+
+bool BuildingGenerator::BuildSidePanel(const FBuildingBoxLayout& Box, const FVector& Face, UDynamicMesh* OutMesh, FBuildingInstances& OutInstances, TArray<FBox>& OutWindows)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BuildingGenerator::BuildSidePanel);
+	FDynamicBuildingPanelOptions& mPanelOptions = Recipe->PanelOptions;
+	const float FloorHeight = Recipe->BoxOptions.FloorHeight;
+	const FVector& BoxSizeActual = Box.Size;
+	const int32 NumFloors = Box.NumFloors;
+
+	if (IsCancelled()) {
+		return false;
+	}
+	FBuildingStageTimer Timer(Stats, EBuildingGenerationStage::Panels);
+
+	/*
+	* Panel Faces:
+	* ------------
+	* We can build panel faces on each of the 4 sides of our boxes
+	* The panels have a facing direction, defined by the constants of FVector like FVector::ForwardVector, FVector::LeftVector, etc.
+	* If you place yourself in the center of the buildings cube, at coordinate 0,0 and you look forward, that panels facing direction is FVector::ForwardVector
+	* If you look at your left, the panel against that side of the building (from the center) would be FVector::LeftVector
+	* 
+	* Each Panel can have a panel to its left or right, we use this information to determine how we join to the other panels.
+	* If I'm looking to my left at the panel facing FVector::LeftVector, and I want to know if there is a panel to my left, I check for FVector::BackwardVector
+	* If I want to know if there is a panel to my right I check for FVector::ForwardVector.
+	* The convenience methods of `FDynamicBuildingPanelOptions` provide checks for these questions and help us know how to construct our panel.
+	* 
+	* The key thing to remember is the perspective of a panel and the meaning of left and right are always from a perspective that is at the center (inside) the building.
+	* 
+	* Panel Construction Methods:
+	* ---------------------------
+	* The logic that constructs each panel assumes that the perspective is FVector::ForwardVector (X+)
+	* From this viewpoint the left side of the panel is (Y-) the right side is (Y+). Up is (Z+)
+	* We stick to this convention to make it easy to reason about the coordinate system when constructing geometry procedurally.
+	* After the panel is constructed, and modifiers like booleans are applied the panel is transformed and rotated into place on
+	* the parent geometry (the box).
+	* 
+	* Origin:
+	* -------
+	* The origin of any geometry we spawn will be at the bottom-center of that geometry. So for our panel walls, the local 0,0 coordinate of that mesh is at the BOTTOM, 
+	* and 1/2 the depth of the panel wall. If you were looking down at the top of the panel, you would see the origin exactly half way through the panel wall 
+	* centered in both the X,Y directions.
+	* This means that we have to compensate when we align or place our panel for the thickness of the panel, specifcally 1/2 the thickness to align to an outside face.
+	*/
+
+	FSizeAndTransform Panel = mPanelOptions.GetPanelSizeAndTransform(Face, BoxSizeActual);
+	const bool bInstanceWindows = IsInstancedOutput() && mPanelOptions.WindowBoolMode == EGeometryScriptBooleanOperation::Subtract;
+
+	// ================ PANEL WINDOWS ===================
+	// The window options are resolved before the panel is built, they are part of the panel cache key
+	TUniquePtr<FBooleanGridOptions> BoolOptions = MakeUnique<FBooleanGridOptions>();
+	// Setup boolean grid with options from our Windows properties
+	BoolOptions->RandomSeed = GetPanelSeed(Box.BoxNum, Face);
+	BoolOptions->Depth = mPanelOptions.WindowDepth;
+	BoolOptions->CutMode = mPanelOptions.WindowCutMode;
+	BoolOptions->bSpecifyMaxBooleansPerRow = (mPanelOptions.WindowsPerRow >= 1);
+	BoolOptions->MaxBooleansPerRowOrColumn = mPanelOptions.WindowsPerRow;
+	BoolOptions->BooleanShape = EBuildingBooleanShapes::Rectangle;
+	BoolOptions->BooleanGridMode = mPanelOptions.WindowGridMode;
+	BoolOptions->bSpecifyMaxRowsColumns = (mPanelOptions.bWindowRowsMatchesFloors || !(mPanelOptions.bWindowRowsMatchesFloors) && mPanelOptions.WindowNumRows > 0);
+	BoolOptions->MaxRowCols = (mPanelOptions.bWindowRowsMatchesFloors) ? NumFloors : mPanelOptions.WindowNumRows;
+	BoolOptions->BooleanSizeMin = mPanelOptions.WindowSize * 1;
+	BoolOptions->BooleanSizeMax = (mPanelOptions.WindowSize + mPanelOptions.WindowSizeVariance) * 1;
+	BoolOptions->SafeEdge = mPanelOptions.WindowEdgeTrim;
+	BoolOptions->HorizontalSpacing = mPanelOptions.WindowHSpacing;
+	BoolOptions->HorizontalSpacingVariance = mPanelOptions.WindowHSpacingVariance;
+	BoolOptions->HorizontalAlignment = mPanelOptions.WindowHAlignment;
+	// If the window spacing and number is the same as the number of floors calculate the spacing between windows based on max window size and max floor size.
+	float SpaceBetweenWindows = FloorHeight - FMath::Max(BoolOptions->BooleanSizeMin.Y, BoolOptions->BooleanSizeMax.Y);
+	BoolOptions->VerticalSpacing = mPanelOptions.bWindowRowsMatchesFloors ? SpaceBetweenWindows : mPanelOptions.WindowVSpacing;
+
+	// Get the transform relative to the parent box (this will rotate and orient the panel correctly)
+	FTransform PanelBoxTransform = mPanelOptions.GetPanelBoxTransform(Face, BoxSizeActual);
+
+	// Panels with the same size and window options are identical, reuse a finished panel if any building built one
+	const uint64 PanelKey = FPanelMeshCache::MakeKey(Panel.Size, *BoolOptions, mPanelOptions.WindowBoolMode);
+	const bool bBoxBoolean = IsBoxBooleanCut();
+	if (LOD > 0 || bInstanceWindows || bBoxBoolean) {
+		// the panel is left uncut, instanced windows are laid out by the same code and placed as instances
+		FDynamicBox Cube;
+		Cube.SetSize(Panel.Size);
+		AppendDynamicBox(OutMesh, Cube);
+
+		if (bInstanceWindows || bBoxBoolean) {
+			const FBox SlabBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(OutMesh);
+			TUniquePtr<BooleanGrid> Booleans = MakeUnique<BooleanGrid>(BoolOptions.Get());
+			const FTransform SlabToBox = Panel.Transform * PanelBoxTransform;
+			Timer.Switch(EBuildingGenerationStage::Booleans);
+			for (const FBox& Window : Booleans->GetBooleanBoxes(SlabBounds, mPanelOptions.WindowBoolMode)) {
+				if (bBoxBoolean) {
+					// panels are only turned by multiples of 90 degrees, the window stays the same box in box space
+					OutWindows.Add(Window.TransformBy(SlabToBox));
+				}
+				else {
+					OutInstances.AddWindow(Window, SlabBounds, SlabToBox);
+				}
+			}
+			Timer.Switch(EBuildingGenerationStage::Panels);
+		}
+	}
+	else if (FPanelMeshPtr CachedPanel = FPanelMeshCache::Get().Find(PanelKey)) {
+		OutMesh->SetMesh(*CachedPanel);
+	}
+	else {
+		FDynamicBox Cube;
+		Cube.SetSize(Panel.Size);
+		//Cube.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Base); // for the boolean logic to operator correctly must be centered.
+		AppendDynamicBox(OutMesh, Cube);
+
+		// We have a panel mesh that is correctly centered about its origin, lets cut windows in it via boolean ops
+		// TODO fix boolean logic so it can apply itself to mesh in any orientation so we don't have to perform a transform twice
+		Timer.Switch(EBuildingGenerationStage::Booleans);
+		TUniquePtr<BooleanGrid> Booleans = MakeUnique<BooleanGrid>(BoolOptions.Get());
+		Booleans->SetMeshPool(MeshPool);
+		Booleans->ApplyBooleans(OutMesh, mPanelOptions.WindowBoolMode);
+		Timer.Switch(EBuildingGenerationStage::Panels);
+
+		OutMesh->ProcessMesh([&](const FDynamicMesh3& ReadMesh)
+		{
+			FPanelMeshCache::Get().Add(PanelKey, ReadMesh);
+		});
+	}
+
+	// Apply the transform (this moves the origin so the panel will be offset correctly for its neighbours), 
+	// it doesn't re-orient the panel to its final location.
+	UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(OutMesh, Panel.Transform);
+
+	// then rotate and orient the panel onto the box
+	UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(OutMesh, PanelBoxTransform);
+
+	// the whole slab collides, windows included
+	const FBox SlabBox = FBox(FVector(-0.5 * Panel.Size.X, -0.5 * Panel.Size.Y, 0.0), FVector(0.5 * Panel.Size.X, 0.5 * Panel.Size.Y, Panel.Size.Z));
+	OutInstances.AddCollisionBox(SlabBox, Panel.Transform * PanelBoxTransform);
+	return true;
+}
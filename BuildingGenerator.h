@@ -0,0 +1,125 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UDynamicMesh.h"
+#include "DynamicBuilding.h"
+#include "BuildingFragmentCache.h"
+#include "BuildingRandom.h"
+#include "BuildingInstances.h"
+#include "BuildingGenerationStats.h"
+#include "DynamicBox.h"
+#include "BuildingLayout.h"
+
+class FBuildingMeshPool;
+
+/**
+ * Runs the building pipeline (core, boxes, panels, windows, lattice) for a single recipe.
+ *
+ * The generator doesn't touch the actor, it only reads the recipe and writes into the mesh and material set
+ * it is given. This means it can be run on a worker thread against a scratch mesh, and the result swapped
+ * into the component once it's done.
+ *
+ * Boxes (and the side panels of each box) are built concurrently with ParallelFor into private meshes and merged
+ * in box order. Every box and panel is seeded from (building seed, box index, panel face), so the output is the
+ * same regardless of the number of threads. `Building.Generator.Parallel 0` builds everything on the calling thread.
+ *
+ * With `EBuildingDetailOutput::Instanced` the panels are left uncut and the lattice isn't built, the windows and
+ * lattice bars are laid out as usual and written to `OutInstances` (building space) instead. `OutInstances` also gets a
+ * simple collision box per core, box, panel and slab, whatever the detail output.
+ *
+ * Coarser LODs are built from the same layout (`SetLOD`): LOD 1 leaves the panels uncut and builds a flat lattice, 
+ * LOD 2 is only the core, the boxes and plain panel slabs. The boxes are stacked exactly as in LOD 0.
+ *
+ * HOWTO:
+ *	FDynamicBuildingRecipe Recipe = Building->MakeRecipe();
+ *	BuildingGenerator Generator = BuildingGenerator(&Recipe);
+ *	Generator.Generate(Mesh, MaterialSet);
+ */
+class PROCEDURALBUILDINGS_API BuildingGenerator
+{
+public:
+	BuildingGenerator();
+	BuildingGenerator(FDynamicBuildingRecipe* Recipe);
+
+	// Reset the mesh and material set and build the whole building into them.
+	// Returns false if generation was cancelled, the mesh is left partially built in that case.
+	bool Generate(UDynamicMesh* Mesh, TArray<UMaterialInterface*>& MaterialSet, FBuildingInstances* OutInstances = nullptr);
+
+	// Place every box of the building without building any geometry, Generate only builds the boxes of this layout
+	FBuildingLayout MakeLayout() const;
+
+	// The callback is polled between boxes and panels, returning true stops generation early.
+	void SetCancelCallback(TFunction<bool()> InShouldCancel);
+
+	// Boxes are looked up in the cache by index and key, only boxes whose inputs changed are rebuilt.
+	// Without a cache every box is built each time.
+	void SetFragmentCache(TSharedPtr<FBuildingFragmentCache, ESPMode::ThreadSafe> InCache);
+
+	// Level of detail to build, 0 (full detail) to MAX_LODS - 1. A fragment cache only holds a single LOD.
+	void SetLOD(int32 InLOD);
+	static const int32 MAX_LODS = 3;
+
+	// Time spent in each stage is added to `InStats`, nullptr (the default) doesn't time anything
+	void SetStats(FBuildingGenerationStats* InStats);
+
+	// Scratch meshes are taken from `InMeshPool` and given back when the generation is done with them. Without a pool
+	// (the default) each Generate uses its own pool. A Generate on the game thread reserves the meshes it needs, a
+	// generation on a worker thread should be given a pool reserved on the game thread.
+	void SetMeshPool(FBuildingMeshPool* InMeshPool);
+
+	// Most scratch meshes a generation of `NumBoxes` boxes has in use at once, with as many boxes built concurrently as
+	// there are worker threads (see FBuildingMeshPool::Reserve)
+	static int32 GetNumScratchMeshes(int32 NumBoxes);
+	~BuildingGenerator();
+
+private:
+	FDynamicBuildingRecipe* Recipe;
+	TFunction<bool()> ShouldCancel;
+	TSharedPtr<FBuildingFragmentCache, ESPMode::ThreadSafe> FragmentCache;
+	int32 LOD = 0;
+	FBuildingGenerationStats* Stats = nullptr;
+	FBuildingMeshPool* MeshPool = nullptr;
+
+	bool IsCancelled() const;
+
+	// Random numbers are derived from (building seed, stage, box index) rather than drawn from a shared stream,
+	// so every box and panel gets the same values no matter which thread builds it or in what order.
+	FBuildingRandom GetBoxRandom(int32 BoxNum, EBuildingRandomStage Stage) const;
+
+	// Seed of the windows of a panel, panels share the box's window seed when `bWindowsUniform` is set.
+	int32 GetPanelSeed(int32 BoxNum, const FVector& Face) const;
+
+	// Build the floor, box, materials, lattice, roof and side panels of a single box in box space.
+	// Thread safe, every box allocates its own scratch meshes. Returns nullptr if generation was cancelled.
+	FBuildingBoxFragmentPtr BuildBoxFragment(const FBuildingBoxLayout& Box);
+
+	// Build one side panel (slab and windows) into `OutMesh` in box space, instanced windows go to `OutInstances`.
+	// With EBuildingCutMode::BoxBoolean the slab is left uncut and its windows go to `OutWindows` (in box space) to be
+	// cut with the other panels of the box. Returns false if generation was cancelled.
+	bool BuildSidePanel(const FBuildingBoxLayout& Box, const FVector& Face, UDynamicMesh* OutMesh, FBuildingInstances& OutInstances, TArray<FBox>& OutWindows);
+
+	// True if the windows of a box are cut with one mesh boolean once all of its panels are placed (see BuildSidePanel)
+	bool IsBoxBooleanCut() const;
+
+	// True if windows and lattice bars are output as instances, only LOD 0 has instances
+	bool IsInstancedOutput() const;
+
+	// Faces of every box that can't be seen from outside the building (see `bCullHiddenFaces`). The side panels stand
+	// off the box, so a face is only hidden once the gap in front of it is closed and the panels have no holes in them.
+	EDynamicBoxFaces GetHiddenBoxFaces() const;
+
+	// Weld the coincident open edges left by merging, then compact the ids and overlays and shrink the mesh to fit
+	void FinalizeMesh(UDynamicMesh* Mesh);
+
+	// Stitch a fragment into the target mesh, remapping its local material ids onto the building material set.
+	void AppendBoxFragment(UDynamicMesh* TargetMesh, UDynamicMesh* ScratchMesh, const FBuildingBoxFragment& Fragment, const FTransform& Transform, TArray<UMaterialInterface*>& MaterialSet);
+
+	// Height of a built box from the bottom of its floor panel to the top of its roof panel, the boxes are stacked by it
+	double GetBoxHeight(const FVector& BoxSize) const;
+
+	// Hash of the box and panel options, shared by every box of the building
+	uint64 GetBoxOptionsHash() const;
+
+	// Everything a box's geometry depends on: its resolved size and floors, its seed and the option hash
+	uint64 GetBoxFragmentKey(int32 BoxNum, const FVector& BoxSizeActual, int32 NumFloors, uint64 OptionsHash) const;
+};
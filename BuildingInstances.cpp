@@ -0,0 +1,70 @@
+#include "BuildingInstances.h"
+
+FTransform FBuildingInstances::MakeBoxTransform(const FBox& Box, const FTransform& Transform)
+{
+	// the unit mesh is centered, scale it to the box and move it to the box center.
+	// `Transform` is a rotation and translation, so composing it after the (non uniform) scale is exact.
+	const FTransform Local = FTransform(FQuat::Identity, Box.GetCenter(), Box.GetSize() / UNIT_MESH_SIZE);
+	return Local * Transform;
+}
+
+void FBuildingInstances::AddWindow(const FBox& Window, const FBox& Slab, const FTransform& Transform)
+{
+	const double Face = Slab.Max.X;
+	const double Back = FMath::Max(Window.Min.X, Slab.Min.X);
+	if (Face - Back <= KINDA_SMALL_NUMBER || Window.GetSize().Y <= KINDA_SMALL_NUMBER || Window.GetSize().Z <= KINDA_SMALL_NUMBER) {
+		return;
+	}
+
+	const FBox Inset = FBox(FVector(Back, Window.Min.Y, Window.Min.Z), FVector(Face + SURFACE_OFFSET, Window.Max.Y, Window.Max.Z));
+	WindowInsets.Add(MakeBoxTransform(Inset, Transform));
+
+	// the plane's X/Y run across the window (Y/Z of the slab) and its normal points out of the face (X+)
+	const FVector Center = FVector(Face + (SURFACE_OFFSET * 2), Window.GetCenter().Y, Window.GetCenter().Z);
+	FTransform Glass = FTransform(FVector::RightVector, FVector::UpVector, FVector::ForwardVector, Center);
+	Glass.SetScale3D(FVector(Window.GetSize().Y / UNIT_MESH_SIZE, Window.GetSize().Z / UNIT_MESH_SIZE, 1.0));
+	WindowGlass.Add(Glass * Transform);
+}
+
+void FBuildingInstances::AddLatticeBar(const FBox& Bar, const FTransform& Transform)
+{
+	LatticeBars.Add(MakeBoxTransform(Bar, Transform));
+}
+
+void FBuildingInstances::AddCollisionBox(const FBox& Box, const FTransform& Transform)
+{
+	CollisionBoxes.Add(MakeBoxTransform(Box, Transform));
+}
+
+void FBuildingInstances::Append(const FBuildingInstances& Other, const FTransform& Transform)
+{
+	auto AppendTransformed = [&Transform](TArray<FTransform>& Target, const TArray<FTransform>& Source)
+	{
+		Target.Reserve(Target.Num() + Source.Num());
+		for (const FTransform& Instance : Source) {
+			Target.Add(Instance * Transform);
+		}
+	};
+	AppendTransformed(WindowInsets, Other.WindowInsets);
+	AppendTransformed(WindowGlass, Other.WindowGlass);
+	AppendTransformed(LatticeBars, Other.LatticeBars);
+	AppendTransformed(CollisionBoxes, Other.CollisionBoxes);
+}
+
+void FBuildingInstances::Reset()
+{
+	WindowInsets.Reset();
+	WindowGlass.Reset();
+	LatticeBars.Reset();
+	CollisionBoxes.Reset();
+}
+
+int32 FBuildingInstances::Num() const
+{
+	return WindowInsets.Num() + WindowGlass.Num() + LatticeBars.Num();
+}
+
+int64 FBuildingInstances::GetInstanceBytes() const
+{
+	return (int64)Num() * sizeof(FMatrix);
+}
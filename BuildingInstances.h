@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Per-instance transforms of the building details that are drawn as instances of shared unit meshes instead of being
+ * baked into the building mesh (see EBuildingDetailOutput::Instanced).
+ *
+ * The unit meshes are the engine basic shapes: insets and lattice bars are a 100cm cube and glass is a 100cm plane
+ * facing Z+, both centered on their origin. A transform scales the unit mesh onto the part's size and places it.
+ *
+ * The simple collision of the building rides along the same way: a unit cube transform per core, box, panel and slab
+ * (`CollisionBoxes`). It's always collected, whatever the detail output, and isn't drawn.
+ *
+ * HOWTO:
+ *	FBuildingInstances Instances;
+ *	Instances.AddWindow(WindowBox, SlabBounds, PanelTransform);
+ *	Instances.AddLatticeBar(BarBox, Face.GetTransform());
+ *	Instances.AddCollisionBox(SlabBox, PanelTransform);
+ *	BuildingInstances.Append(Instances, BoxTransform);
+ */
+struct PROCEDURALBUILDINGS_API FBuildingInstances
+{
+	// size of the unit meshes in cm
+	static constexpr double UNIT_MESH_SIZE = 100.0;
+
+	// how far the inset (and the glass in front of it) sits in front of the uncut panel face, so they don't z-fight with it
+	static constexpr double SURFACE_OFFSET = 1.0;
+
+	TArray<FTransform> WindowInsets;
+	TArray<FTransform> WindowGlass;
+	TArray<FTransform> LatticeBars;
+	TArray<FTransform> CollisionBoxes;
+
+	// Add the inset and glass of a window. `Window` is the window's boolean tool box in the space of `Slab`, it cuts
+	// the X+ face of the slab. The inset is the part of the slab the window would have cut away.
+	void AddWindow(const FBox& Window, const FBox& Slab, const FTransform& Transform);
+
+	// Add a lattice bar (or border piece) that fills `Bar`
+	void AddLatticeBar(const FBox& Bar, const FTransform& Transform);
+
+	// Add a simple collision box that fills `Box`
+	void AddCollisionBox(const FBox& Box, const FTransform& Transform = FTransform::Identity);
+
+	// Append every instance (and collision box) of `Other`, moved by `Transform`
+	void Append(const FBuildingInstances& Other, const FTransform& Transform);
+
+	void Reset();
+
+	// Drawn instances, the collision boxes aren't counted
+	int32 Num() const;
+
+	// Approximate memory of the instance data, the instanced components keep a matrix per instance
+	int64 GetInstanceBytes() const;
+
+	// Transform of the unit cube that fills `Box`, then moved by `Transform`
+	static FTransform MakeBoxTransform(const FBox& Box, const FTransform& Transform = FTransform::Identity);
+};
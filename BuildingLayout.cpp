@@ -0,0 +1,12 @@
+#include "BuildingLayout.h"
+
+FTransform FBuildingLayout::GetBoxStackTransform(int32 Index) const
+{
+	const FBuildingBoxLayout& Box = Boxes[Index];
+	return FTransform(FQuat(Box.Rotation), FVector(0.0, 0.0, Box.Z));
+}
+
+FTransform FBuildingLayout::GetBoxTransform(int32 Index) const
+{
+	return GetBoxStackTransform(Index) * FTransform(BoxesOrigin);
+}
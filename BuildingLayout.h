@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BuildingLayout.generated.h"
+
+// Where one box of a building goes and what it's made of, resolved before any geometry is built
+USTRUCT(BlueprintType)
+struct PROCEDURALBUILDINGS_API FBuildingBoxLayout
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout", meta = (ToolTip = "Index of the box, its random values are drawn from this index"))
+	int32 BoxNum = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout", meta = (ToolTip = "Size of the bare box, without floor, roof or panels"))
+	FVector Size = FVector::Zero();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout")
+	int32 NumFloors = 1;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout")
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout", meta = (ToolTip = "Bottom of the box (its floor panel if any) above the bottom of the stack"))
+	double Z = 0.0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout", meta = (ToolTip = "From the bottom of the floor panel to the top of the roof panel (or the box)"))
+	double Height = 0.0;
+
+	// Hash of everything the box's geometry depends on, see BuildingGenerator::GetBoxFragmentKey (blueprints have no uint64)
+	uint64 Key = 0;
+};
+
+/**
+ * The layout of a building's boxes as plain data: the size, floors and rotation of every box, where it's stacked and
+ * how the stack is aligned to the core. It's cheap to compute, BuildingGenerator lays a building out first and then
+ * only builds the boxes that fit.
+ *
+ * HOWTO:
+ *	FBuildingLayout Layout = BuildingGenerator(&Recipe).MakeLayout();
+ *	for (int32 Index = 0; Index < Layout.Boxes.Num(); Index++) { Layout.GetBoxTransform(Index); }
+ */
+USTRUCT(BlueprintType)
+struct PROCEDURALBUILDINGS_API FBuildingLayout
+{
+	GENERATED_BODY()
+
+	// The boxes that fit in the usable height, bottom to top
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout")
+	TArray<FBuildingBoxLayout> Boxes;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout", meta = (ToolTip = "The number of boxes the building height allows for, boxes that don't fit are dropped"))
+	int32 MaxNumBoxes = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout", meta = (ToolTip = "Height of the building the boxes may be stacked in"))
+	double UsableHeight = 0.0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout", meta = (ToolTip = "Height of the stack the vertical alignment is computed from"))
+	double StackHeight = 0.0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Layout", meta = (ToolTip = "Offset of the stack from the building origin, from the vertical alignment"))
+	FVector BoxesOrigin = FVector::Zero();
+
+	// Transform of a box relative to the bottom of the stack
+	FTransform GetBoxStackTransform(int32 Index) const;
+
+	// Transform of a box in building space
+	FTransform GetBoxTransform(int32 Index) const;
+};
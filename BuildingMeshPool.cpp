@@ -0,0 +1,138 @@
+#include "BuildingMeshPool.h"
+#include "BuildingStats.h"
+#include "UDynamicMesh.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/GarbageCollection.h" // FGCScopeGuard
+
+using namespace UE::Geometry;
+
+// Reset `Mesh` to a new UDynamicMesh's state: no elements, all id counters and free lists back at 0 and the attribute
+// layout of a new mesh (groups and a default attribute set), whatever the last user enabled. A reused mesh then hands
+// out the same vertex, edge and triangle ids as a new one, the output doesn't depend on which mesh of the pool was used.
+static void ResetPoolMesh(FDynamicMesh3& Mesh)
+{
+	Mesh.Clear();
+	Mesh.EnableTriangleGroups();
+	Mesh.EnableAttributes();
+}
+
+static UDynamicMesh* NewPoolMesh()
+{
+	INC_DWORD_STAT(STAT_BuildingMeshesAllocated);
+	return NewObject<UDynamicMesh>();
+}
+
+void FBuildingMeshPool::Reserve(int32 NumMeshes)
+{
+	check(IsInGameThread());
+	FScopeLock ScopeLock(&Lock);
+	while (Meshes.Num() < NumMeshes) {
+		UDynamicMesh* Mesh = NewPoolMesh();
+		Meshes.Add(Mesh);
+		FreeMeshes.Add(Mesh);
+	}
+}
+
+UDynamicMesh* FBuildingMeshPool::Acquire()
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		NumRequests++;
+		NumInUse++;
+		PeakInUse = FMath::Max(PeakInUse, NumInUse);
+		if (FreeMeshes.Num() > 0) {
+			return FreeMeshes.Pop(false);
+		}
+	}
+
+	// the pool ran dry on a worker, keep the garbage collector out until the new mesh is referenced by the pool
+	TOptional<FGCScopeGuard> GCGuard;
+	if (!IsInGameThread()) {
+		GCGuard.Emplace();
+		UE_LOG(LogBuildingGeneration, Verbose, TEXT("Mesh Pool - allocating on a worker thread, reserve more meshes before generating"));
+	}
+	UDynamicMesh* Mesh = NewPoolMesh();
+
+	FScopeLock ScopeLock(&Lock);
+	Meshes.Add(Mesh);
+	return Mesh;
+}
+
+void FBuildingMeshPool::Release(UDynamicMesh* Mesh)
+{
+	if (Mesh == nullptr) {
+		return;
+	}
+	// reset by the thread that used it, not under the lock
+	Mesh->EditMesh([](FDynamicMesh3& EditMesh)
+	{
+		ResetPoolMesh(EditMesh);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, true);
+
+	FScopeLock ScopeLock(&Lock);
+	checkSlow(Meshes.Contains(Mesh));
+	FreeMeshes.Add(Mesh);
+	NumInUse--;
+}
+
+int32 FBuildingMeshPool::GetNumRequests() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return NumRequests;
+}
+
+int32 FBuildingMeshPool::GetNumAllocated() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Meshes.Num();
+}
+
+int32 FBuildingMeshPool::GetPeakInUse() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return PeakInUse;
+}
+
+void FBuildingMeshPool::LogStats(const TCHAR* Context) const
+{
+	FScopeLock ScopeLock(&Lock);
+	UE_LOG(LogBuildingGeneration, Log, TEXT("%s - Mesh Pool: %i requests, %i meshes allocated, peak %i in use"), Context, NumRequests, Meshes.Num(), PeakInUse);
+}
+
+UDynamicMesh* FBuildingMeshPool::Acquire(FBuildingMeshPool* Pool)
+{
+	if (Pool != nullptr) {
+		return Pool->Acquire();
+	}
+	return NewPoolMesh();
+}
+
+void FBuildingMeshPool::Release(FBuildingMeshPool* Pool, UDynamicMesh* Mesh)
+{
+	if (Pool != nullptr) {
+		Pool->Release(Mesh);
+	}
+}
+
+void FBuildingMeshPool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	FScopeLock ScopeLock(&Lock);
+	Collector.AddReferencedObjects(Meshes);
+}
+
+FString FBuildingMeshPool::GetReferencerName() const
+{
+	return TEXT("FBuildingMeshPool");
+}
+
+FScopedBuildingMesh::FScopedBuildingMesh(FBuildingMeshPool* InPool)
+	: Pool(InPool)
+	, Mesh(FBuildingMeshPool::Acquire(InPool))
+{
+}
+
+FScopedBuildingMesh::~FScopedBuildingMesh()
+{
+	FBuildingMeshPool::Release(Pool, Mesh);
+}
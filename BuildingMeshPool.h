@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "HAL/CriticalSection.h"
+
+class UDynamicMesh;
+
+/**
+ * Scratch UDynamicMesh objects shared by one generation. Boxes, panels, lattices and window booleans take their 
+ * scratch meshes from the pool and give them back when they are done, so a generation allocates about as many meshes 
+ * as are in use at once instead of one per request. A released mesh is reset to the state of a new one, so its ids
+ * and with them the generated geometry don't depend on its history. The pool keeps its meshes alive for the garbage
+ * collector.
+ *
+ * Acquire and Release are thread safe, boxes and panels are built concurrently. UObjects are only created on the game
+ * thread, Reserve the meshes a generation needs before its workers start (BuildingGenerator::GetNumScratchMeshes).
+ * A worker that finds the pool empty creates a mesh under a short FGCScopeGuard.
+ *
+ * HOWTO:
+ *	FBuildingMeshPool Pool;
+ *	Pool.Reserve(BuildingGenerator::GetNumScratchMeshes(NumBoxes));
+ *	FScopedBuildingMesh PanelMesh(&Pool);
+ *	AppendDynamicBox(PanelMesh.Get(), Cube);
+ *	// released back to the pool when PanelMesh goes out of scope
+ */
+class PROCEDURALBUILDINGS_API FBuildingMeshPool : public FGCObject
+{
+public:
+	FBuildingMeshPool() = default;
+	virtual ~FBuildingMeshPool() = default;
+
+	// Allocate meshes until the pool holds at least `NumMeshes`, game thread only
+	void Reserve(int32 NumMeshes);
+
+	// An empty mesh, a released one if there is any
+	UDynamicMesh* Acquire();
+
+	// Give a mesh back, it is reset and handed out by a later Acquire
+	void Release(UDynamicMesh* Mesh);
+
+	// Number of Acquire calls, ie. the meshes the generation would have allocated without a pool
+	int32 GetNumRequests() const;
+
+	// Meshes the pool allocated
+	int32 GetNumAllocated() const;
+
+	// Most meshes acquired and not yet released at one time
+	int32 GetPeakInUse() const;
+
+	void LogStats(const TCHAR* Context) const;
+
+	// Acquire from `Pool`, or allocate a new mesh (left to the garbage collector) without a pool
+	static UDynamicMesh* Acquire(FBuildingMeshPool* Pool);
+
+	// Release to `Pool`, without a pool the mesh is left to the garbage collector
+	static void Release(FBuildingMeshPool* Pool, UDynamicMesh* Mesh);
+
+	//~ FGCObject
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override;
+
+private:
+	mutable FCriticalSection Lock;
+	TArray<UDynamicMesh*> Meshes;
+	TArray<UDynamicMesh*> FreeMeshes;
+	int32 NumRequests = 0;
+	int32 NumInUse = 0;
+	int32 PeakInUse = 0;
+};
+
+/**
+ * A mesh acquired from a pool for the lifetime of the scope. Without a pool a new mesh is allocated (and left to the
+ * garbage collector), so classes that can be given a pool still work on their own.
+ */
+class PROCEDURALBUILDINGS_API FScopedBuildingMesh
+{
+public:
+	explicit FScopedBuildingMesh(FBuildingMeshPool* InPool);
+	~FScopedBuildingMesh();
+
+	FScopedBuildingMesh(const FScopedBuildingMesh&) = delete;
+	FScopedBuildingMesh& operator=(const FScopedBuildingMesh&) = delete;
+
+	UDynamicMesh* Get() const { return Mesh; }
+
+private:
+	FBuildingMeshPool* Pool;
+	UDynamicMesh* Mesh;
+};
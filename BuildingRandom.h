@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Every part of the layout that draws random numbers has its own stage, so adding a draw to one stage
+// never changes the values of another.
+enum class EBuildingRandomStage : uint32
+{
+	None = 0,
+	CoreUVs,
+	BoxLayout,
+	BoxUVs,
+	PanelWindows,
+	WindowLayout,
+	LatticeRows,
+	LatticeColumns,
+	LatticeFramingUVs,
+	LatticeBorderUVs,
+	LatticeUVs,
+};
+
+/**
+ * Stateless counter based random numbers for the procedural layout.
+ *
+ * Unlike FRandomStream there is no sequence to advance, every value is a hash of (seed, stage, element index, channel).
+ * Asking for an extra value never shifts any other value, and any window, lattice bar or UV origin can be evaluated on its
+ * own, in any order and on any thread. Copies are cheap (a single 64 bit key).
+ *
+ * HOWTO:
+ *	FBuildingRandom Windows = FBuildingRandom(Seed).Stage(EBuildingRandomStage::WindowLayout);
+ *	FBuildingRandom Window = Windows.Element(Row).Element(Col);
+ *	float Width = Window.FRandRange(MinWidth, MaxWidth, 0);  // channel 0
+ *	float Height = Window.FRandRange(MinHeight, MaxHeight, 1); // channel 1
+ */
+struct PROCEDURALBUILDINGS_API FBuildingRandom
+{
+public:
+	FBuildingRandom()
+		: Key(0)
+	{}
+
+	explicit FBuildingRandom(int32 Seed)
+		: Key(Mix(static_cast<uint64>(static_cast<uint32>(Seed)) + 0x9E3779B97F4A7C15ull))
+	{}
+
+	// The numbers of a stage, independent of every other stage
+	FORCEINLINE FBuildingRandom Stage(EBuildingRandomStage InStage) const
+	{
+		return Derive(static_cast<uint64>(InStage) | (1ull << 48));
+	}
+
+	// The numbers of one element (a box, a row, a window...), independent of every other element
+	FORCEINLINE FBuildingRandom Element(int32 Index) const
+	{
+		return Derive(static_cast<uint64>(static_cast<uint32>(Index)) | (2ull << 48));
+	}
+
+	// Uniformly distributed 32 bit value, each channel of an element is independent
+	FORCEINLINE uint32 GetUInt(uint32 Channel = 0) const
+	{
+		return static_cast<uint32>(Mix(Key ^ (static_cast<uint64>(Channel) * 0xD1B54A32D192ED03ull + 0x8CB92BA72F3D8DD7ull)) >> 32);
+	}
+
+	// Value in [0, 1)
+	FORCEINLINE float GetFraction(uint32 Channel = 0) const
+	{
+		return (GetUInt(Channel) >> 8) * (1.f / 16777216.f);
+	}
+
+	// Value in [Min, Max)
+	FORCEINLINE float FRandRange(float Min, float Max, uint32 Channel = 0) const
+	{
+		return Min + (Max - Min) * GetFraction(Channel);
+	}
+
+	// Value in [Min, Max] (inclusive, like FRandomStream::RandRange)
+	FORCEINLINE int32 RandRange(int32 Min, int32 Max, uint32 Channel = 0) const
+	{
+		const int64 Range = static_cast<int64>(Max) - Min + 1;
+		return Range > 0 ? static_cast<int32>(Min + ((static_cast<uint64>(GetUInt(Channel)) * Range) >> 32)) : Min;
+	}
+
+	// A seed for code that still takes a plain int32 (e.g. FBooleanGridOptions::RandomSeed)
+	FORCEINLINE int32 GetSeed(uint32 Channel = 0) const
+	{
+		return static_cast<int32>(GetUInt(Channel));
+	}
+
+	FORCEINLINE uint64 GetKey() const
+	{
+		return Key;
+	}
+
+	// SplitMix64 finalizer
+	static FORCEINLINE uint64 Mix(uint64 Value)
+	{
+		Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+		return Value ^ (Value >> 31);
+	}
+
+private:
+	uint64 Key;
+
+	FORCEINLINE FBuildingRandom Derive(uint64 Value) const
+	{
+		FBuildingRandom Result;
+		Result.Key = Mix(Key ^ Mix(Value + 0x9E3779B97F4A7C15ull));
+		return Result;
+	}
+};
@@ -0,0 +1,12 @@
+#include "BuildingStats.h"
+
+DEFINE_LOG_CATEGORY(LogBuildingGeneration);
+
+DEFINE_STAT(STAT_BuildingMeshBooleans);
+DEFINE_STAT(STAT_BuildingAnalyticCutouts);
+DEFINE_STAT(STAT_BuildingTrianglesEmitted);
+DEFINE_STAT(STAT_BuildingMeshesAllocated);
+DEFINE_STAT(STAT_BuildingFragmentCacheHits);
+DEFINE_STAT(STAT_BuildingPanelCacheHits);
+DEFINE_STAT(STAT_BuildingLatticeCacheHits);
+DEFINE_STAT(STAT_BuildingFacesCulled);
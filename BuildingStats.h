@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/**
+ * Log category, stats and trace scopes of the building pipeline.
+ *
+ * Per element logs (every window, lattice row and column, box and material id) are VeryVerbose. On large buildings
+ * the logging costs more than the geometry, so they are compiled out unless BUILDING_LOG_ELEMENTS is 1.
+ *
+ * The stages of BuildingGenerator (see FBuildingStageTimer), ApplyBooleans, ApplyLattice and the actor's generation
+ * show up as CPU trace events in Unreal Insights (-trace=cpu). The counters accumulate over every generation.
+ *
+ * HOWTO:
+ *	stat ProceduralBuilding
+ *	Log LogBuildingGeneration VeryVerbose   (needs BUILDING_LOG_ELEMENTS 1)
+ */
+#ifndef BUILDING_LOG_ELEMENTS
+#define BUILDING_LOG_ELEMENTS 0
+#endif
+
+#if BUILDING_LOG_ELEMENTS
+PROCEDURALBUILDINGS_API DECLARE_LOG_CATEGORY_EXTERN(LogBuildingGeneration, Log, All);
+#else
+PROCEDURALBUILDINGS_API DECLARE_LOG_CATEGORY_EXTERN(LogBuildingGeneration, Log, Verbose);
+#endif
+
+DECLARE_STATS_GROUP(TEXT("ProceduralBuilding"), STATGROUP_ProceduralBuilding, STATCAT_Advanced);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Mesh Booleans"), STAT_BuildingMeshBooleans, STATGROUP_ProceduralBuilding, PROCEDURALBUILDINGS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Analytic Cut-outs"), STAT_BuildingAnalyticCutouts, STATGROUP_ProceduralBuilding, PROCEDURALBUILDINGS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Triangles Emitted"), STAT_BuildingTrianglesEmitted, STATGROUP_ProceduralBuilding, PROCEDURALBUILDINGS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Meshes Allocated"), STAT_BuildingMeshesAllocated, STATGROUP_ProceduralBuilding, PROCEDURALBUILDINGS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Fragment Cache Hits"), STAT_BuildingFragmentCacheHits, STATGROUP_ProceduralBuilding, PROCEDURALBUILDINGS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Panel Cache Hits"), STAT_BuildingPanelCacheHits, STATGROUP_ProceduralBuilding, PROCEDURALBUILDINGS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Lattice Cache Hits"), STAT_BuildingLatticeCacheHits, STATGROUP_ProceduralBuilding, PROCEDURALBUILDINGS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hidden Faces Culled"), STAT_BuildingFacesCulled, STATGROUP_ProceduralBuilding, PROCEDURALBUILDINGS_API);
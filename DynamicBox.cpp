@@ -0,0 +1,213 @@
+#include "DynamicBox.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "DynamicMesh/MeshTransforms.h"
+#include "DynamicMeshEditor.h"
+#include "Generators/GridBoxMeshGenerator.h"
+#include "FaceClassMaterials.h"
+
+using namespace UE::Geometry;
+
+void FDynamicBox::SetSize(const FVector& Size)
+{
+	mSize = Size;
+}
+
+void FDynamicBox::AddToOrigin(const FVector& Delta)
+{
+	mOrigin += Delta;
+}
+
+void FDynamicBox::AddToSize(const FVector& Delta)
+{
+	mSize += Delta;
+}
+
+void FDynamicBox::AddToSizeInDirection(const float Size, const FVector& Direction)
+{
+	FVector Normalized = Direction.GetSafeNormal();
+	FVector ChangeInSize = Size * Normalized.GetAbs();
+	// the change to the origin is half the size changed, in the opposite direction
+	FVector ChangeInOrigin = Normalized * Size * 0.5f * -1.f;
+	AddToSize(ChangeInSize);
+	AddToOrigin(ChangeInOrigin);
+}
+
+void FDynamicBox::SetTranslation(const FVector& Position)
+{
+	mTranslation = Position;
+}
+
+void FDynamicBox::AddToTranslation(const FVector& Delta)
+{
+	mTranslation += Delta;
+}
+
+void FDynamicBox::SetRotation(const FRotator& Rotation)
+{
+	mRotation = Rotation;
+}
+
+void FDynamicBox::SetRotation(const FVector& Facing)
+{
+	mRotation = Facing.Rotation();
+}
+
+void FDynamicBox::SetOrigin(const FVector& Origin)
+{
+	mOrigin = Origin;
+}
+
+void FDynamicBox::SetGeometryOptions(const FGeometryScriptPrimitiveOptions& Options)
+{
+	mGeometryOptions = Options;
+}
+
+void FDynamicBox::SetOriginMode(const EGeometryScriptPrimitiveOriginMode Origin)
+{
+	mOriginMode = Origin;
+}
+
+void FDynamicBox::SetTransform(const FTransform& Transform)
+{
+	mRotation = Transform.GetRotation().Rotator();
+	mTranslation = Transform.GetTranslation();
+	mScale = Transform.GetScale3D();
+}
+
+void FDynamicBox::SetHiddenFaces(EDynamicBoxFaces Faces)
+{
+	mHiddenFaces = Faces;
+}
+
+FVector FDynamicBox::GetSize() const
+{
+	return mSize;
+}
+
+FVector FDynamicBox::GetTranslation() const
+{
+	// an origin of x=-5 is a translation of x=5
+	return (mOrigin * -1) + mTranslation;
+}
+
+FRotator FDynamicBox::GetRotation() const
+{
+	return mRotation;
+}
+
+FTransform FDynamicBox::GetTransform() const
+{
+	return FTransform(
+		FQuat(GetRotation()),
+		GetTranslation(),
+		mScale
+	);
+}
+
+FGeometryScriptPrimitiveOptions FDynamicBox::GetGeometryOptions() const
+{
+	return mGeometryOptions;
+}
+
+EGeometryScriptPrimitiveOriginMode FDynamicBox::GetOriginMode() const
+{
+	return mOriginMode;
+}
+
+EDynamicBoxFaces FDynamicBox::GetHiddenFaces() const
+{
+	return mHiddenFaces;
+}
+
+EDynamicBoxFaces FDynamicBox::GetFaceForDirection(const FVector& Direction)
+{
+	const FVector Abs = Direction.GetAbs();
+	if (Abs.X >= Abs.Y && Abs.X >= Abs.Z) {
+		return Direction.X > 0 ? EDynamicBoxFaces::Front : EDynamicBoxFaces::Back;
+	}
+	if (Abs.Y >= Abs.Z) {
+		return Direction.Y > 0 ? EDynamicBoxFaces::Right : EDynamicBoxFaces::Left;
+	}
+	return Direction.Z > 0 ? EDynamicBoxFaces::Top : EDynamicBoxFaces::Bottom;
+}
+
+void FDynamicBox::GenerateMesh(FDynamicMesh3& Mesh, const bool ApplyTransform) const
+{
+	// This follows UGeometryScriptLibrary_MeshPrimitiveFunctions::AppendBox (with no subdivisions), 
+	// so boxes are identical to the ones UDynamicCube used to build.
+	FGridBoxMeshGenerator Generator;
+	Generator.Box = FOrientedBox3d(FVector3d::Zero(), 0.5 * FVector3d(mSize));
+	Generator.EdgeVertices = FIndex3i(0, 0, 0);
+	Generator.bPolygroupPerQuad = (mGeometryOptions.PolygroupMode == EGeometryScriptPrimitivePolygroupMode::PerQuad);
+	Generator.bScaleUVByAspectRatio = (mGeometryOptions.UVMode == EGeometryScriptPrimitiveUVMode::Uniform);
+	Generator.Generate();
+
+	FDynamicMesh3 BoxMesh(&Generator);
+
+	// hidden faces are dropped while the box is still axis aligned and facing outwards
+	if (mHiddenFaces != EDynamicBoxFaces::None) {
+		TArray<int32> HiddenTriangles;
+		for (int32 TriangleID : BoxMesh.TriangleIndicesItr()) {
+			if (EnumHasAnyFlags(mHiddenFaces, GetFaceForDirection(BoxMesh.GetTriNormal(TriangleID)))) {
+				HiddenTriangles.Add(TriangleID);
+			}
+		}
+		for (int32 TriangleID : HiddenTriangles) {
+			BoxMesh.RemoveTriangle(TriangleID);
+		}
+	}
+
+	if (mGeometryOptions.PolygroupMode == EGeometryScriptPrimitivePolygroupMode::SingleGroup) {
+		for (int32 TriangleID : BoxMesh.TriangleIndicesItr()) {
+			BoxMesh.SetTriangleGroup(TriangleID, 0);
+		}
+	}
+	if (mGeometryOptions.bFlipOrientation) {
+		BoxMesh.ReverseOrientation(true);
+	}
+
+	// tag the faces while the box is still axis aligned, the tag is kept through transforms and appends
+	BoxMesh.EnableAttributes();
+	const int32 FaceClassLayer = FaceClassMaterials::EnableFaceClasses(BoxMesh);
+	FDynamicMeshPolygroupAttribute* FaceClasses = BoxMesh.Attributes()->GetPolygroupLayer(FaceClassLayer);
+	for (int32 TriangleID : BoxMesh.TriangleIndicesItr()) {
+		FaceClasses->SetValue(TriangleID, static_cast<int32>(FaceClassMaterials::ClassifyNormal(BoxMesh.GetTriNormal(TriangleID))));
+	}
+
+	// the generator builds the box about its center
+	if (mOriginMode == EGeometryScriptPrimitiveOriginMode::Base) {
+		MeshTransforms::Translate(BoxMesh, FVector3d(0, 0, 0.5 * mSize.Z));
+	}
+	if (ApplyTransform) {
+		MeshTransforms::ApplyTransform(BoxMesh, FTransformSRT3d(GetTransform()));
+	}
+
+	// appending needs matching attributes on both meshes, material ids start at 0 like every other primitive
+	BoxMesh.Attributes()->EnableMaterialID();
+	if (!Mesh.HasAttributes()) {
+		Mesh.EnableAttributes();
+	}
+	if (!Mesh.Attributes()->HasMaterialID()) {
+		Mesh.Attributes()->EnableMaterialID();
+	}
+	if (!Mesh.HasTriangleGroups()) {
+		Mesh.EnableTriangleGroups();
+	}
+	FaceClassMaterials::EnableFaceClasses(Mesh);
+
+	FMeshIndexMappings Mappings;
+	FDynamicMeshEditor Editor(&Mesh);
+	Editor.AppendMesh(&BoxMesh, Mappings);
+}
+
+void FDynamicBox::Reset()
+{
+	mTranslation = FVector::Zero();
+	mRotation = FRotator(0.f, 0.f, 0.f);
+	mSize = FVector(100.f, 100.f, 100.f);
+	mScale = FVector(1.f);
+	mOrigin = FVector::Zero();
+	mGeometryOptions = FGeometryScriptPrimitiveOptions();
+	mOriginMode = EGeometryScriptPrimitiveOriginMode::Base;
+	mHiddenFaces = EDynamicBoxFaces::None;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "GeometryScript/MeshPrimitiveFunctions.h" // FGeometryScriptPrimitiveOptions
+
+// Faces of a box in its own space, before it is rotated
+enum class EDynamicBoxFaces : uint8
+{
+	None = 0,
+	Front = 1 << 0,		// X+
+	Back = 1 << 1,		// X-
+	Right = 1 << 2,		// Y+
+	Left = 1 << 3,		// Y-
+	Top = 1 << 4,		// Z+
+	Bottom = 1 << 5,	// Z-
+};
+ENUM_CLASS_FLAGS(EDynamicBoxFaces)
+
+/**
+ * Value type box builder with the same inputs as UDynamicCube (size, origin, origin mode, transform) that writes
+ * straight into an FDynamicMesh3.
+ *
+ * It's not a UObject, so it can be created on the stack for every floor, roof, panel and window without adding
+ * anything for the garbage collector to track, and it can be used from any thread.
+ *
+ * HOWTO:
+ *	FDynamicBox Box;
+ *	Box.SetSize(FVector(100.f, 200.f, 300.f));
+ *	Box.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
+ *	Box.SetHiddenFaces(EDynamicBoxFaces::Bottom); // faces that can't be seen aren't emitted
+ *	Box.GenerateMesh(EditMesh);
+ */
+struct PROCEDURALBUILDINGS_API FDynamicBox
+{
+public:
+	void SetSize(const FVector& Size);
+	void AddToSize(const FVector& Delta);
+	void AddToOrigin(const FVector& Delta);
+	void AddToSizeInDirection(const float Size, const FVector& Direction);
+	void SetTranslation(const FVector& Position);
+	void AddToTranslation(const FVector& Delta);
+	void SetRotation(const FRotator& Rotation);
+	void SetRotation(const FVector& Facing);
+	void SetOrigin(const FVector& Origin);
+	void SetGeometryOptions(const FGeometryScriptPrimitiveOptions& Options);
+	void SetOriginMode(const EGeometryScriptPrimitiveOriginMode Origin);
+	void SetTransform(const FTransform& Transform);
+	void SetHiddenFaces(EDynamicBoxFaces Faces);
+
+	FVector GetSize() const;
+	FVector GetTranslation() const;
+	FRotator GetRotation() const;
+	FTransform GetTransform() const;
+	FGeometryScriptPrimitiveOptions GetGeometryOptions() const;
+	EGeometryScriptPrimitiveOriginMode GetOriginMode() const;
+	EDynamicBoxFaces GetHiddenFaces() const;
+
+	// The face of an axis aligned box facing `Direction` (eg. FVector::ForwardVector is Front)
+	static EDynamicBoxFaces GetFaceForDirection(const FVector& Direction);
+
+	// Append the box to `Mesh`, the mesh's attributes (normals, uvs, material ids, polygroups) are enabled if needed.
+	void GenerateMesh(UE::Geometry::FDynamicMesh3& Mesh, const bool ApplyTransform = true) const;
+
+	void Reset();
+
+private:
+	FVector mScale = FVector(1.f);
+	FVector mSize = FVector(100.f, 100.f, 100.f);
+	FVector mOrigin = FVector::Zero();
+	FVector mTranslation = FVector::Zero();
+	FRotator mRotation = FRotator();
+	FGeometryScriptPrimitiveOptions mGeometryOptions;
+	EGeometryScriptPrimitiveOriginMode mOriginMode = EGeometryScriptPrimitiveOriginMode::Base;
+	EDynamicBoxFaces mHiddenFaces = EDynamicBoxFaces::None;
+};
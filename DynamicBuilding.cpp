@@ -1,25 +1,48 @@
 
 
 #include "DynamicBuilding.h"
-#include <functional> // std::hash
-#include <string>
 #include "BuildingEnums.h"
 #include "Math/UnitConversion.h"
-#include "GeometryScript/MeshPrimitiveFunctions.h"
-#include "GeometryScript/MeshBasicEditFunctions.h"
-#include "GeometryScript/MeshTransformFunctions.h"
-#include "GeometryScript/MeshQueryFunctions.h"
-#include "GeometryScript/MeshUVFunctions.h"
-#include "GeometryScript/MeshMaterialFunctions.h"
-#include "DynamicMesh/MeshTransforms.h"
-#include "DynamicMesh/DynamicMeshAttributeSet.h" // FDynamicMeshMaterialAttribute
+#include "Async/Async.h"
+#include "Components/DynamicMeshComponent.h"
 #include "DynamicMesh/DynamicMesh3.h"
 #include "UDynamicMesh.h"
-#include "DynamicCube.h"
-#include "BooleanGrid.h"
-#include "LatticeGrid.h"
-#include "UVUtilities.h"
+#include "BuildingGenerator.h"
+#include "BuildingFragmentCache.h"
+#include "BuildingInstances.h"
+#include "BuildingMeshPool.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "UObject/ConstructorHelpers.h"
+#include "Components/StaticMeshComponent.h"
+#include "PhysicsEngine/AggregateGeom.h"
+#include "BuildingExport.h"
+#include "BuildingStats.h"
+
+
+// Run the generator once per LOD into the scratch mesh, LOD 0 also writes the instances. Scratch meshes come from
+// `MeshPool`, nullptr gives each LOD its own pool (game thread only). Returns false if generation was cancelled.
+static bool GenerateLODs(FDynamicBuildingRecipe& Recipe, int32 NumLODs, const TArray<TSharedPtr<FBuildingFragmentCache, ESPMode::ThreadSafe>>& Caches, TFunction<bool()> ShouldCancel, FBuildingMeshPool* MeshPool, UDynamicMesh* ScratchMesh, TArray<FBuildingLODMesh>& OutLODs, FBuildingInstances& OutInstances)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(ADynamicBuilding::GenerateLODs);
+    OutLODs.SetNum(NumLODs);
+    for (int32 LODIndex = 0; LODIndex < NumLODs; LODIndex++) {
+        BuildingGenerator Generator = BuildingGenerator(&Recipe);
+        Generator.SetLOD(LODIndex);
+        Generator.SetFragmentCache(Caches[LODIndex]);
+        Generator.SetCancelCallback(ShouldCancel);
+        Generator.SetMeshPool(MeshPool);
+        if (!Generator.Generate(ScratchMesh, OutLODs[LODIndex].Materials, LODIndex == 0 ? &OutInstances : nullptr)) {
+            return false;
+        }
 
+        ScratchMesh->EditMesh([&](FDynamicMesh3& EditMesh)
+        {
+            OutLODs[LODIndex].Mesh = MoveTemp(EditMesh);
+        }, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, true);
+    }
+    return true;
+}
 
 void ADynamicBuilding::ReceiveRebuildAll()
 {
@@ -28,13 +51,39 @@ void ADynamicBuilding::ReceiveRebuildAll()
 	// options, I'll dynamically call the methods of construction depending on what features are selected
 	// (or something like that so it's more flexible in general)
     Generate();
-    UE_LOG(LogTemp, Warning, TEXT("Procedural Generation Complete"));
+    UE_LOG(LogBuildingGeneration, Log, TEXT("Procedural Generation Complete"));
 }
 
 void ADynamicBuilding::ReceieveExportMesh()
 {
-    UE_LOG(LogTemp, Warning, TEXT("Export mesh TODO"));
-    
+    BuildingExport::ExportBuildings({ this }, ExportPath);
+}
+
+void ADynamicBuilding::ReceiveExportAllMeshes()
+{
+    BuildingExport::ExportWorld(GetWorld(), ExportPath);
+}
+
+void ADynamicBuilding::UseExportedMesh(UStaticMesh* StaticMesh)
+{
+    if (StaticMesh == nullptr || ExportedMeshComponent == nullptr) {
+        return;
+    }
+    ExportedMesh = StaticMesh;
+    ExportedMeshComponent->SetStaticMesh(StaticMesh);
+    ExportedMeshComponent->SetVisibility(true);
+
+    // the static mesh has every LOD, the instanced details stay on their own components
+    for (int32 LODIndex = 0; LODIndex < BuildingGenerator::MAX_LODS; LODIndex++) {
+        UDynamicMeshComponent* component = GetLODComponent(LODIndex);
+        if (component == nullptr || component->GetDynamicMesh() == nullptr) {
+            continue;
+        }
+        component->GetDynamicMesh()->Reset();
+        component->SetVisibility(false);
+    }
+    LODTriangleCounts.Reset();
+    MarkPackageDirty();
 }
 
 
@@ -42,6 +91,33 @@ ADynamicBuilding::ADynamicBuilding(const FObjectInitializer& ObjectInitializer)
     : Super(ObjectInitializer)
 {
     PrimaryActorTick.bCanEverTick = false;
+    for (int32 LODIndex = 0; LODIndex < BuildingGenerator::MAX_LODS; LODIndex++) {
+        FragmentCaches.Add(MakeShared<FBuildingFragmentCache, ESPMode::ThreadSafe>());
+    }
+
+    // the coarser LODs are shown by their own components, each one is only drawn in its distance range
+    LOD1MeshComponent = CreateDefaultSubobject<UDynamicMeshComponent>(TEXT("LOD1MeshComponent"));
+    LOD2MeshComponent = CreateDefaultSubobject<UDynamicMeshComponent>(TEXT("LOD2MeshComponent"));
+    LOD1MeshComponent->SetupAttachment(GetRootComponent());
+    LOD2MeshComponent->SetupAttachment(GetRootComponent());
+
+    // the unit meshes default to the engine basic shapes, they match the FBuildingInstances conventions
+    static ConstructorHelpers::FObjectFinder<UStaticMesh> CubeMesh(TEXT("/Engine/BasicShapes/Cube.Cube"));
+    static ConstructorHelpers::FObjectFinder<UStaticMesh> PlaneMesh(TEXT("/Engine/BasicShapes/Plane.Plane"));
+    WindowInsetMesh = CubeMesh.Object;
+    WindowGlassMesh = PlaneMesh.Object;
+    LatticeBarMesh = CubeMesh.Object;
+
+    WindowInsetInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("WindowInsetInstances"));
+    WindowGlassInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("WindowGlassInstances"));
+    LatticeBarInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("LatticeBarInstances"));
+    for (UHierarchicalInstancedStaticMeshComponent* Instances : { WindowInsetInstances, WindowGlassInstances, LatticeBarInstances }) {
+        Instances->SetupAttachment(GetRootComponent());
+    }
+
+    // shows the static mesh asset the building was exported to (see UseExportedMesh)
+    ExportedMeshComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ExportedMeshComponent"));
+    ExportedMeshComponent->SetupAttachment(GetRootComponent());
 }
 
 
@@ -53,8 +129,8 @@ void ADynamicBuilding::PostEditChangeProperty(FPropertyChangedEvent& PropertyCha
         const FProperty* Property = PropertyChangedEvent.Property;
         const FName PropertyName(Property->GetFName());
         FName Category = FName(*(Property->GetMetaData(FName("Category"))));
-        //UE_LOG(LogTemp, Warning, TEXT("Property Changed"));
-        Generate(); // todo refactor to set timer...
+        // dragging a slider fires this many times a second, coalesce the edits into one rebuild.
+        ScheduleRebuild();
 
         // GET_MEMBER_NAME_CHECKED(ADynamicBuilding, mWidth)
 
@@ -62,690 +138,325 @@ void ADynamicBuilding::PostEditChangeProperty(FPropertyChangedEvent& PropertyCha
     Super::PostEditChangeProperty(PropertyChangedEvent);
 }
 
+void ADynamicBuilding::BeginDestroy()
+{
+    // a pending rebuild must not fire on a destroyed building, and a running task stops early
+    if (RebuildTickerHandle.IsValid()) {
+        FTSTicker::GetCoreTicker().RemoveTicker(RebuildTickerHandle);
+        RebuildTickerHandle.Reset();
+    }
+    GenerationToken->Increment();
+    Super::BeginDestroy();
+}
+
 void ADynamicBuilding::Generate()
 {
     UDynamicMeshComponent* component = GetDynamicMeshComponent();
-    UDynamicMesh* Mesh = component->GetDynamicMesh();
-    if (Mesh == nullptr) {
+    if (component == nullptr || component->GetDynamicMesh() == nullptr) {
         return;
     }
-    if (!Mesh->IsValidLowLevel()) {
+
+    if (bGenerateAsync) {
+        GenerateAsync();
         return;
     }
 
-    // Reset Mesh Geometry...
-    Mesh->Reset();
-
-
-    // Reset material slots
-    MaterialSet.Empty();
+    // any background task still running is now stale, its result will be thrown away.
+    GenerationToken->Increment();
 
-    // all seed based randomization is based on FRandomStream
-    // this keeps random parts of the generation consistent unless the seed is changed.
-    FRandomStream RandomStream = FRandomStream(RandomSeed);
+    // build into a scratch mesh and swap it in, the component only sees a single change.
+    FDynamicBuildingRecipe Recipe = MakeRecipe();
+    UDynamicMesh* ScratchMesh = AllocateComputeMesh();
+    TArray<FBuildingLODMesh> GeneratedLODs;
+    FBuildingInstances GeneratedInstances;
 
-    FGeometryScriptPrimitiveOptions options = FGeometryScriptPrimitiveOptions();
-    options.bFlipOrientation = false;
-    options.PolygroupMode = EGeometryScriptPrimitivePolygroupMode::PerFace;
-    options.UVMode = EGeometryScriptPrimitiveUVMode::Uniform;
+    GenerateLODs(Recipe, GetNumLODs(), FragmentCaches, nullptr, nullptr, ScratchMesh, GeneratedLODs, GeneratedInstances);
+    ReleaseComputeMesh(ScratchMesh);
 
-    FTransform transform = FTransform();
-
-    uint32 steps = 0; // TODO?
-
-    FVector InEngineUnits = mBuildingSize;
+    ApplyGeneratedMesh(MoveTemp(GeneratedLODs), MoveTemp(GeneratedInstances));
+}
 
-    // Create the building core geometry
-    UGeometryScriptLibrary_MeshPrimitiveFunctions::AppendBox(
-        Mesh,
-        options,
-        transform,
-        InEngineUnits.X,
-        InEngineUnits.Y,
-        InEngineUnits.Z,
-        steps,
-        steps,
-        steps,
-        EGeometryScriptPrimitiveOriginMode::Base,
-        nullptr
-    );
+void ADynamicBuilding::GenerateAsync()
+{
+    // Taking a new token supersedes any task that is already running, it will notice and stop early.
+    // We don't wait for it, the new task starts straight away from a fresh snapshot.
+    const int32 Token = GenerationToken->Increment();
+    TSharedRef<FThreadSafeCounter, ESPMode::ThreadSafe> LatestToken = GenerationToken;
+    NumGenerationsInFlight++;
 
-    FBox BuildingBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(Mesh);
+    // the task works from a copy of the properties so edits made while it runs can't affect it.
+    TWeakObjectPtr<ADynamicBuilding> WeakThis(this);
+    FDynamicBuildingRecipe Recipe = MakeRecipe();
+    const int32 NumLODsToBuild = GetNumLODs();
 
-    // ============== Mesh MATERIALS ==========================
+    TArray<TSharedPtr<FBuildingFragmentCache, ESPMode::ThreadSafe>> Caches = FragmentCaches;
 
-    // ------------- TOP / BOTTOM ----------------------------
-    // todo move this to a function
-    if (!MaterialSlots.Contains(EBuildingMaterialSlots::All)
-        && MaterialSlots.Contains(EBuildingMaterialSlots::Top_Bottom)) {
-        // allocate a new material id
-        int32 TopBotMatId = MaterialSet.Num();
-        MaterialSet.Add(MaterialSlots[EBuildingMaterialSlots::Top_Bottom]);
-        UE_LOG(LogTemp, Display, TEXT("Building MatId[%i] (Top_Bottom)"), TopBotMatId);
+    // UObjects can't be created on the worker, the scratch meshes of the whole run are created here and kept alive by
+    // the pool (the +1 is the mesh each LOD is generated into). The pool goes back to the game thread to be destroyed.
+    TSharedPtr<FBuildingMeshPool, ESPMode::ThreadSafe> MeshPool = MakeShared<FBuildingMeshPool, ESPMode::ThreadSafe>();
+    MeshPool->Reserve(BuildingGenerator::GetNumScratchMeshes(BuildingGenerator(&Recipe).MakeLayout().Boxes.Num()) + 1);
 
-        // find geometry by face and assign material id
-        TSet<FVector> UpDownVectors = TSet<FVector>();
-        UpDownVectors.Add(FVector::UpVector);
-        UpDownVectors.Add(FVector::DownVector);
-        Mesh->EditMesh([&](FDynamicMesh3& Mesh)
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Recipe, NumLODsToBuild, Token, LatestToken, Caches, MeshPool]() mutable
+    {
+        TArray<FBuildingLODMesh> GeneratedLODs;
+        FBuildingInstances GeneratedInstances;
+        bool bCompleted = false;
         {
-            // may need to Mesh.EnableAttributes();
-            // Mesh.Attributes()->EnableMaterialID();
-            using namespace UE::Geometry;
-            FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.Attributes()->GetMaterialID();
-            if (MaterialIDs != nullptr) {
-                // iterate through all the triangles of the mesh
-                for (int32 TriangleID : Mesh.TriangleIndicesItr())
-                {
-                    FVector3d TriNormal = Mesh.GetTriNormal(TriangleID);
-                    if (!UpDownVectors.Contains(TriNormal)) {
-                        continue;
-                    }
-                    MaterialIDs->SetValue(TriangleID, TopBotMatId);
-                }
-            }
-
-        }, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
-
-
-        FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BuildingBounds, UVScaleMode, UVOriginMode, &RandomStream, UVSize);
-        UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-            Mesh,
-            TopBotMatId,
-            UVTransform,  // uses GetScale3D() to determine the size of the projection, you usually want this the size of the mesh itself.
-            2); // min island tri count
-    }
+            FScopedBuildingMesh ScratchMesh(MeshPool.Get());
+            bCompleted = GenerateLODs(Recipe, NumLODsToBuild, Caches, [Token, LatestToken]()
+            {
+                return LatestToken->GetValue() != Token;
+            }, MeshPool.Get(), ScratchMesh.Get(), GeneratedLODs, GeneratedInstances);
+        }
 
-    // ------------- SIDES -----------------------------------
-    if (!MaterialSlots.Contains(EBuildingMaterialSlots::All)
-        && MaterialSlots.Contains(EBuildingMaterialSlots::All_Sides)) {
-        // allocate a new material id
-        int32 SidesMatId = MaterialSet.Num();
-        MaterialSet.Add(MaterialSlots[EBuildingMaterialSlots::All_Sides]);
-        UE_LOG(LogTemp, Display, TEXT("Building MatId[%i] (All_Sides)"), SidesMatId);
-
-        // find geometry by face and assign material id
-        TSet<FVector> SideVectors = TSet<FVector>(mPanelOptions.GetSideVectors());
-        Mesh->EditMesh([&](FDynamicMesh3& Mesh)
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Token, bCompleted, MeshPool = MoveTemp(MeshPool), GeneratedLODs = MoveTemp(GeneratedLODs), GeneratedInstances = MoveTemp(GeneratedInstances)]() mutable
         {
-            // may need to Mesh.EnableAttributes();
-            // Mesh.Attributes()->EnableMaterialID();
-            using namespace UE::Geometry;
-            FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.Attributes()->GetMaterialID();
-            if (MaterialIDs != nullptr) {
-                // iterate through all the triangles of the mesh
-                for (int32 TriangleID : Mesh.TriangleIndicesItr())
-                {
-                    FVector3d TriNormal = Mesh.GetTriNormal(TriangleID);
-                    if (!SideVectors.Contains(TriNormal)) {
-                        continue;
-                    }
-                    MaterialIDs->SetValue(TriangleID, SidesMatId);
-                }
+            MeshPool.Reset();
+            ADynamicBuilding* Building = WeakThis.Get();
+            if (Building == nullptr) {
+                return;
             }
 
-        }, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
-
+            Building->NumGenerationsInFlight--;
 
-        FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BuildingBounds, UVScaleMode, UVOriginMode, &RandomStream, UVSize);
-        UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-            Mesh,
-            SidesMatId,
-            UVTransform,  // uses GetScale3D() to determine the size of the projection, you usually want this the size of the mesh itself.
-            2); // min island tri count
-    }
+            // a newer edit has superseded this result (or the task stopped early), throw it away.
+            if (!bCompleted || Building->GenerationToken->GetValue() != Token) {
+                UE_LOG(LogBuildingGeneration, Log, TEXT("Async Procedural Generation [%i] superseded, discarding result"), Token);
+                return;
+            }
 
-    int32 BuildingAllMatId = -1;
-    if (MaterialSlots.Contains(EBuildingMaterialSlots::All)) {
-        BuildingAllMatId = MaterialSet.Num();
-        MaterialSet.Add(MaterialSlots[EBuildingMaterialSlots::All]);
-        UE_LOG(LogTemp, Display, TEXT("Building MatId[%i] (All)"), BuildingAllMatId);
-    }
-    else if (MaterialSlots.IsEmpty()) {
-        UE_LOG(LogTemp, Warning, TEXT("LatticeGrid MaterialSlots empty, MaterialID 0 will be applied to mesh as a default"));
-        BuildingAllMatId = 0;
-    }
+            Building->ApplyGeneratedMesh(MoveTemp(GeneratedLODs), MoveTemp(GeneratedInstances));
+            UE_LOG(LogBuildingGeneration, Log, TEXT("Async Procedural Generation [%i] Complete"), Token);
+        });
+    });
+}
 
-    // map the whole cube
-    if (BuildingAllMatId != -1) {
-        // change the default material id, to the assigned material.
-        UGeometryScriptLibrary_MeshMaterialFunctions::RemapMaterialIDs(
-            Mesh,
-            0,
-            BuildingAllMatId
-        );
-
-        FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BuildingBounds, UVScaleMode, UVOriginMode, &RandomStream, UVSize);
-        UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-            Mesh,
-            BuildingAllMatId,
-            UVTransform,  // uses GetScale3D() to determine the size of the projection, you usually want this the size of the mesh itself.
-            2); // min island tri count
+void ADynamicBuilding::ScheduleRebuild()
+{
+    // restart the quiet period, only the last request in a burst actually rebuilds.
+    if (RebuildTickerHandle.IsValid()) {
+        FTSTicker::GetCoreTicker().RemoveTicker(RebuildTickerHandle);
+        RebuildTickerHandle.Reset();
     }
 
-    // ===========================================================================================================
-    // ===========================================================================================================
-    // ===========================================================================================================
-
-    const float FloorHeight = mBoxOptions.FloorHeight;
-    const float VerticalSpacing = mBoxOptions.VerticalSpacing;
-    const int32 BuildingXSize = mBuildingSize.X;
-    const int32 BuildingYSize = mBuildingSize.Y;
-    const int32 BuildingHeight = mBuildingSize.Z;
-    
-    const TRange<int32> NumFloorsRange = TRange<int32>::Inclusive(
-        FMath::Max(mBoxOptions.NumFloors, 1),
-        mBoxOptions.NumFloorsVariance + FMath::Max(mBoxOptions.NumFloors, 1)
-    );
-
-    
-    FVector2D BoxScale = FVector2D(mBoxOptions.Scale.X * 0.01, mBoxOptions.Scale.Y * 0.01);
-    FVector2D BoxVarySize = mBoxOptions.VarySizePercent * 0.01;
-
-    FVector2D BoxBaseSize = FVector2D(BuildingXSize * BoxScale.X, BuildingYSize * BoxScale.Y);
-
-    const TRange<int32> BoxSizeXRange = TRange<int32>::Inclusive(
-        FMath::Max(BoxBaseSize.X, 1),
-        FMath::Max(BoxBaseSize.X + (BoxBaseSize.X * BoxVarySize.X), 1)
-    );
-
-    const TRange<int32> BoxSizeYRange = TRange<int32>::Inclusive(
-        FMath::Max(BoxBaseSize.Y, 1),
-        FMath::Max(BoxBaseSize.Y + (BoxBaseSize.Y * BoxVarySize.Y), 1)
-    );
-
-    const TRange<int32> BoxHeightRange = TRange<int32>::Inclusive(
-        NumFloorsRange.GetLowerBoundValue() * FloorHeight, 
-        NumFloorsRange.GetUpperBoundValue() * FloorHeight
+    RebuildTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateUObject(this, &ADynamicBuilding::RunScheduledRebuild),
+        FMath::Max(RebuildDelay, 0.f)
     );
+}
 
-    int32 MaxNumBoxes = 1;
-    int32 UsableBuildingHeight = BuildingHeight;
-    if (mBoxOptions.bExplicitNumberOfBoxes) {
-        MaxNumBoxes = mBoxOptions.NumberOfBoxes;
-    } 
-    else if (mBoxOptions.bSpecifyVerticalSpawnRange) {
-        UsableBuildingHeight = (mBoxOptions.VerticalSpawnPercent * 0.01) * BuildingHeight;
-        MaxNumBoxes = FMath::Max(UsableBuildingHeight / BoxHeightRange.GetUpperBoundValue(), 1);
-    }
-    else {
-        MaxNumBoxes = FMath::Max(BuildingHeight / BoxHeightRange.GetUpperBoundValue(), 1);
+bool ADynamicBuilding::RunScheduledRebuild(float DeltaTime)
+{
+    RebuildTickerHandle.Reset();
+    // deleted (or sitting in the undo buffer) since the rebuild was scheduled
+    if (IsTemplate() || !IsValid(this)) {
+        return false;
     }
+    Generate();
+    return false; // don't fire again
+}
 
-    UE_LOG(LogTemp, Warning, TEXT("GenerateBoxes - MaxNumBoxes = %i"), MaxNumBoxes);
-
-// TODO switch to seed based iteration / generation
-// TODO consider mirror, repeat, vertical alignment, vertical spawn percent.
-// TODO horizontal alignment, offset
-// TODO switch percents to be meters
-// TODO panels need a control-arm holding them to the building
-// TODO switch the building itself to be composed of meshes - one big mesh creates intersections, and other problems.
-// TODO consider new settings min-building-core-size, building-core-shrinks-with-floors
-// TODO add material channels
-// TODO add a delay to rebuilding
-// TODO refactor panel logic
-// TODO refactor roof logic
-// TODO create Templated Container for repition modes
-//   
-
-    double CumulativeBoxHeight = 0.f;
-    FTransform EmptyTransform = FTransform();
-
-    UDynamicMesh* BoxesMesh = AllocateComputeMesh();
-    UDynamicMesh* BoxMesh = AllocateComputeMesh();
-    UDynamicMesh* FloorMesh = AllocateComputeMesh();
-    UDynamicMesh* RoofMesh = AllocateComputeMesh();
-    UDynamicMesh* PanelMesh = AllocateComputeMesh();
-    UDynamicMesh* TempMesh = AllocateComputeMesh();
-    
-    auto BoxMeshes = TArray<UDynamicMesh*>();
-    BoxMeshes.Add(BoxMesh);
-    BoxMeshes.Add(FloorMesh);
-    BoxMeshes.Add(RoofMesh);
-    BoxMeshes.Add(PanelMesh);
-    
-
-    for (int BoxNum = 0; BoxNum < MaxNumBoxes; BoxNum++) {
-        // reset our temp mesh so it contains no geometry
-        BoxMesh->Reset();
-        FloorMesh->Reset();
-        RoofMesh->Reset();
-        PanelMesh->Reset();
-
-        TSet<FVector> SidePanelVectors = mPanelOptions.GetSidePanelVectors();
-
-        // ================ BOX SIZE / NUM FLOORS ===================
-        FVector BoxSizeActual = FVector::Zero(); // holds the calculated size of the box after modifiers like scaling variation and randomness have been applied
-        int NumFloors = mBoxOptions.NumFloors;
-        if (mBoxOptions.NumFloorsVariance > 0) {
-            NumFloors = RandomStream.RandRange(NumFloorsRange.GetLowerBoundValue(), NumFloorsRange.GetUpperBoundValue());
-            BoxSizeActual.Z = FloorHeight * NumFloors;
-        }
-        else {
-            BoxSizeActual.Z = BoxHeightRange.GetUpperBoundValue();
-        }
-
-        // vary the box size by percent
-        if (mBoxOptions.bVaryBoxSizePercent) {
-            BoxSizeActual.X = RandomStream.FRandRange(BoxSizeXRange.GetLowerBoundValue(), BoxSizeXRange.GetUpperBoundValue());
-            BoxSizeActual.Y = RandomStream.FRandRange(BoxSizeYRange.GetLowerBoundValue(), BoxSizeYRange.GetUpperBoundValue());
+void ADynamicBuilding::ApplyGeneratedMesh(TArray<FBuildingLODMesh>&& GeneratedLODs, FBuildingInstances&& GeneratedInstances)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(ADynamicBuilding::ApplyGeneratedMesh);
+    // a regenerated building no longer matches its exported asset
+    if (ExportedMeshComponent != nullptr) {
+        ExportedMeshComponent->SetStaticMesh(nullptr);
+        ExportedMeshComponent->SetVisibility(false);
+    }
+    ExportedMesh = nullptr;
+
+    LODTriangleCounts.Reset();
+    LODTriangleCounts.SetNumZeroed(GeneratedLODs.Num());
+    for (int32 LODIndex = 0; LODIndex < BuildingGenerator::MAX_LODS; LODIndex++) {
+        UDynamicMeshComponent* component = GetLODComponent(LODIndex);
+        if (component == nullptr) {
+            continue;
         }
-        else {
-            BoxSizeActual.X = BoxBaseSize.X;
-            BoxSizeActual.Y = BoxBaseSize.Y;
+        UDynamicMesh* Mesh = component->GetDynamicMesh();
+        if (Mesh == nullptr) {
+            continue;
         }
-
-        // ================ FLOOR PANEL ===========================
-        FBox FloorBounds;
-        if (mPanelOptions.bPanelFloor) {
-            FSizeAndTransform Floor = mPanelOptions.GetFloorSizeAndTransform(BoxSizeActual);
-            UDynamicCube* Cube = NewObject<UDynamicCube>(this);
-            Cube->SetSize(Floor.Size);
-            Cube->GenerateMesh(FloorMesh);
-
-            /*
-            UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-                BoxMesh,
-                FloorMesh,
-                Floor.Transform
-            );*/
-
-            // TODO this logic is replaced by bounding size logic
-            //BoxHeight += Floor.Size.Z;
-            //BoxHeight += Floor.Transform.GetTranslation().Z;
-
-            // transform the floor in place, it is now in the correct relative position.
-            UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(FloorMesh, Floor.Transform);
-            // GetMeshBoundingBox - this means the implementation of creating the floor mesh can change and we'll still know how to 
-            // space/stack things properly.
-            FloorBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(FloorMesh);
+        if (!Mesh->IsValidLowLevel()) {
+            continue;
         }
 
-        // ================ BOX GEOMETRY ==========================
-        UGeometryScriptLibrary_MeshPrimitiveFunctions::AppendBox(
-            BoxMesh,
-            FGeometryScriptPrimitiveOptions(),
-            FTransform(FVector(0.f, 0.f, FloorBounds.Max.Z)),
-            BoxSizeActual.X,
-            BoxSizeActual.Y,
-            BoxSizeActual.Z,
-            0,
-            0,
-            0
-        );
-
-        FBox BoxBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(BoxMesh);
-
-        // ============== BOX MATERIALS ==========================
-        
-        // ------------- TOP / BOTTOM ----------------------------
-        // todo move this to a function
-        if (!mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::All)
-            && mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::Top_Bottom)) {
-            // allocate a new material id
-            int32 TopBotMatId = MaterialSet.Num();
-            MaterialSet.Add(mBoxOptions.MaterialSlots[EBuildingBoxMaterialSlots::Top_Bottom]);
-            UE_LOG(LogTemp, Display, TEXT("Box MatId[%i] (All_Sides)"), TopBotMatId);
-
-            // find geometry by face and assign material id
-            TSet<FVector> UpDownVectors = TSet<FVector>();
-            UpDownVectors.Add(FVector::UpVector);
-            UpDownVectors.Add(FVector::DownVector);
-            BoxMesh->EditMesh([&](FDynamicMesh3& Mesh)
-            {
-                // may need to Mesh.EnableAttributes();
-                // Mesh.Attributes()->EnableMaterialID();
-                using namespace UE::Geometry;
-                FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.Attributes()->GetMaterialID();
-                if (MaterialIDs != nullptr) {
-                    // iterate through all the triangles of the mesh
-                    for (int32 TriangleID : Mesh.TriangleIndicesItr())
-                    {
-                        FVector3d TriNormal = Mesh.GetTriNormal(TriangleID);
-                        if (!UpDownVectors.Contains(TriNormal)) {
-                            continue;
-                        }
-                        MaterialIDs->SetValue(TriangleID, TopBotMatId);
-                    }
-                }
-
-            }, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
-
-
-            FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BoxBounds, mBoxOptions.UVScaleMode, mBoxOptions.UVOriginMode, &RandomStream, mBoxOptions.UVSize);
-            UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-                BoxMesh,
-                TopBotMatId,
-                UVTransform,  // uses GetScale3D() to determine the size of the projection, you usually want this the size of the mesh itself.
-                2); // min island tri count
+        // LODs that weren't generated are emptied and hidden
+        if (!GeneratedLODs.IsValidIndex(LODIndex)) {
+            Mesh->Reset();
+            component->SetVisibility(false);
+            continue;
         }
 
-        // ------------- SIDES -----------------------------------
-        if (!mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::All)
-            && mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::All_Sides)) {
-            // allocate a new material id
-            int32 SidesMatId = MaterialSet.Num();
-            MaterialSet.Add(mBoxOptions.MaterialSlots[EBuildingBoxMaterialSlots::All_Sides]);
-            UE_LOG(LogTemp, Display, TEXT("Box MatId[%i] (All_Sides)"), SidesMatId);
-
-            // find geometry by face and assign material id
-            TSet<FVector> SideVectors = TSet<FVector>(mPanelOptions.GetSideVectors());
-            BoxMesh->EditMesh([&](FDynamicMesh3& Mesh)
-            {
-                // may need to Mesh.EnableAttributes();
-                // Mesh.Attributes()->EnableMaterialID();
-                using namespace UE::Geometry;
-                FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.Attributes()->GetMaterialID();
-                if (MaterialIDs != nullptr) {
-                    // iterate through all the triangles of the mesh
-                    for (int32 TriangleID : Mesh.TriangleIndicesItr())
-                    {
-                        FVector3d TriNormal = Mesh.GetTriNormal(TriangleID);
-                        if (!SideVectors.Contains(TriNormal)) {
-                            continue;
-                        }
-                        MaterialIDs->SetValue(TriangleID, SidesMatId);
-                    }
-                }
-
-            }, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
-
-
-            FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BoxBounds, mBoxOptions.UVScaleMode, mBoxOptions.UVOriginMode, &RandomStream, mBoxOptions.UVSize);
-            UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-                BoxMesh,
-                SidesMatId,
-                UVTransform,  // uses GetScale3D() to determine the size of the projection, you usually want this the size of the mesh itself.
-                2); // min island tri count
-        }
+        FBuildingLODMesh& LOD = GeneratedLODs[LODIndex];
+        LODTriangleCounts[LODIndex] = LOD.Mesh.TriangleCount();
+        Mesh->SetMesh(MoveTemp(LOD.Mesh));
 
-        int8 GlobalMatId = -1;
-        if (mBoxOptions.MaterialSlots.Contains(EBuildingBoxMaterialSlots::All)) {
-            GlobalMatId = MaterialSet.Num();
-            MaterialSet.Add(mBoxOptions.MaterialSlots[EBuildingBoxMaterialSlots::All]);
-            UE_LOG(LogTemp, Display, TEXT("Box MatId[%i] (All)"), GlobalMatId);
+        component->SetNumMaterials(0);
+        if (LODIndex == 0) {
+            MaterialSet = MoveTemp(LOD.Materials);
+            component->ConfigureMaterialSet(MaterialSet);
         }
-        else if (mBoxOptions.MaterialSlots.IsEmpty()) {
-            UE_LOG(LogTemp, Warning, TEXT("Box MaterialSlots empty, MaterialID 0 will be applied to mesh as a default"));
-            GlobalMatId = 0;
-        }
-
-        // map the whole cube
-        if (GlobalMatId != -1) {
-            // change the default material id, to the assigned material.
-            UGeometryScriptLibrary_MeshMaterialFunctions::RemapMaterialIDs(
-                BoxMesh,
-                0,
-                GlobalMatId
-            );
-
-            FTransform UVTransform = UUVUtilities::GetMeshUVTransform(BoxBounds, mBoxOptions.UVScaleMode, mBoxOptions.UVOriginMode, &RandomStream, mBoxOptions.UVSize);
-            UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-                BoxMesh,
-                GlobalMatId,
-                UVTransform,  // uses GetScale3D() to determine the size of the projection, you usually want this the size of the mesh itself.
-                2); // min island tri count
+        else {
+            component->ConfigureMaterialSet(LOD.Materials);
         }
 
-        
-
-
-        // TODO add OPTIONAL chamfer
-
-        
-
-        // ================ BOX LATTICE ==========================
-        if (mBoxOptions.bHasFraming) {
-            LatticeGrid Lattice = LatticeGrid(&(mBoxOptions.FramingOptions));
-            // HACK!!!!!!!!!
-            // The logic for the lattice is not currently capable of being drawn on any side of the mesh, therefore
-            // we must rotate the mesh so the lattice can be applied on each side.
-            FVector DefaultFacing = FVector::ForwardVector;
-            FVector CurrentFacing = DefaultFacing;
-            for (auto& Direction : mPanelOptions.GetSideVectors()) {
-                // const float Angle = FMath::Acos(FVector::DotProduct(Direction, CurrentFacing));
-                FRotator DeltaRotation = (Direction.Rotation() - CurrentFacing.Rotation());
-                DeltaRotation.Normalize();
+        // each LOD is drawn from the distance the previous one stops at, the last one has no limit
+        component->SetVisibility(true);
+        component->MinDrawDistance = (LODIndex > 0) ? GetLODDistance(LODIndex) : 0.f;
+        component->SetCullDistance(GeneratedLODs.IsValidIndex(LODIndex + 1) ? GetLODDistance(LODIndex + 1) : 0.f);
+        component->MarkRenderStateDirty();
 
-                if (DeltaRotation.Yaw != 0.f) {
-                    UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(BoxMesh, FTransform(FQuat(DeltaRotation)));
-                }
-
-                UE_LOG(LogTemp, Warning, TEXT("Box Rotation - Angle: %f, Current: %s, Direction: %s"), DeltaRotation.Yaw, *(CurrentFacing.ToString()), *(Direction.ToString()));
-                CurrentFacing = Direction;
-                Lattice.ApplyLattice(BoxMesh, MaterialSet);
-            }
+        UE_LOG(LogBuildingGeneration, Log, TEXT("Procedural Generation LOD%i - %i tris"), LODIndex, LODTriangleCounts[LODIndex]);
+    }
 
-            // restore the orientation of the box to its default
-            FRotator RestoreRotation = (CurrentFacing.Rotation() - DefaultFacing.Rotation());
-            RestoreRotation.Normalize();
-            UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(BoxMesh, FTransform(FQuat(RestoreRotation)));
+    ApplyGeneratedInstances(GeneratedInstances, GetLODTriangleCount(0));
+    ApplyCollision(GeneratedInstances.CollisionBoxes);
+}
 
+void ADynamicBuilding::ApplyCollision(const TArray<FTransform>& CollisionBoxes)
+{
+    UDynamicMeshComponent* component = GetDynamicMeshComponent();
+    if (component == nullptr) {
+        return;
+    }
+    if (!bSimpleCollision) {
+        // only undo what we did, a component that never had our boxes keeps its own collision settings
+        if (bSimpleCollisionApplied) {
+            component->bEnableComplexCollision = bSavedEnableComplexCollision;
+            component->CollisionType = SavedCollisionType;
+            component->bUseAsyncCooking = bSavedUseAsyncCooking;
+            component->SetSimpleCollisionShapes(FKAggregateGeom(), true);
+            bSimpleCollisionApplied = false;
+            UE_LOG(LogBuildingGeneration, Log, TEXT("Simple Collision - removed"));
         }
+        return;
+    }
+    if (!bSimpleCollisionApplied) {
+        bSavedEnableComplexCollision = component->bEnableComplexCollision;
+        SavedCollisionType = component->CollisionType;
+        bSavedUseAsyncCooking = component->bUseAsyncCooking;
+        bSimpleCollisionApplied = true;
+    }
+    // cooking a large building takes a while, don't stall the game thread on it
+    component->bUseAsyncCooking = true;
+
+    // the collision boxes are unit cube transforms (see FBuildingInstances), their scale is the size of the box
+    FKAggregateGeom AggGeom;
+    AggGeom.BoxElems.Reserve(CollisionBoxes.Num());
+    for (const FTransform& Box : CollisionBoxes) {
+        const FVector Size = Box.GetScale3D() * FBuildingInstances::UNIT_MESH_SIZE;
+        FKBoxElem& BoxElem = AggGeom.BoxElems.Add_GetRef(FKBoxElem(Size.X, Size.Y, Size.Z));
+        BoxElem.Center = Box.GetLocation();
+        BoxElem.Rotation = Box.Rotator();
+    }
 
-        // ================ ROOF PANEL ===========================
-        FBox RoofBounds;
-        if (mPanelOptions.bPanelRoof) {
-            FSizeAndTransform Roof = mPanelOptions.GetRoofSizeAndTransform(BoxSizeActual);
-            UDynamicCube* Cube = NewObject<UDynamicCube>(this);
-            Cube->SetSize(Roof.Size);
-            Cube->GenerateMesh(RoofMesh);
-
-            //UE_LOG(LogTemp, Warning, TEXT("GenerateBoxes[%i]  Roof.Transform: %s Roof.Size: %s"), BoxNum, *(Roof.Transform.GetTranslation().ToString()), *(Roof.Size.ToString()));
+    // traces and movement only see the boxes, nothing of the triangle mesh is cooked
+    component->bEnableComplexCollision = false;
+    component->CollisionType = ECollisionTraceFlag::CTF_UseSimpleAsComplex;
+    component->SetSimpleCollisionShapes(AggGeom, true);
 
-            Roof.Transform.AddToTranslation(FVector(0.f, 0.f, BoxBounds.Max.Z));
+    UE_LOG(LogBuildingGeneration, Log, TEXT("Simple Collision - %i boxes"), AggGeom.BoxElems.Num());
+}
 
-            // transform the roof in place, it is now in the correct relative position.
-            UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(RoofMesh, Roof.Transform);
-            // GetMeshBoundingBox - this means the implementation of creating the floor mesh can change and we'll still know how to 
-            // space/stack things properly.
-            RoofBounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(RoofMesh);
-        }
+void ADynamicBuilding::ApplyGeneratedInstances(const FBuildingInstances& GeneratedInstances, int32 NumTriangles)
+{
+    // the framing material of the lattice, the same slot the baked lattice would use for all of its bars
+    UMaterialInterface* LatticeMaterial = nullptr;
+    const TMap<ELatticeMaterialSlots, UMaterialInterface*>& LatticeSlots = mBoxOptions.FramingOptions.MaterialSlots;
+    if (LatticeSlots.Contains(ELatticeMaterialSlots::All)) {
+        LatticeMaterial = LatticeSlots[ELatticeMaterialSlots::All];
+    }
+    else if (LatticeSlots.Contains(ELatticeMaterialSlots::Framing_All)) {
+        LatticeMaterial = LatticeSlots[ELatticeMaterialSlots::Framing_All];
+    }
 
-        //UE_LOG(LogTemp, Warning, TEXT("GenerateBoxes[%i]  mPanelOptions.PanelFaces.Num(): %i"), BoxNum, mPanelOptions.PanelFaces.Num());
-
-            // ================ SIDE PANELS ===================
-        int32 WindowSeed = RandomSeed + BoxNum;
-        for (auto& Face : SidePanelVectors) {
-            
-            /*
-            * Panel Faces:
-            * ------------
-            * We can build panel faces on each of the 4 sides of our boxes
-            * The panels have a facing direction, defined by the constants of FVector like FVector::ForwardVector, FVector::LeftVector, etc.
-            * If you place yourself in the center of the buildings cube, at coordinate 0,0 and you look forward, that panels facing direction is FVector::ForwardVector
-            * If you look at your left, the panel against that side of the building (from the center) would be FVector::LeftVector
-            * 
-            * Each Panel can have a panel to its left or right, we use this information to determine how we join to the other panels.
-            * If I'm looking to my left at the panel facing FVector::LeftVector, and I want to know if there is a panel to my left, I check for FVector::BackwardVector
-            * If I want to know if there is a panel to my right I check for FVector::ForwardVector.
-            * The convenience methods of `FDynamicBuildingPanelOptions` provide checks for these questions and help us know how to construct our panel.
-            * 
-            * The key thing to remember is the perspective of a panel and the meaning of left and right are always from a perspective that is at the center (inside) the building.
-            * 
-            * Panel Construction Methods:
-            * ---------------------------
-            * The logic that constructs each panel assumes that the perspective is FVector::ForwardVector (X+)
-            * From this viewpoint the left side of the panel is (Y-) the right side is (Y+). Up is (Z+)
-            * We stick to this convention to make it easy to reason about the coordinate system when constructing geometry procedurally.
-            * After the panel is constructed, and modifiers like booleans are applied the panel is transformed and rotated into place on
-            * the parent geometry (the box).
-            * 
-            * Origin:
-            * -------
-            * The origin of any geometry we spawn will be at the bottom-center of that geometry. So for our panel walls, the local 0,0 coordinate of that mesh is at the BOTTOM, 
-            * and 1/2 the depth of the panel wall. If you were looking down at the top of the panel, you would see the origin exactly half way through the panel wall 
-            * centered in both the X,Y directions.
-            * This means that we have to compensate when we align or place our panel for the thickness of the panel, specifcally 1/2 the thickness to align to an outside face.
-            */
-            
-            
-            TempMesh->Reset();
-            UDynamicCube* Cube = NewObject<UDynamicCube>(this);
-            FSizeAndTransform Panel = mPanelOptions.GetPanelSizeAndTransform(Face, BoxSizeActual);
-            Cube->SetSize(Panel.Size);
-            //Cube->SetOriginMode(EGeometryScriptPrimitiveOriginMode::Base); // for the boolean logic to operator correctly must be centered.
-            Cube->GenerateMesh(TempMesh);
-
-            // ================ PANEL WINDOWS ===================
-            // We have a panel mesh that is correctly centered about its origin, lets cut windows in it via boolean ops
-            TUniquePtr<FBooleanGridOptions> BoolOptions = MakeUnique<FBooleanGridOptions>();
-            // Setup boolean grid with options from our Windows properties
-            BoolOptions->RandomSeed = WindowSeed;
-            BoolOptions->Depth = mPanelOptions.WindowDepth;
-            BoolOptions->bSpecifyMaxBooleansPerRow = (mPanelOptions.WindowsPerRow >= 1);
-            BoolOptions->MaxBooleansPerRowOrColumn = mPanelOptions.WindowsPerRow;
-            BoolOptions->BooleanShape = EBuildingBooleanShapes::Rectangle;
-            BoolOptions->BooleanGridMode = mPanelOptions.WindowGridMode;
-            BoolOptions->bSpecifyMaxRowsColumns = (mPanelOptions.bWindowRowsMatchesFloors || !(mPanelOptions.bWindowRowsMatchesFloors) && mPanelOptions.WindowNumRows > 0);
-            BoolOptions->MaxRowCols = (mPanelOptions.bWindowRowsMatchesFloors) ? NumFloors : mPanelOptions.WindowNumRows;
-            BoolOptions->BooleanSizeMin = mPanelOptions.WindowSize * 1;
-            BoolOptions->BooleanSizeMax = (mPanelOptions.WindowSize + mPanelOptions.WindowSizeVariance) * 1;
-            BoolOptions->SafeEdge = mPanelOptions.WindowEdgeTrim;
-            BoolOptions->HorizontalSpacing = mPanelOptions.WindowHSpacing;
-            BoolOptions->HorizontalSpacingVariance = mPanelOptions.WindowHSpacingVariance;
-            BoolOptions->HorizontalAlignment = mPanelOptions.WindowHAlignment;
-            // If the window spacing and number is the same as the number of floors calculate the spacing between windows based on max window size and max floor size.
-            float SpaceBetweenWindows = FloorHeight - FMath::Max(BoolOptions->BooleanSizeMin.Y, BoolOptions->BooleanSizeMax.Y);
-            BoolOptions->VerticalSpacing = mPanelOptions.bWindowRowsMatchesFloors ? SpaceBetweenWindows : mPanelOptions.WindowVSpacing;
-
-            // TODO fix boolean logic so it can apply itself to mesh in any orientation so we don't have to perform a transform twice
-            TUniquePtr<BooleanGrid> Booleans = MakeUnique<BooleanGrid>(BoolOptions.Get());
-            Booleans->ApplyBooleans(TempMesh, mPanelOptions.WindowBoolMode);
-
-            // If the windows are not uniform, increment our seed.
-            if (!mPanelOptions.bWindowsUniform) {
-                WindowSeed++;
-            }
-               
-            // Apply the transform (this is a hack to force the transform to be applied)
-            // this transform doesn't re-orient the panel to its final location... 
-            // it just moves the origin so the panel will be offset correctly.
-            UGeometryScriptLibrary_MeshTransformFunctions::TransformMesh(PanelMesh, Panel.Transform);
-
-            // Get the transform relative to the parent box (this will rotate and orient the panel correctly)
-            FTransform PanelBoxTransform = mPanelOptions.GetPanelBoxTransform(Face, BoxSizeActual);
-            // APPLY THE TRANSFORM FOR THE PANEL HERE
-            
-            // add panel to PanelMesh
-            UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-                PanelMesh,
-                TempMesh,
-                PanelBoxTransform
-            );
-
-            //UE_LOG(LogTemp, Warning, TEXT("GenerateBoxes[%i]  Panel: %s"), BoxNum, *(Face.ToString()));
-        }
-        
-        // BoxTransform will control how the current box is attached to the overall structure
-        FTransform BoxTransform = FTransform(FVector(0.f, 0.f, CumulativeBoxHeight));
-  
-        // Current Box Rotation
-        FRotator BoxRotation = FRotator::ZeroRotator;
-        if (mBoxOptions.ZRotation != 0.f) {
-            if (mBoxOptions.RotationRandomizeInIncrements) {
-                float RotMultiplier = 360.f / mBoxOptions.ZRotation;
-                float RandMultiplier = RandomStream.RandRange(1, RotMultiplier);
-                BoxRotation.Yaw = RandMultiplier * mBoxOptions.ZRotation;
-            }
-            else if (mBoxOptions.RotationRandomizeFromSet.Num()) {
-                TSet<float>& RandSet = mBoxOptions.RotationRandomizeFromSet;
-                int32 RandIndex = RandomStream.FRandRange(0, RandSet.GetMaxIndex());
-                BoxRotation.Yaw = RandSet[FSetElementId::FromInteger(RandIndex)];
-            }
-            else {
-                BoxRotation.Yaw = mBoxOptions.ZRotation;
-            }
+    auto SetInstances = [](UHierarchicalInstancedStaticMeshComponent* Component, UStaticMesh* UnitMesh, UMaterialInterface* Material, const TArray<FTransform>& Transforms)
+    {
+        if (Component == nullptr) {
+            return;
         }
-
-        BoxTransform.SetRotation(FQuat(BoxRotation));
-
-        auto BS = BoxBounds.GetSize();
-        auto BC = BoxBounds.GetCenter();
-        auto BE = BoxBounds.GetExtent();
-        auto BMAX = BoxBounds.Max;
-
-        // add TempMesh to BoxesMesh...
-        UE_LOG(LogTemp, Warning, TEXT("GenerateBoxes[%i]  Size: %s Z Position: %f, S: %s, C: %s, E: %s, MAX: %s"), BoxNum, *(BoxSizeActual.ToString()), CumulativeBoxHeight, *(BS.ToString()), *(BC.ToString()), *(BE.ToString()), *(BMAX.ToString()));
-
-        // the current total height of all boxes added together.
-        // this value, is where the next box will spawn.
-        CumulativeBoxHeight += (FMath::Max(RoofBounds.Max.Z, BoxBounds.Max.Z) + VerticalSpacing);
-
-        // before we append the mesh make sure we aren't exceeding our usable space
-        if (CumulativeBoxHeight >= UsableBuildingHeight) {
-            UE_LOG(LogTemp, Warning, TEXT("GenerateBoxes - Stopping at Box [%i]  Height: %d Will Exceed Usable Building Height: %d"), BoxNum, CumulativeBoxHeight, BuildingHeight);
-            break;
+        Component->ClearInstances();
+        if (Transforms.Num() == 0 || UnitMesh == nullptr) {
+            return;
         }
-
-        for (auto BMesh : BoxMeshes) {
-            UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-                BoxesMesh,
-                BMesh,
-                BoxTransform // the box transform should place the box at the correct vertical position and rotation.
-            );
+        Component->SetStaticMesh(UnitMesh);
+        Component->SetMaterial(0, Material);
+        Component->AddInstances(Transforms, false);
+    };
+    SetInstances(WindowInsetInstances, WindowInsetMesh, WindowInsetMaterial, GeneratedInstances.WindowInsets);
+    SetInstances(WindowGlassInstances, WindowGlassMesh, WindowGlassMaterial, GeneratedInstances.WindowGlass);
+    SetInstances(LatticeBarInstances, LatticeBarMesh, LatticeMaterial, GeneratedInstances.LatticeBars);
+
+    // the coarser LODs have the windows and (flat) lattice built in, the instances are only drawn with LOD 0
+    const float InstanceCullDistance = GetNumLODs() > 1 ? GetLODDistance(1) : 0.f;
+    for (UHierarchicalInstancedStaticMeshComponent* Instances : { WindowInsetInstances, WindowGlassInstances, LatticeBarInstances }) {
+        if (Instances != nullptr) {
+            Instances->SetCullDistances(0, FMath::FloorToInt(InstanceCullDistance));
         }
-
-
-    } // end of Box creation loop
-
-    for (auto BMesh : BoxMeshes) {
-        ReleaseComputeMesh(BMesh);
     }
-    BoxMeshes.Empty(); // don't need these anymore
-
-    FVector BoxesOrigin = FVector();
-
-    using VAlign = EBuildingVAlignmentChoices;
-
-    VAlign Alignment = mBoxOptions.VAlignment;
 
-    if (Alignment == VAlign::Random) {
-        TArray<VAlign> RandChoices = { VAlign::Top, VAlign::Middle, VAlign::Bottom };
+    if (GeneratedInstances.Num() > 0) {
+        UE_LOG(LogBuildingGeneration, Log, TEXT("Instanced Output - %i window insets, %i glass, %i lattice bars (%.1f KB instance data), building mesh %i tris"),
+            GeneratedInstances.WindowInsets.Num(), GeneratedInstances.WindowGlass.Num(), GeneratedInstances.LatticeBars.Num(),
+            GeneratedInstances.GetInstanceBytes() / 1024.0, NumTriangles);
+    }
+}
 
-        //int RandIndex = CombinedSeed % (RandChoices.Num() - 1)
+int32 ADynamicBuilding::GetNumLODs() const
+{
+    return FMath::Clamp(NumLODs, 1, BuildingGenerator::MAX_LODS);
+}
 
-        // hash the internal name of our enum (just needs to be consistent across builds on the same platform)
-        const char* TypeName = typeid(typename EBuildingVAlignmentChoices).name();
-        std::string VAlignString = std::string(TypeName);
-        std::hash<std::string> hasher;
-        size_t VModeSeed = hasher(TypeName);
-        uint32 VAlignSeed = static_cast<uint32>(VModeSeed + RandomSeed);
-        uint32 RandIndex = VAlignSeed % (RandChoices.Num() - 1);
-        Alignment = RandChoices[RandIndex];
-    }
+float ADynamicBuilding::GetLODDistance(int32 LOD) const
+{
+    return (LOD >= 2) ? FMath::Max(LOD2Distance, LOD1Distance) : (LOD == 1 ? LOD1Distance : 0.f);
+}
 
-    switch (Alignment) {
-    case EBuildingVAlignmentChoices::Middle:
-        BoxesOrigin.Z = FMath::Max((BuildingHeight - CumulativeBoxHeight) / 2, 0);
-        break;
-    case EBuildingVAlignmentChoices::Top:
-        BoxesOrigin.Z = FMath::Max(BuildingHeight - CumulativeBoxHeight, 0);
-        break; 
-    case EBuildingVAlignmentChoices::Bottom:
+UDynamicMeshComponent* ADynamicBuilding::GetLODComponent(int32 LOD) const
+{
+    switch (LOD) {
+    case 0:
+        return GetDynamicMeshComponent();
+    case 1:
+        return LOD1MeshComponent;
+    case 2:
+        return LOD2MeshComponent;
     default:
-        BoxesOrigin.Z = 0;
+        return nullptr;
     }
+}
 
-    FTransform BoxesTransform = FTransform();
-    BoxesTransform.AddToTranslation(BoxesOrigin);
-
-    // add BoxesMesh to Mesh...
-    UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-        Mesh,
-        BoxesMesh,
-        BoxesTransform
-    );
+int32 ADynamicBuilding::GetLODTriangleCount(int32 LOD) const
+{
+    return LODTriangleCounts.IsValidIndex(LOD) ? LODTriangleCounts[LOD] : 0;
+}
 
-    
-    ReleaseComputeMesh(TempMesh);
-    ReleaseComputeMesh(BoxesMesh);
+bool ADynamicBuilding::IsGenerating() const
+{
+    return NumGenerationsInFlight > 0;
+}
 
-    component->SetNumMaterials(0);
-    component->ConfigureMaterialSet(MaterialSet);
-    
+FDynamicBuildingRecipe ADynamicBuilding::MakeRecipe() const
+{
+    FDynamicBuildingRecipe Recipe;
+    Recipe.RandomSeed = RandomSeed;
+    Recipe.BuildingSize = mBuildingSize;
+    Recipe.MaterialSlots = MaterialSlots;
+    Recipe.UVScaleMode = UVScaleMode;
+    Recipe.UVSize = UVSize;
+    Recipe.UVOriginMode = UVOriginMode;
+    Recipe.DetailOutput = DetailOutput;
+    Recipe.bFinalizeMesh = bFinalizeMesh;
+    Recipe.BoxOptions = mBoxOptions;
+    Recipe.PanelOptions = mPanelOptions;
+    return Recipe;
+}
 
-    // TODO refactor and add a call to ReleaseAllComputerMeshes() to ensure there is never a memory leak
+FBuildingLayout ADynamicBuilding::GetLayout() const
+{
+    FDynamicBuildingRecipe Recipe = MakeRecipe();
+    return BuildingGenerator(&Recipe).MakeLayout();
 }
 
 TArray<FVector> FDynamicBuildingPanelOptions::GetSideVectors()
@@ -891,8 +602,6 @@ FSizeAndTransform FDynamicBuildingPanelOptions::GetPanelSizeAndTransform(const F
     Transform.AddToTranslation(FVector::LeftVector * (LeftSize * 0.5));
     Transform.AddToTranslation(FVector::RightVector * (RightSize * 0.5));
 
-    //UE_LOG(LogTemp, Warning, TEXT("DEBUG: CurrentPanel: %s, Left: %i, Right: %i, Overlap: %f LeftSize: %f, RightSize: %f"), *(CurrentPanel.ToString()), LeftSide, RightSide, Overlap, LeftSize, RightSize);
-
     ST.Size = Size;
     ST.Transform = Transform;
 
@@ -924,7 +633,6 @@ FSizeAndTransform FDynamicBuildingPanelOptions::GetRoofSizeAndTransform(const FV
 
     for (auto& Face : GetSideVectors()) {
         float FaceSize = GetPanelDistanceFromCenter(Face, BoxSize);
-        //UE_LOG(LogTemp, Warning, TEXT("Roof Face: %s FaceSize: %f"), *(Face.ToString()), FaceSize);
         if (!HasPanelAtVector(Face)) {
             //FaceSize += SideStandoff;
             FaceSize += Overhang;
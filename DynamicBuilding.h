@@ -22,8 +22,19 @@ ClampMin = 1, ClampMax = 100
 #include "UDynamicMesh.h"
 #include "BuildingEnums.h"
 #include "LatticeGrid.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "Containers/Ticker.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "BuildingInstances.h"
+#include "BuildingLayout.h"
 #include "DynamicBuilding.generated.h"
 
+class FBuildingFragmentCache;
+class UHierarchicalInstancedStaticMeshComponent;
+class UStaticMesh;
+class UStaticMeshComponent;
+class UDynamicMeshComponent;
+
 
 UENUM(BlueprintType)
 enum class EBuildingMaterialSlots : uint8
@@ -180,6 +191,9 @@ struct PROCEDURALBUILDINGS_API FDynamicBuildingPanelOptions
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Overhang Depth", ToolTip = "How far the panel extends past the underlying geometry (in meters), this extension will be present on all open sides", UIMin = "0.0", UIMax = "30.0"))
 	float Overhang = 200;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Cull Hidden Faces", ToolTip = "Box faces closed in by solid panels, the roof and the floor, and the bottom of the building core, are not built. The visible result is the same."))
+	bool bCullHiddenFaces = true;
+
 	//////////////////// ROOF / FLOOR ///////////////////////////////////
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Panel Roof", ToolTip = "Create Roof Panel (no windows)"))
 	bool bPanelRoof = false;
@@ -225,6 +239,9 @@ struct PROCEDURALBUILDINGS_API FDynamicBuildingPanelOptions
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Window Depth", ToolTip = "The depth of the window (0) means depth of mesh"))
 	float WindowDepth = 0.f;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Window Cut Mode", ToolTip = "Analytic cuts the windows straight out of the panel without a mesh boolean, Boolean always uses a mesh boolean per panel, Box Boolean places the panels of a box first and cuts all of their windows with a single mesh boolean"))
+	EBuildingCutMode WindowCutMode = EBuildingCutMode::Boolean;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Window Rows Determined by Floors", ToolTip = "The number of rows of windows will be determined by the number of floors in the section of the building"))
 	bool bWindowRowsMatchesFloors = true;
 
@@ -287,6 +304,54 @@ struct PROCEDURALBUILDINGS_API FDynamicBuildingPanelOptions
 	struct FSizeAndTransform GetFloorSizeAndTransform(const FVector& BoxSize);
 };
 
+/**
+ * A complete description of a building, everything the generator needs to produce the mesh.
+ * The actor copies its properties into a recipe so generation can run against a snapshot that
+ * won't change underneath it (eg. while generating on a background thread).
+ */
+USTRUCT(BlueprintType)
+struct PROCEDURALBUILDINGS_API FDynamicBuildingRecipe
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Seed", ToolTip = "Options set to random will be consistent across edit until seed is changed"))
+	int32 RandomSeed = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Building Size", ToolTip = "Size of main building object in Meters"))
+	FVector BuildingSize = FVector(10000);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Materials", ToolTip = "Materials to apply"))
+	TMap<EBuildingMaterialSlots, UMaterialInterface*> MaterialSlots;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "UV Scale Mode", ToolTip = "UV Scaling Mode"))
+	EBuildingUVScaleMode UVScaleMode = EBuildingUVScaleMode::Fixed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "UV Size", ToolTip = "UV Scale Size - The UV coordinates will repeat after this distance on the mesh", Unit = "Centimeter"))
+	float UVSize = 2000.f; // 20 meters
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "UV Origin Mode", ToolTip = "UV Origin - Detemrines where on the mesh the center of the UV coordinates will be"))
+	EBuildingUVOriginMode UVOriginMode = EBuildingUVOriginMode::MinCoordinate;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Detail Output", ToolTip = "Bake windows and lattice bars into the building mesh, or output them as instances of shared unit meshes"))
+	EBuildingDetailOutput DetailOutput = EBuildingDetailOutput::Baked;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Finalize Mesh", ToolTip = "Weld the coincident vertices left by merging the boxes and panels, then compact the finished mesh and shrink it to fit"))
+	bool bFinalizeMesh = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Box Options", ToolTip = "Options for boxes"))
+	FDynamicBuildingGenericBoxOptions BoxOptions;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Panel Options", ToolTip = "Options for sides of boxes (panels)"))
+	FDynamicBuildingPanelOptions PanelOptions;
+};
+
+// The mesh and material set of one level of detail
+struct FBuildingLODMesh
+{
+	UE::Geometry::FDynamicMesh3 Mesh;
+	TArray<UMaterialInterface*> Materials;
+};
+
 /**
  * 
  */
@@ -322,6 +387,15 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building", meta = (DisplayName = "Seed", ToolTip = "Options set to random will be consistent across edit until seed is changed"))
 	int32 RandomSeed = 0;
 
+	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category = "Building", meta = (DisplayName = "Generate Async", ToolTip = "Build the mesh on a background thread and swap it in when it is complete, the editor stays responsive while large buildings generate"))
+	bool bGenerateAsync = false;
+
+	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category = "Building", meta = (DisplayName = "Rebuild Delay", ToolTip = "Edits are coalesced, the building rebuilds once no further edit has been made for this long", Units = "s", ClampMin = "0.0", UIMax = "2.0"))
+	float RebuildDelay = 0.25f;
+
+	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category = "Building", meta = (DisplayName = "Finalize Mesh", ToolTip = "Weld the coincident vertices left by merging the boxes and panels, then compact the finished mesh and shrink it to fit"))
+	bool bFinalizeMesh = true;
+
 	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category = "Building", meta = (DisplayName = "Building Size", ToolTip = "Size of main building object in Meters"))
 	FVector mBuildingSize = FVector(10000);
 
@@ -344,6 +418,51 @@ public:
 	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category = "Building|Boxes", meta = (DisplayName = "Panel Options", ToolTip = "Options for sides of boxes (panels)", NoResetToDefault))
 	FDynamicBuildingPanelOptions mPanelOptions;
 
+	//////////////////// INSTANCING ///////////////////////////////////
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|Instancing", meta = (DisplayName = "Detail Output", ToolTip = "Baked cuts the windows and builds the lattice bars into the building mesh. Instanced leaves the panels uncut and places window insets, glass and lattice bars as instances of the unit meshes below"))
+	EBuildingDetailOutput DetailOutput = EBuildingDetailOutput::Baked;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|Instancing", meta = (DisplayName = "Window Inset Mesh", ToolTip = "Unit mesh of window insets, a 100cm cube centered on its origin"))
+	UStaticMesh* WindowInsetMesh = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|Instancing", meta = (DisplayName = "Window Glass Mesh", ToolTip = "Unit mesh of window glass, a 100cm plane facing Z+ centered on its origin"))
+	UStaticMesh* WindowGlassMesh = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|Instancing", meta = (DisplayName = "Lattice Bar Mesh", ToolTip = "Unit mesh of lattice bars, a 100cm cube centered on its origin"))
+	UStaticMesh* LatticeBarMesh = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|Instancing", meta = (DisplayName = "Window Inset Material", ToolTip = "Material of the window insets, the unit mesh material is used if not set"))
+	UMaterialInterface* WindowInsetMaterial = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|Instancing", meta = (DisplayName = "Window Glass Material", ToolTip = "Material of the window glass, the unit mesh material is used if not set"))
+	UMaterialInterface* WindowGlassMaterial = nullptr;
+
+	//////////////////// COLLISION ///////////////////////////////////
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|Collision", meta = (DisplayName = "Simple Collision", ToolTip = "Collide against a box per core, box, panel and slab instead of the triangles of the building (windows and lattice bars don't collide). Complex collision is turned off and cooking runs asynchronously"))
+	bool bSimpleCollision = false;
+
+	//////////////////// LOD ///////////////////////////////////
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|LOD", meta = (DisplayName = "Number of LODs", ToolTip = "LOD 1 leaves the panels uncut and flattens the lattice, LOD 2 is only the core, the boxes and their panel slabs. They are built from the same layout as the full detail mesh", ClampMin = 1, ClampMax = 3))
+	int32 NumLODs = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|LOD", meta = (DisplayName = "LOD 1 Distance", ToolTip = "Distance from the camera LOD 1 replaces the full detail mesh at", Unit = "Centimeter", ClampMin = "0.0"))
+	float LOD1Distance = 20000.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|LOD", meta = (DisplayName = "LOD 2 Distance", ToolTip = "Distance from the camera LOD 2 replaces LOD 1 at", Unit = "Centimeter", ClampMin = "0.0"))
+	float LOD2Distance = 60000.f;
+
+	// Triangles of each generated LOD, updated after every generation
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Building|LOD", meta = (DisplayName = "LOD Triangle Counts"))
+	TArray<int32> LODTriangleCounts;
+
+	//////////////////// EXPORT ///////////////////////////////////
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building|Export", meta = (DisplayName = "Export Path", ToolTip = "Content folder the static mesh assets are saved to, the asset is named SM_ followed by the actor name"))
+	FString ExportPath = TEXT("/Game/Buildings");
+
+	// The static mesh asset the building was last exported to, shown in place of the dynamic meshes until it is regenerated
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Building|Export", meta = (DisplayName = "Exported Mesh"))
+	UStaticMesh* ExportedMesh = nullptr;
+
 	// Rebuild all meshes 
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Building|Actions", meta = (DisplayName = "Apply Changes"))
 	void ReceiveRebuildAll();
@@ -352,7 +471,38 @@ public:
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Building|Actions", meta = (DisplayName = "Export Static Mesh"))
 	void ReceieveExportMesh();
 
+	// Export every building in the level to a Static Mesh Asset, see BuildingExport
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Building|Actions", meta = (DisplayName = "Export All Buildings"))
+	void ReceiveExportAllMeshes();
+
+	// Show `StaticMesh` instead of the dynamic meshes, which are emptied so the level no longer stores them.
+	// The next generation switches back to the dynamic meshes.
+	void UseExportedMesh(UStaticMesh* StaticMesh);
+
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void BeginDestroy() override;
+
+	// Copy the current building properties into a recipe the generator can consume
+	FDynamicBuildingRecipe MakeRecipe() const;
+
+	// True while a background generation task is running
+	UFUNCTION(BlueprintCallable, Category = "Building|Actions")
+	bool IsGenerating() const;
+
+	// Where the boxes of the building go with the current properties, without generating anything
+	UFUNCTION(BlueprintCallable, Category = "Building|Actions")
+	FBuildingLayout GetLayout() const;
+
+	// Triangles of a LOD from the last generation, 0 if it wasn't generated
+	UFUNCTION(BlueprintCallable, Category = "Building|LOD")
+	int32 GetLODTriangleCount(int32 LOD) const;
+
+	// The component showing a LOD, LOD 0 is the root dynamic mesh component
+	UDynamicMeshComponent* GetLODComponent(int32 LOD) const;
+
+	// Request a rebuild after `RebuildDelay`, a burst of requests collapses into a single rebuild
+	UFUNCTION(BlueprintCallable, Category = "Building|Actions")
+	void ScheduleRebuild();
 
 private:
 
@@ -365,6 +515,25 @@ private:
 	UPROPERTY()
 	TArray<UMaterialInterface*> MaterialSet;
 
+	// Instanced output (EBuildingDetailOutput::Instanced), one component per unit mesh
+	UPROPERTY(VisibleAnywhere, Category = "Building|Instancing")
+	UHierarchicalInstancedStaticMeshComponent* WindowInsetInstances;
+
+	UPROPERTY(VisibleAnywhere, Category = "Building|Instancing")
+	UHierarchicalInstancedStaticMeshComponent* WindowGlassInstances;
+
+	UPROPERTY(VisibleAnywhere, Category = "Building|Instancing")
+	UHierarchicalInstancedStaticMeshComponent* LatticeBarInstances;
+
+	UPROPERTY(VisibleAnywhere, Category = "Building|LOD")
+	UDynamicMeshComponent* LOD1MeshComponent;
+
+	UPROPERTY(VisibleAnywhere, Category = "Building|LOD")
+	UDynamicMeshComponent* LOD2MeshComponent;
+
+	UPROPERTY(VisibleAnywhere, Category = "Building|Export")
+	UStaticMeshComponent* ExportedMeshComponent;
+
 	// UDynamicMeshComponent* BoxComponent; TODO REMOVE ME
 	//TSet<UDynamicMeshComponent*> MeshComponentPool;
 	//TArray<FunctionPtrType> mBuildFunctions; // build functions 
@@ -374,6 +543,44 @@ private:
 
 	UFUNCTION(BlueprintCallable)
 	virtual void Generate();
+
+	// Run the generator on the thread pool against a scratch mesh, the result is applied on the game thread. The scratch
+	// meshes are created (and kept alive by a mesh pool) before the task starts, the task never blocks garbage collection.
+	void GenerateAsync();
+
+	// Swap the finished LOD meshes, their material sets and the instances into the components in a single step.
+	void ApplyGeneratedMesh(TArray<FBuildingLODMesh>&& GeneratedLODs, FBuildingInstances&& GeneratedInstances);
+
+	int32 GetNumLODs() const;
+
+	// Distance a LOD starts being drawn at
+	float GetLODDistance(int32 LOD) const;
+
+	// Replace the instances of the instanced components, and log how many there are
+	void ApplyGeneratedInstances(const FBuildingInstances& GeneratedInstances, int32 NumTriangles);
+
+	// Set up simple box collision when `bSimpleCollision` is on, turning it off puts back the component's own collision settings
+	void ApplyCollision(const TArray<FTransform>& CollisionBoxes);
+
+	// Ticker callback for `ScheduleRebuild()`, returns false so it only fires once.
+	bool RunScheduledRebuild(float DeltaTime);
+
+	FTSTicker::FDelegateHandle RebuildTickerHandle;
+
+	// Incremented each time a generation starts, a task whose token no longer matches has been superseded.
+	// Shared with the worker so a running task can see it is stale and stop early.
+	TSharedRef<FThreadSafeCounter, ESPMode::ThreadSafe> GenerationToken = MakeShared<FThreadSafeCounter, ESPMode::ThreadSafe>();
+
+	int32 NumGenerationsInFlight = 0;
+
+	// Per box geometry from the previous generation, boxes whose inputs haven't changed are reused. One cache per LOD.
+	TArray<TSharedPtr<FBuildingFragmentCache, ESPMode::ThreadSafe>> FragmentCaches;
+
+	// The component's collision settings from before `ApplyCollision()` replaced them, put back when `bSimpleCollision` is turned off.
+	bool bSimpleCollisionApplied = false;
+	bool bSavedEnableComplexCollision = true;
+	TEnumAsByte<ECollisionTraceFlag> SavedCollisionType = ECollisionTraceFlag::CTF_UseDefault;
+	bool bSavedUseAsyncCooking = false;
 	/*
 	
 	
@@ -0,0 +1,164 @@
+#include "DynamicBuildingDistrict.h"
+#include "BuildingGenerator.h"
+#include "BuildingStats.h"
+#include "PanelMeshCache.h"
+#include "LatticeMeshCache.h"
+#include "Components/DynamicMeshComponent.h"
+#include "Components/SceneComponent.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "UDynamicMesh.h"
+
+ADynamicBuildingDistrict::ADynamicBuildingDistrict(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryActorTick.bCanEverTick = false;
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void ADynamicBuildingDistrict::BeginPlay()
+{
+	Super::BeginPlay();
+	if (bGenerateOnBeginPlay) {
+		ReceiveGenerateDistrict();
+	}
+}
+
+void ADynamicBuildingDistrict::BeginDestroy()
+{
+	CancelGeneration();
+	Super::BeginDestroy();
+}
+
+void ADynamicBuildingDistrict::AddLotGrid(const FDynamicBuildingRecipe& Recipe, FIntPoint GridSize, float Spacing)
+{
+	for (int32 Y = 0; Y < GridSize.Y; Y++) {
+		for (int32 X = 0; X < GridSize.X; X++) {
+			FDynamicBuildingDistrictLot& Lot = Lots.AddDefaulted_GetRef();
+			Lot.Recipe = Recipe;
+			Lot.Recipe.RandomSeed = Recipe.RandomSeed + Lots.Num() - 1;
+			Lot.Transform = FTransform(FVector(X * Spacing, Y * Spacing, 0.f));
+		}
+	}
+}
+
+void ADynamicBuildingDistrict::ReceiveGenerateDistrict()
+{
+	CancelGeneration();
+
+	// lots that were removed since the last generation
+	while (LotComponents.Num() > Lots.Num()) {
+		if (UDynamicMeshComponent* Component = LotComponents.Pop()) {
+			Component->DestroyComponent();
+		}
+	}
+
+	MeshPool = MakeUnique<FBuildingMeshPool>();
+	NextLot = 0;
+	NumFrames = 0;
+	NumTriangles = 0;
+	GenerationStartTime = FPlatformTime::Seconds();
+	GenerationTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &ADynamicBuildingDistrict::GenerateNextLots)
+	);
+}
+
+void ADynamicBuildingDistrict::CancelGeneration()
+{
+	if (GenerationTickerHandle.IsValid()) {
+		FTSTicker::GetCoreTicker().RemoveTicker(GenerationTickerHandle);
+		GenerationTickerHandle.Reset();
+		UE_LOG(LogBuildingGeneration, Log, TEXT("District - Generation cancelled after %i of %i lots"), NextLot, Lots.Num());
+	}
+	MeshPool.Reset();
+}
+
+bool ADynamicBuildingDistrict::IsGenerating() const
+{
+	return GenerationTickerHandle.IsValid();
+}
+
+float ADynamicBuildingDistrict::GetProgress() const
+{
+	if (!IsGenerating() || Lots.Num() == 0) {
+		return 1.f;
+	}
+	return static_cast<float>(NextLot) / Lots.Num();
+}
+
+bool ADynamicBuildingDistrict::GenerateNextLots(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADynamicBuildingDistrict::GenerateNextLots);
+	const double Deadline = FPlatformTime::Seconds() + FrameBudgetMs / 1000.0;
+	while (NextLot < Lots.Num()) {
+		GenerateLot(NextLot++);
+		if (FPlatformTime::Seconds() >= Deadline) {
+			break;
+		}
+	}
+	NumFrames++;
+
+	if (NextLot < Lots.Num()) {
+		return true;
+	}
+	FinishGeneration();
+	return false; // don't fire again
+}
+
+void ADynamicBuildingDistrict::GenerateLot(int32 LotIndex)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADynamicBuildingDistrict::GenerateLot);
+
+	// the generator takes a mutable recipe, the lot keeps its own
+	FDynamicBuildingRecipe Recipe = Lots[LotIndex].Recipe;
+	Recipe.DetailOutput = EBuildingDetailOutput::Baked;
+
+	FScopedBuildingMesh ScratchMesh(MeshPool.Get());
+	TArray<UMaterialInterface*> Materials;
+	BuildingGenerator Generator = BuildingGenerator(&Recipe);
+	Generator.SetMeshPool(MeshPool.Get());
+	if (!Generator.Generate(ScratchMesh.Get(), Materials)) {
+		return;
+	}
+
+	// swap the finished mesh in, the component only sees a single change
+	UE::Geometry::FDynamicMesh3 Generated;
+	ScratchMesh.Get()->EditMesh([&Generated](UE::Geometry::FDynamicMesh3& EditMesh)
+	{
+		Generated = MoveTemp(EditMesh);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, true);
+	NumTriangles += Generated.TriangleCount();
+
+	UDynamicMeshComponent* Component = GetLotComponent(LotIndex);
+	Component->GetDynamicMesh()->SetMesh(MoveTemp(Generated));
+	Component->SetNumMaterials(0);
+	Component->ConfigureMaterialSet(Materials);
+	Component->MarkRenderStateDirty();
+}
+
+void ADynamicBuildingDistrict::FinishGeneration()
+{
+	GenerationTickerHandle.Reset();
+	UE_LOG(LogBuildingGeneration, Display, TEXT("District - %i lots, %i tris generated in %.2f s over %i frames (%.1f ms budget)"),
+		Lots.Num(), NumTriangles, FPlatformTime::Seconds() - GenerationStartTime, NumFrames, FrameBudgetMs);
+	MeshPool->LogStats(TEXT("District"));
+	FPanelMeshCache::Get().LogStats();
+	FLatticeMeshCache::Get().LogStats();
+	MeshPool.Reset();
+}
+
+UDynamicMeshComponent* ADynamicBuildingDistrict::GetLotComponent(int32 LotIndex)
+{
+	while (LotComponents.Num() <= LotIndex) {
+		LotComponents.Add(nullptr);
+	}
+
+	UDynamicMeshComponent*& Component = LotComponents[LotIndex];
+	if (Component == nullptr) {
+		Component = NewObject<UDynamicMeshComponent>(this, NAME_None, RF_Transactional);
+		Component->SetupAttachment(GetRootComponent());
+		AddInstanceComponent(Component);
+		Component->RegisterComponent();
+	}
+	Component->SetRelativeTransform(Lots[LotIndex].Transform);
+	return Component;
+}
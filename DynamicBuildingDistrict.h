@@ -0,0 +1,107 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Containers/Ticker.h"
+#include "DynamicBuilding.h"
+#include "BuildingMeshPool.h"
+#include "DynamicBuildingDistrict.generated.h"
+
+class UDynamicMeshComponent;
+
+// A building of a district, the recipe it is generated from and where it stands
+USTRUCT(BlueprintType)
+struct PROCEDURALBUILDINGS_API FDynamicBuildingDistrictLot
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Transform", ToolTip = "Placement of the building relative to the district"))
+	FTransform Transform;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Recipe", ToolTip = "The building generated on this lot"))
+	FDynamicBuildingRecipe Recipe;
+};
+
+/**
+ * Generates a whole district of buildings from an array of recipes, for city blocks with thousands of buildings where
+ * an ADynamicBuilding per building doesn't scale.
+ *
+ * The lots are generated one after the other on the game thread, as many per frame as fit in `FrameBudgetMs` (at least
+ * one, a single large building can take longer than the budget). Every lot shares one mesh pool (see 
+ * FBuildingMeshPool) and the process wide panel and lattice caches (FPanelMeshCache, FLatticeMeshCache). A lattice
+ * only depends on its face size and framing options, so lots with the same framing copy lattices instead of building
+ * them. Panels are keyed on their window seed, which comes from the lot's seed, so only lots with the same recipe and
+ * seed share panels; AddLotGrid gives every lot its own seed. Each lot is shown by its own dynamic mesh component.
+ *
+ * Lots are generated at full detail with baked windows and lattice, the district has no instanced components or LODs.
+ *
+ * HOWTO:
+ *	District->AddLotGrid(Recipe, FIntPoint(50, 40), 15000.f);
+ *	District->ReceiveGenerateDistrict();
+ */
+UCLASS()
+class PROCEDURALBUILDINGS_API ADynamicBuildingDistrict : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ADynamicBuildingDistrict(const FObjectInitializer& ObjectInitializer);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "District", meta = (DisplayName = "Lots", ToolTip = "The buildings of the district"))
+	TArray<FDynamicBuildingDistrictLot> Lots;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "District", meta = (DisplayName = "Frame Budget", ToolTip = "Time spent generating lots each frame, at least one lot is generated per frame", Units = "ms", ClampMin = "0.1", UIMax = "50.0"))
+	float FrameBudgetMs = 8.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "District", meta = (DisplayName = "Generate On Begin Play", ToolTip = "Generate the district when play begins"))
+	bool bGenerateOnBeginPlay = false;
+
+	// Triangles of every lot from the last generation
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "District", meta = (DisplayName = "Triangles"))
+	int32 NumTriangles = 0;
+
+	// Generate every lot, spread over frames. A generation that is still running starts over.
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "District|Actions", meta = (DisplayName = "Generate District"))
+	void ReceiveGenerateDistrict();
+
+	// Stop generating, the lots generated so far are kept
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "District|Actions", meta = (DisplayName = "Cancel Generation"))
+	void CancelGeneration();
+
+	// Add a NumX by NumY grid of lots `Spacing` apart on X and Y, every lot is `Recipe` with its own seed
+	UFUNCTION(BlueprintCallable, Category = "District|Actions")
+	void AddLotGrid(const FDynamicBuildingRecipe& Recipe, FIntPoint GridSize, float Spacing);
+
+	UFUNCTION(BlueprintCallable, Category = "District|Actions")
+	bool IsGenerating() const;
+
+	// Fraction of the lots generated so far, 1 when idle
+	UFUNCTION(BlueprintCallable, Category = "District|Actions")
+	float GetProgress() const;
+
+	virtual void BeginPlay() override;
+	virtual void BeginDestroy() override;
+
+private:
+	// One component per lot, in lot order
+	UPROPERTY(VisibleAnywhere, Category = "District")
+	TArray<UDynamicMeshComponent*> LotComponents;
+
+	FTSTicker::FDelegateHandle GenerationTickerHandle;
+
+	// scratch meshes shared by every lot of a generation
+	TUniquePtr<FBuildingMeshPool> MeshPool;
+
+	int32 NextLot = 0;
+	int32 NumFrames = 0;
+	double GenerationStartTime = 0.0;
+
+	// Ticker callback, generates lots until the frame budget is used up. Returns false once every lot is generated.
+	bool GenerateNextLots(float DeltaTime);
+
+	void GenerateLot(int32 LotIndex);
+	void FinishGeneration();
+
+	// The component of a lot, created the first time the lot is generated
+	UDynamicMeshComponent* GetLotComponent(int32 LotIndex);
+};
@@ -1,129 +1,99 @@
-
-
-
 #include "DynamicCube.h"
 #include "UDynamicMesh.h"
-#include "GeometryScript/MeshPrimitiveFunctions.h"
-#include "GeometryScript/MeshBasicEditFunctions.h"
-#include "MeshTransformUtilities.h"
 
 void UDynamicCube::SetSize(const FVector& Size)
 {
-	mSize = Size;
+	Box.SetSize(Size);
 }
 
 void UDynamicCube::AddToOrigin(const FVector& Delta)
 {
-	mOrigin += Delta;
+	Box.AddToOrigin(Delta);
 }
 
 void UDynamicCube::AddToSize(const FVector& Delta)
 {
-	mSize += Delta;
+	Box.AddToSize(Delta);
 }
 
 void UDynamicCube::AddToSizeInDirection(const float Size, const FVector& Direction)
 {
-	FVector Normalized = Direction.GetSafeNormal();
-	FVector ChangeInSize = Size * Normalized.GetAbs();
-	// the change to the origin is half the size changed, in the opposite direction
-	FVector ChangeInOrigin = Normalized * Size * 0.5f * -1.f;
-	AddToSize(ChangeInSize);
-	AddToOrigin(ChangeInOrigin);
+	Box.AddToSizeInDirection(Size, Direction);
 }
 
 void UDynamicCube::SetTranslation(const FVector& Position)
 {
-	mTranslation = Position;
+	Box.SetTranslation(Position);
 }
 
 void UDynamicCube::AddToTranslation(const FVector& Delta)
 {
-	mTranslation += Delta;
+	Box.AddToTranslation(Delta);
 }
 
 void UDynamicCube::SetRotation(const FRotator& Rotation) 
 {
-	mRotation = Rotation;
+	Box.SetRotation(Rotation);
 }
 
 void UDynamicCube::SetRotation(const FVector& Facing)
 {
-	mRotation = Facing.Rotation();
+	Box.SetRotation(Facing);
 }
 
 void UDynamicCube::SetOrigin(const FVector& Origin)
 {
-	mOrigin = Origin;
+	Box.SetOrigin(Origin);
 }
 
 void UDynamicCube::SetGeometryOptions(const FGeometryScriptPrimitiveOptions Options)
 {
-	mGeometryOptions = Options;
+	Box.SetGeometryOptions(Options);
 }
 
 void UDynamicCube::SetOriginMode(const EGeometryScriptPrimitiveOriginMode Origin)
 {
-	mOriginMode = Origin;
+	Box.SetOriginMode(Origin);
 }
 
 FVector UDynamicCube::GetSize()
 {
-	return mSize;
+	return Box.GetSize();
 }
 
 FVector UDynamicCube::GetTranslation()
 {
-	// an origin of x=-5 is a translation of x=5
-	return (mOrigin * -1) + mTranslation;
+	return Box.GetTranslation();
 }
 
 FRotator UDynamicCube::GetRotation()
 {
-	return mRotation;
+	return Box.GetRotation();
 }
 
 void UDynamicCube::SetTransform(const FTransform& Transform)
 {
-	mRotation = Transform.GetRotation().Rotator();
-	mTranslation = Transform.GetTranslation();
-	mScale = Transform.GetScale3D();
+	Box.SetTransform(Transform);
 }
 
 FTransform UDynamicCube::GetTransform()
 {
-	return FTransform(
-		FQuat(GetRotation()),
-		GetTranslation(),
-		mScale
-	);
+	return Box.GetTransform();
 }
 
 void UDynamicCube::GenerateMesh(UDynamicMesh* Mesh, const bool ApplyTransform)
 {
-	// construct our mesh
-	FTransform Transform = ApplyTransform ? GetTransform() : FTransform();
+	if (Mesh == nullptr) {
+		return;
+	}
 
-	UGeometryScriptLibrary_MeshPrimitiveFunctions::AppendBox(
-		Mesh,
-		mGeometryOptions,
-		Transform,
-		mSize.X,
-		mSize.Y,
-		mSize.Z,
-		0,
-		0,
-		0,
-		mOriginMode
-	);
+	Mesh->EditMesh([&](FDynamicMesh3& EditMesh)
+	{
+		Box.GenerateMesh(EditMesh, ApplyTransform);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
 }
 
 void UDynamicCube::Reset() 
 {
-	mTranslation = FVector::Zero();
-	mRotation = FRotator(0.f, 0.f, 0.f);
-	mSize = FVector(100.f, 100.f, 100.f);
-	mScale = FVector(1.f);
-	mGeometryOptions = FGeometryScriptPrimitiveOptions();
-	mOriginMode = EGeometryScriptPrimitiveOriginMode::Base;
-}
\ No newline at end of file
+	Box.Reset();
+}
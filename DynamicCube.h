@@ -7,6 +7,7 @@
 #include "UDynamicMesh.h"
 #include "GeometryScript/MeshPrimitiveFunctions.h"
 #include "GeometryScript/MeshBasicEditFunctions.h"
+#include "DynamicBox.h"
 #include "DynamicCube.generated.h"
 
 /**
@@ -14,6 +15,7 @@
  * Instead of having a bunch of different static methods to call, which becomes confusing, this class takes all the inputs and 
  * customizations to the given shape up-front and then applies it when `GetMesh()` is called.
  * 
+ * This is a thin Blueprint wrapper around FDynamicBox, C++ code should use FDynamicBox directly.
  */
 UCLASS()
 class PROCEDURALBUILDINGS_API UDynamicCube : public UObject
@@ -79,12 +81,8 @@ public:
 	// todo twist
 	// todo rounded rectangle, etc
 
+	const FDynamicBox& GetBox() const { return Box; }
+
 private:
-	FVector mScale = FVector(1.f);
-	FVector mSize = FVector(100.f, 100.f, 100.f);
-	FVector mOrigin = FVector::Zero();
-	FVector mTranslation = FVector::Zero();
-	FRotator mRotation = FRotator();
-	FGeometryScriptPrimitiveOptions mGeometryOptions;
-	EGeometryScriptPrimitiveOriginMode mOriginMode = EGeometryScriptPrimitiveOriginMode::Base;
+	FDynamicBox Box;
 };
\ No newline at end of file
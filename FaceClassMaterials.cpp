@@ -0,0 +1,115 @@
+#include "FaceClassMaterials.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "UVUtilities.h"
+
+using namespace UE::Geometry;
+
+const FName FaceClassMaterials::LAYER_NAME = FName(TEXT("FaceClass"));
+
+int32 FaceClassMaterials::EnableFaceClasses(FDynamicMesh3& Mesh)
+{
+	if (!Mesh.HasAttributes()) {
+		Mesh.EnableAttributes();
+	}
+	int32 LayerIndex = FindFaceClassLayer(Mesh);
+	if (LayerIndex == INDEX_NONE) {
+		LayerIndex = Mesh.Attributes()->NumPolygroupLayers();
+		Mesh.Attributes()->SetNumPolygroupLayers(LayerIndex + 1);
+		Mesh.Attributes()->GetPolygroupLayer(LayerIndex)->SetName(LAYER_NAME);
+	}
+	return LayerIndex;
+}
+
+int32 FaceClassMaterials::FindFaceClassLayer(const FDynamicMesh3& Mesh)
+{
+	if (!Mesh.HasAttributes()) {
+		return INDEX_NONE;
+	}
+	for (int32 LayerIndex = 0; LayerIndex < Mesh.Attributes()->NumPolygroupLayers(); LayerIndex++) {
+		if (Mesh.Attributes()->GetPolygroupLayer(LayerIndex)->GetName() == LAYER_NAME) {
+			return LayerIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+EBuildingFaceClass FaceClassMaterials::ClassifyNormal(const FVector3d& Normal)
+{
+	// a tolerance instead of comparing against exact up/down/side vectors, rotated or welded geometry is rarely exact
+	if (Normal.Z >= 0.9) {
+		return EBuildingFaceClass::Top;
+	}
+	if (Normal.Z <= -0.9) {
+		return EBuildingFaceClass::Bottom;
+	}
+	if (FMath::Abs(Normal.Z) <= 0.42) {
+		return EBuildingFaceClass::Side;
+	}
+	return EBuildingFaceClass::None;
+}
+
+EBuildingFaceClass FaceClassMaterials::GetFaceClass(const FDynamicMesh3& Mesh, int32 TriangleID, int32 LayerIndex)
+{
+	if (LayerIndex != INDEX_NONE) {
+		const int32 Tag = Mesh.Attributes()->GetPolygroupLayer(LayerIndex)->GetValue(TriangleID);
+		if (Tag != 0) {
+			return static_cast<EBuildingFaceClass>(Tag);
+		}
+	}
+	return ClassifyNormal(Mesh.GetTriNormal(TriangleID));
+}
+
+void FaceClassMaterials::ApplyMaterials(UDynamicMesh* Mesh, const TArray<FFaceClassMaterialRule>& Rules)
+{
+	if (Mesh == nullptr || Rules.IsEmpty()) {
+		return;
+	}
+	Mesh->EditMesh([&](FDynamicMesh3& EditMesh)
+	{
+		ApplyMaterials(EditMesh, Rules);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
+}
+
+void FaceClassMaterials::ApplyMaterials(FDynamicMesh3& Mesh, const TArray<FFaceClassMaterialRule>& Rules)
+{
+	if (Rules.IsEmpty()) {
+		return;
+	}
+	if (!Mesh.HasAttributes()) {
+		Mesh.EnableAttributes();
+	}
+	if (!Mesh.Attributes()->HasMaterialID()) {
+		Mesh.Attributes()->EnableMaterialID();
+	}
+	FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.Attributes()->GetMaterialID();
+	const int32 LayerIndex = FindFaceClassLayer(Mesh);
+
+	// ================ MATERIAL IDS ===================
+	// one sweep, the first rule that matches a triangle owns it
+	TArray<int32> TriangleSlots;
+	TriangleSlots.Init(INDEX_NONE, Mesh.MaxTriangleID());
+	TArray<FTransform> SlotTransforms;
+	for (const FFaceClassMaterialRule& Rule : Rules) {
+		SlotTransforms.Add(Rule.UVTransform);
+	}
+	for (int32 TriangleID : Mesh.TriangleIndicesItr()) {
+		const EBuildingFaceClass FaceClass = GetFaceClass(Mesh, TriangleID, LayerIndex);
+		const int32 SourceMaterialID = MaterialIDs->GetValue(TriangleID);
+		for (int32 RuleIndex = 0; RuleIndex < Rules.Num(); RuleIndex++) {
+			const FFaceClassMaterialRule& Rule = Rules[RuleIndex];
+			const bool bClassMatches = (Rule.FaceClasses == EBuildingFaceClass::All) || EnumHasAnyFlags(Rule.FaceClasses, FaceClass);
+			if (!bClassMatches || (Rule.SourceMaterialID != INDEX_NONE && Rule.SourceMaterialID != SourceMaterialID)) {
+				continue;
+			}
+			MaterialIDs->SetValue(TriangleID, Rule.MaterialID);
+			if (Rule.bProjectUVs) {
+				TriangleSlots[TriangleID] = RuleIndex;
+			}
+			break;
+		}
+	}
+
+	// ================ UVS ===================
+	// every rule is projected in the same batch, nothing else in the mesh is touched
+	UUVUtilities::ProjectBoxUVs(Mesh, TriangleSlots, SlotTransforms);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UDynamicMesh.h"
+#include "DynamicMesh/DynamicMesh3.h"
+
+// Which side of a primitive a triangle belongs to, stored per triangle in the "FaceClass" polygroup layer
+enum class EBuildingFaceClass : uint8
+{
+	None = 0,
+	Top = 1 << 0,
+	Bottom = 1 << 1,
+	Side = 1 << 2,
+	TopBottom = Top | Bottom,
+	All = Top | Bottom | Side
+};
+ENUM_CLASS_FLAGS(EBuildingFaceClass)
+
+// A material id assigned to part of a mesh, and the box projection the uvs of that part are generated with
+struct PROCEDURALBUILDINGS_API FFaceClassMaterialRule
+{
+	// triangles of these classes match
+	EBuildingFaceClass FaceClasses = EBuildingFaceClass::All;
+	// only triangles that have this material id before the pass match, INDEX_NONE matches any material
+	int32 SourceMaterialID = INDEX_NONE;
+	int32 MaterialID = 0;
+	bool bProjectUVs = true;
+	// box projection, the scale is the size of the box (see UUVUtilities::GetMeshUVTransform)
+	FTransform UVTransform = FTransform();
+};
+
+/**
+ * Face class tagging and a single pass material id / uv assignment.
+ *
+ * Primitives (FDynamicBox) tag each triangle with its face class when they are generated, before any transform, so the
+ * class survives rotation, appending and caching. Triangles without a tag (e.g. created by a mesh boolean) are classified 
+ * from their normal with a tolerance.
+ *
+ * ApplyMaterials visits every triangle once: the first matching rule sets its material id, then the uvs of all rules are
+ * box projected into uv channel 0 in one batch (UUVUtilities::ProjectBoxUVs). This replaces a GetTriNormal scan +
+ * RemapMaterialIDs + box projection of the whole mesh per material slot.
+ *
+ * HOWTO:
+ *	TArray<FFaceClassMaterialRule> Rules;
+ *	Rules.Add({ EBuildingFaceClass::TopBottom, INDEX_NONE, TopBottomMatId, true, TopBottomUVTransform });
+ *	Rules.Add({ EBuildingFaceClass::Side, INDEX_NONE, SidesMatId, true, SidesUVTransform });
+ *	FaceClassMaterials::ApplyMaterials(Mesh, Rules);
+ */
+class PROCEDURALBUILDINGS_API FaceClassMaterials
+{
+public:
+	static const FName LAYER_NAME;
+
+	// Index of the face class polygroup layer, added (with every triangle untagged) if the mesh doesn't have one yet
+	static int32 EnableFaceClasses(UE::Geometry::FDynamicMesh3& Mesh);
+
+	// Index of the face class polygroup layer or INDEX_NONE
+	static int32 FindFaceClassLayer(const UE::Geometry::FDynamicMesh3& Mesh);
+
+	// Top/Bottom within ~25 degrees of vertical, Side within ~25 degrees of horizontal, None otherwise
+	static EBuildingFaceClass ClassifyNormal(const FVector3d& Normal);
+
+	// The tagged class of a triangle, or the class of its normal if it isn't tagged
+	static EBuildingFaceClass GetFaceClass(const UE::Geometry::FDynamicMesh3& Mesh, int32 TriangleID, int32 LayerIndex);
+
+	static void ApplyMaterials(UDynamicMesh* Mesh, const TArray<FFaceClassMaterialRule>& Rules);
+	static void ApplyMaterials(UE::Geometry::FDynamicMesh3& Mesh, const TArray<FFaceClassMaterialRule>& Rules);
+};
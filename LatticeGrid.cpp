@@ -2,16 +2,102 @@
 
 
 #include "LatticeGrid.h"
+#include "BuildingStats.h"
+#include "BuildingMeshPool.h"
+#include "LatticeMeshCache.h"
 #include "GeometryScript/MeshBasicEditFunctions.h"
 #include "GeometryScript/MeshQueryFunctions.h"
-#include "GeometryScript/MeshBooleanFunctions.h"
-#include "GeometryScript/MeshMaterialFunctions.h"
 #include "GeometryScript/MeshModelingFunctions.h"
 #include "GeometryScript/MeshNormalsFunctions.h"
 #include "GeometryScript/MeshRepairFunctions.h"
 #include "GeometryScript/MeshPrimitiveFunctions.h"
 #include "GeometryScript/MeshTransformFunctions.h"
-#include "GeometryScript/MeshUVFunctions.h"
+#include "UVUtilities.h"
+#include "BuildingRandom.h"
+#include "DynamicBox.h"
+#include "FaceClassMaterials.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+
+// A lattice row or column: its span across the face (Z for rows, Y for columns) and how far it sticks out
+struct FLatticeBar
+{
+	float Min;
+	float Max;
+	float Depth;
+};
+
+// Add an axis aligned box spanning [YMin, YMax] x [ZMin, ZMax] on the face, extending `Depth` towards -X from `Front`
+static void AddLatticeBox(TArray<FBox>& Boxes, float Depth, float YMin, float YMax, float ZMin, float ZMax, float Front = 0.f)
+{
+	if (YMax - YMin <= KINDA_SMALL_NUMBER || ZMax - ZMin <= KINDA_SMALL_NUMBER || Depth <= KINDA_SMALL_NUMBER) {
+		return;
+	}
+	Boxes.Add(FBox(FVector(Front - Depth, YMin, ZMin), FVector(Front, YMax, ZMax)));
+}
+
+static void AppendLatticeBoxes(UE::Geometry::FDynamicMesh3& Mesh, const TArray<FBox>& Boxes)
+{
+	for (const FBox& Box : Boxes) {
+		FDynamicBox Cube;
+		Cube.SetOriginMode(EGeometryScriptPrimitiveOriginMode::Center);
+		Cube.SetSize(Box.GetSize());
+		Cube.SetTranslation(Box.GetCenter());
+		Cube.GenerateMesh(Mesh);
+	}
+}
+
+// Append only the front of each box, a quad facing -X just in front of the face (used by the coarser LODs)
+static void AppendLatticeQuads(UE::Geometry::FDynamicMesh3& Mesh, const TArray<FBox>& Boxes)
+{
+	using namespace UE::Geometry;
+	if (!Mesh.HasAttributes()) {
+		Mesh.EnableAttributes();
+	}
+	if (!Mesh.Attributes()->HasMaterialID()) {
+		Mesh.Attributes()->EnableMaterialID();
+	}
+	if (!Mesh.HasTriangleGroups()) {
+		Mesh.EnableTriangleGroups();
+	}
+	FDynamicMeshPolygroupAttribute* FaceClasses = Mesh.Attributes()->GetPolygroupLayer(FaceClassMaterials::EnableFaceClasses(Mesh));
+	FDynamicMeshUVOverlay* UVs = Mesh.Attributes()->PrimaryUV();
+	FDynamicMeshNormalOverlay* Normals = Mesh.Attributes()->PrimaryNormals();
+	FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.Attributes()->GetMaterialID();
+	const int32 FaceClass = static_cast<int32>(FaceClassMaterials::ClassifyNormal(-FVector3d::UnitX()));
+
+	for (const FBox& Box : Boxes) {
+		const double X = -LatticeGrid::FLAT_OFFSET;
+		const FVector3d Corners[4] = {
+			FVector3d(X, Box.Min.Y, Box.Min.Z),
+			FVector3d(X, Box.Max.Y, Box.Min.Z),
+			FVector3d(X, Box.Max.Y, Box.Max.Z),
+			FVector3d(X, Box.Min.Y, Box.Max.Z)
+		};
+		int32 Vertices[4];
+		int32 UVElements[4];
+		int32 NormalElements[4];
+		for (int32 Corner = 0; Corner < 4; Corner++) {
+			Vertices[Corner] = Mesh.AppendVertex(Corners[Corner]);
+			// planar uvs, they are replaced when a material slot projects the lattice
+			UVElements[Corner] = UVs->AppendElement(FVector2f((float)Corners[Corner].Y, (float)Corners[Corner].Z) * 0.01f);
+			NormalElements[Corner] = Normals->AppendElement(FVector3f(-1.f, 0.f, 0.f));
+		}
+
+		// wound so the quad faces -X, out of the face
+		const int32 GroupID = Mesh.AllocateTriangleGroup();
+		const FIndex3i Triangles[2] = { FIndex3i(0, 2, 1), FIndex3i(0, 3, 2) };
+		for (const FIndex3i& Triangle : Triangles) {
+			const int32 TriangleID = Mesh.AppendTriangle(FIndex3i(Vertices[Triangle.A], Vertices[Triangle.B], Vertices[Triangle.C]), GroupID);
+			if (TriangleID < 0) {
+				continue;
+			}
+			UVs->SetTriangle(TriangleID, FIndex3i(UVElements[Triangle.A], UVElements[Triangle.B], UVElements[Triangle.C]));
+			Normals->SetTriangle(TriangleID, FIndex3i(NormalElements[Triangle.A], NormalElements[Triangle.B], NormalElements[Triangle.C]));
+			MaterialIDs->SetValue(TriangleID, 0);
+			FaceClasses->SetValue(TriangleID, FaceClass);
+		}
+	}
+}
 
 LatticeGrid::LatticeGrid() {
 }
@@ -20,27 +106,157 @@ LatticeGrid::LatticeGrid(FLatticeGridOptions* Options)
 	: Options(Options)
 {}
 
+FLatticeFaceFrame FLatticeFaceFrame::FromBox(const FBox& Box, const FVector& Normal)
+{
+	FLatticeFaceFrame Frame;
+	Frame.Normal = Normal.GetSafeNormal();
+	Frame.Up = FMath::Abs(Frame.Normal.Z) > 0.5 ? FVector::ForwardVector : FVector::UpVector;
+	const FVector Right = FVector::CrossProduct(Frame.Normal, Frame.Up);
+	const FVector Size = Box.GetSize();
+
+	Frame.Origin = Box.GetCenter() + Frame.Normal * (FMath::Abs(FVector::DotProduct(Size, Frame.Normal)) * 0.5);
+	Frame.Extent = FVector2D(FMath::Abs(FVector::DotProduct(Size, Right)), FMath::Abs(FVector::DotProduct(Size, Frame.Up)));
+	return Frame;
+}
+
+FTransform FLatticeFaceFrame::GetTransform() const
+{
+	// lattice space X points into the face, Z is up and Y completes the basis
+	const FVector XAxis = -Normal;
+	const FVector ZAxis = Up;
+	const FVector YAxis = FVector::CrossProduct(Normal, Up);
+	return FTransform(XAxis, YAxis, ZAxis, Origin);
+}
+
+// Materials already in the set are reused, so the lattice slots are only added once for all faces
+static int8 AddLatticeMaterial(TArray<UMaterialInterface*>& MaterialSet, UMaterialInterface* Material)
+{
+	int32 MatId = MaterialSet.Find(Material);
+	if (MatId == INDEX_NONE) {
+		MatId = MaterialSet.Add(Material);
+	}
+	return MatId;
+}
+
+void LatticeGrid::SetFlat(bool bInFlat)
+{
+	bFlat = bInFlat;
+}
+
+void LatticeGrid::SetMeshPool(FBuildingMeshPool* InMeshPool)
+{
+	MeshPool = InMeshPool;
+}
+
+void LatticeGrid::SetMeshCache(FLatticeMeshCache* InMeshCache)
+{
+	MeshCache = InMeshCache;
+}
+
 void LatticeGrid::ApplyLattice(UDynamicMesh* Mesh, TArray<UMaterialInterface*>& MaterialSet)
 {
-	UE_LOG(LogTemp, Display, TEXT("LatticeGrid Start"));
 	if (Mesh == nullptr) {
-		UE_LOG(LogTemp, Error, TEXT("LatticeGrid Mesh = nullptr"));
+		UE_LOG(LogBuildingGeneration, Error, TEXT("LatticeGrid Mesh = nullptr"));
+		return;
+	}
+	FBox Box = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(Mesh);
+	TArray<FLatticeFaceFrame> Faces;
+	Faces.Add(FLatticeFaceFrame::FromBox(Box, FVector::BackwardVector));
+	ApplyLattice(Mesh, Faces, MaterialSet);
+}
+
+void LatticeGrid::ApplyLattice(UDynamicMesh* Mesh, const TArray<FLatticeFaceFrame>& Faces, TArray<UMaterialInterface*>& MaterialSet)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(LatticeGrid::ApplyLattice);
+	UE_LOG(LogBuildingGeneration, Verbose, TEXT("LatticeGrid Start"));
+	if (Mesh == nullptr) {
+		UE_LOG(LogBuildingGeneration, Error, TEXT("LatticeGrid Mesh = nullptr"));
 		return;
 	}
 	if (!Mesh->IsValidLowLevel()) {
-		UE_LOG(LogTemp, Error, TEXT("LatticeGrid Mesh !IsValidLowLevel"));
+		UE_LOG(LogBuildingGeneration, Error, TEXT("LatticeGrid Mesh !IsValidLowLevel"));
 		return;
 	}
 	if (Options == nullptr) {
-		UE_LOG(LogTemp, Error, TEXT("LatticeGrid Options = nullptr"));
+		UE_LOG(LogBuildingGeneration, Error, TEXT("LatticeGrid Options = nullptr"));
 		return;
 	}
-	FRandomStream RandomStream = FRandomStream(Options->RandomSeed + LatticeGrid::RANDOM_OFFSET);
-	FBox Box = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(Mesh);
 
-	FVector FaceCenter = Box.GetCenter() - FVector(Box.GetSize().X * 0.5, 0.f, 0.f);
-	FVector2D FaceSize = FVector2D(Box.GetSize().Y, Box.GetSize().Z); // X=width, Y=height
-	
+	// opposite faces of a box are the same size, and with the same seed they get the same lattice
+	TArray<TTuple<FVector2D, UDynamicMesh*>> Lattices;
+	for (const FLatticeFaceFrame& Face : Faces) {
+		UDynamicMesh* FaceLattice = nullptr;
+		for (const auto& Built : Lattices) {
+			if (Built.Get<0>().Equals(Face.Extent, KINDA_SMALL_NUMBER)) {
+				FaceLattice = Built.Get<1>();
+				break;
+			}
+		}
+		if (FaceLattice == nullptr) {
+			FaceLattice = FBuildingMeshPool::Acquire(MeshPool);
+			if (MeshCache != nullptr) {
+				FindOrBuildLattice(Face.Extent, MaterialSet, FaceLattice);
+			}
+			else {
+				BuildLattice(Face.Extent, MaterialSet, FaceLattice);
+			}
+			Lattices.Add(MakeTuple(Face.Extent, FaceLattice));
+		}
+
+		// =================== Add Lattice to Provided Mesh ==============================
+		UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
+			Mesh,
+			FaceLattice,
+			Face.GetTransform()
+		);
+	}
+
+	for (const auto& Built : Lattices) {
+		FBuildingMeshPool::Release(MeshPool, Built.Get<1>());
+	}
+
+	UE_LOG(LogBuildingGeneration, Verbose, TEXT("Lattice - Done"));
+}
+
+void LatticeGrid::AddLatticeInstances(const TArray<FLatticeFaceFrame>& Faces, FBuildingInstances& Instances)
+{
+	if (Options == nullptr) {
+		UE_LOG(LogBuildingGeneration, Error, TEXT("LatticeGrid Options = nullptr"));
+		return;
+	}
+
+	// the same layout as ApplyLattice, each bar becomes an instance instead of a box in the mesh
+	TArray<TTuple<FVector2D, FLatticeLayout>> Layouts;
+	for (const FLatticeFaceFrame& Face : Faces) {
+		const FLatticeLayout* FaceLayout = nullptr;
+		for (const auto& Laid : Layouts) {
+			if (Laid.Get<0>().Equals(Face.Extent, KINDA_SMALL_NUMBER)) {
+				FaceLayout = &Laid.Get<1>();
+				break;
+			}
+		}
+		if (FaceLayout == nullptr) {
+			FLatticeLayout& Layout = Layouts.Emplace_GetRef(Face.Extent, FLatticeLayout()).Get<1>();
+			LayoutLattice(Face.Extent, Layout);
+			FaceLayout = &Layout;
+		}
+
+		const FTransform FaceTransform = Face.GetTransform();
+		for (const TArray<FBox>* Bars : { &FaceLayout->Rows, &FaceLayout->Columns, &FaceLayout->BorderH, &FaceLayout->BorderV }) {
+			for (const FBox& Bar : *Bars) {
+				Instances.AddLatticeBar(Bar, FaceTransform);
+			}
+		}
+	}
+}
+
+void LatticeGrid::LayoutLattice(const FVector2D& FaceSize, FLatticeLayout& Layout) const
+{
+	// every bar draws from its own element, so rows and columns don't shift each other when one changes
+	const FBuildingRandom Random = FBuildingRandom(Options->RandomSeed + LatticeGrid::RANDOM_OFFSET);
+	const FBuildingRandom RowRandom = Random.Stage(EBuildingRandomStage::LatticeRows);
+	const FBuildingRandom ColRandom = Random.Stage(EBuildingRandomStage::LatticeColumns);
+
 	FVector2D LatticeArea = FaceSize; // X=width, Y=height
 	if (Options->bHasBorder) {
 		LatticeArea -= FVector2D(Options->BorderSize.Y * 2, Options->BorderSize.X * 2);
@@ -79,43 +295,28 @@ void LatticeGrid::ApplyLattice(UDynamicMesh* Mesh, TArray<UMaterialInterface*>&
 	int32 MaxCols = Options->Columns < 1 ? LatticeGrid::MAX_LATTICES : Options->Columns;
 	MaxCols = Options->bHasColumns ? MaxCols : 0;
 
-	// we'll be reusing this a good number of times
-	FTransform ZeroTransform = FTransform();
-
 	// =======================================================================
-	// =================== BUILD LATTICE =====================================
+	// =================== LAYOUT LATTICE ====================================
 	// =======================================================================
 
 	// Bottom left coordinate of the mesh face
 	FVector2D BottomLeft = FVector2D(-(LatticeArea.X * 0.5), -(LatticeArea.Y * 0.5));
 
-	// what materials should we assign
-	const bool HasGlobalMaterial = Options->MaterialSlots.Contains(ELatticeMaterialSlots::All);
-	const bool HasFramingMaterial = Options->MaterialSlots.Contains(ELatticeMaterialSlots::Framing_All);
-	const bool HasBorderMaterial = Options->MaterialSlots.Contains(ELatticeMaterialSlots::Border_All);
-
 	float UsedWidth = 0.f;
 	float UsedHeight = 0.f;
-	// TODO these could all be moved as class members and reused for the duration of the class instance...
-	UDynamicMesh* CombinedMesh = NewObject<UDynamicMesh>();
-	UDynamicMesh* BorderHMesh = NewObject<UDynamicMesh>();
-	UDynamicMesh* BorderVMesh = NewObject<UDynamicMesh>();
-	UDynamicMesh* RowsMesh = NewObject<UDynamicMesh>();
-	UDynamicMesh* ColsMesh = NewObject<UDynamicMesh>();
-	UDynamicMesh* ToolMesh = NewObject<UDynamicMesh>();
-
-	// =================== BUILD ROWS ======================================
+
+	// =================== LAYOUT ROWS ======================================
+	// Each bar is a span on the face (Z for rows, Y for columns) and a depth, the face is the plane X=0 and bars extend towards -X
+	TArray<FLatticeBar> RowBars;
 	for (int Row = 0; Row < MaxRows; Row++) {
-		float Width = LatticeArea.X;
-		float Thickness = FMath::Min(RandomStream.FRandRange(VThicknessRange.GetLowerBoundValue(), VThicknessRange.GetUpperBoundValue()), LatticeArea.Y);
-		float Depth = FMath::Max(RandomStream.FRandRange(DepthRange.GetLowerBoundValue(), DepthRange.GetUpperBoundValue()), 1.f);
-		float VSpacing = FMath::Min(RandomStream.FRandRange(VSpacingRange.GetLowerBoundValue(), VSpacingRange.GetUpperBoundValue()), LatticeArea.Y);
+		const FBuildingRandom RowElement = RowRandom.Element(Row);
+		float Thickness = FMath::Min(RowElement.FRandRange(VThicknessRange.GetLowerBoundValue(), VThicknessRange.GetUpperBoundValue(), 0), LatticeArea.Y);
+		float Depth = FMath::Max(RowElement.FRandRange(DepthRange.GetLowerBoundValue(), DepthRange.GetUpperBoundValue(), 1), 1.f);
+		float VSpacing = FMath::Min(RowElement.FRandRange(VSpacingRange.GetLowerBoundValue(), VSpacingRange.GetUpperBoundValue(), 2), LatticeArea.Y);
 
 		UsedHeight += VSpacing + Thickness;
 
-		UE_LOG(LogTemp, Display, TEXT("LatticeGrid Row[%i] - AvailHeight: %f, UsedHeight: %f, Width: %f, Thick: %f, Depth: %f, VSpace: %f"), Row, LatticeArea.Y, UsedHeight, Width, Thickness, Depth, VSpacing);
-
-		FVector RowOrigin = FVector(0.f, 0.f, UsedHeight - (Thickness * 0.5));
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid Row[%i] - AvailHeight: %f, UsedHeight: %f, Width: %f, Thick: %f, Depth: %f, VSpace: %f"), Row, LatticeArea.Y, UsedHeight, LatticeArea.X, Thickness, Depth, VSpacing);
 
 		// exit early if we'll exceed the usable area
 		if (UsedHeight > LatticeArea.Y) {
@@ -123,54 +324,25 @@ void LatticeGrid::ApplyLattice(UDynamicMesh* Mesh, TArray<UMaterialInterface*>&
 			break;
 		}
 
-		ToolMesh->Reset();
-
-		// create a rectangle to extrude, this will create a box with it's back face missing
-		auto RectOptions = FGeometryScriptPrimitiveOptions();
-		FTransform RectTransform = FTransform(FQuat(FRotator(0.f, -90.f, -90.f)));
-		RectTransform.SetTranslation(RowOrigin);
-		UGeometryScriptLibrary_MeshPrimitiveFunctions::AppendRectangleXY(
-			ToolMesh,
-			RectOptions,
-			RectTransform,
-			Width,
-			Thickness,
-			2,
-			2);
-
-		// extrude outward from the center (negative x direction)
-		auto ExtrudeOptions = FGeometryScriptMeshExtrudeOptions();
-		ExtrudeOptions.bSolidsToShells = false;
-		ExtrudeOptions.ExtrudeDirection = FVector::BackwardVector;
-		ExtrudeOptions.ExtrudeDistance = Depth;
-		UGeometryScriptLibrary_MeshModelingFunctions::ApplyMeshExtrude( // THIS WAS CHANGED IN 5.1
-			ToolMesh,
-			ExtrudeOptions
-		);
-
-		UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-			RowsMesh,
-			ToolMesh, // mesh to append
-			ZeroTransform
-		);
+		RowBars.Add({ UsedHeight - Thickness, UsedHeight, Depth });
 	}
 
-	// =================== BUILD COLUMNS ======================================
+	// =================== LAYOUT COLUMNS ======================================
+	TArray<FLatticeBar> ColBars;
 	for (int Col = 0; Col < MaxCols; Col++) {
-		float Height = LatticeArea.Y;
-		float Thickness = FMath::Min(RandomStream.FRandRange(HThicknessRange.GetLowerBoundValue(), HThicknessRange.GetUpperBoundValue()), LatticeArea.X);
-		float Depth = FMath::Max(RandomStream.FRandRange(DepthRange.GetLowerBoundValue(), DepthRange.GetUpperBoundValue()), 1.f);
-		float HSpacing = FMath::Min(RandomStream.FRandRange(HSpacingRange.GetLowerBoundValue(), HSpacingRange.GetUpperBoundValue()), LatticeArea.X);
+		const FBuildingRandom ColElement = ColRandom.Element(Col);
+		float Thickness = FMath::Min(ColElement.FRandRange(HThicknessRange.GetLowerBoundValue(), HThicknessRange.GetUpperBoundValue(), 0), LatticeArea.X);
+		float Depth = FMath::Max(ColElement.FRandRange(DepthRange.GetLowerBoundValue(), DepthRange.GetUpperBoundValue(), 1), 1.f);
+		float HSpacing = FMath::Min(ColElement.FRandRange(HSpacingRange.GetLowerBoundValue(), HSpacingRange.GetUpperBoundValue(), 2), LatticeArea.X);
 
 		UsedWidth += HSpacing + Thickness;
 
-		UE_LOG(LogTemp, Display, TEXT("LatticeGrid Col[%i] - AvailWidth: %f, UsedWidth: %f, Height: %f, Thick: %f, Depth: %f, HSpace: %f"), Col, LatticeArea.X, UsedWidth, Height, Thickness, Depth, HSpacing);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid Col[%i] - AvailWidth: %f, UsedWidth: %f, Height: %f, Thick: %f, Depth: %f, HSpace: %f"), Col, LatticeArea.X, UsedWidth, LatticeArea.Y, Thickness, Depth, HSpacing);
 
 		// TODO this is wrong, the mesh is automatically centered on the parent mesh when placed.
 		// so we don't want to apply spacing to the first element before it's placed.
 		// also in this configuration there is no spacing after the last element...
 		// we want ||  <column> <space> <column> <space> <column>  ||
-		FVector ColOrigin = FVector(0.f, UsedWidth - (Thickness * 0.5), 0.f);
 
 		// exit early if we'll exceed the usable area
 		if (UsedWidth > LatticeArea.X) {
@@ -178,241 +350,202 @@ void LatticeGrid::ApplyLattice(UDynamicMesh* Mesh, TArray<UMaterialInterface*>&
 			break;
 		}
 
-		ToolMesh->Reset();
-
-		auto RectOptions = FGeometryScriptPrimitiveOptions();
-		// create a rectangle for our boolean
-		FTransform RectTransform = FTransform(FQuat(FRotator(0.f, -90.f, -90.f)));
-		RectTransform.SetTranslation(ColOrigin);
-		UGeometryScriptLibrary_MeshPrimitiveFunctions::AppendRectangleXY(
-			ToolMesh,
-			RectOptions,
-			RectTransform,
-			Thickness,
-			Height,
-			0,
-			0);
-
-		// extrude outward from the center (negative x direction)
-		auto ExtrudeOptions = FGeometryScriptMeshExtrudeOptions();
-		ExtrudeOptions.bSolidsToShells = false;
-		ExtrudeOptions.ExtrudeDirection = FVector::BackwardVector;
-		ExtrudeOptions.ExtrudeDistance = Depth;
-		UGeometryScriptLibrary_MeshModelingFunctions::ApplyMeshExtrude( // THIS WAS CHANGED IN 5.1
-			ToolMesh,
-			ExtrudeOptions
-		);
+		ColBars.Add({ UsedWidth - Thickness, UsedWidth, Depth });
+	}
 
-		UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-			ColsMesh,
-			ToolMesh, // mesh to append
-			ZeroTransform
-		);
+	// =================== CENTER ROWS/COLS ===============================
+	for (FLatticeBar& Bar : RowBars) {
+		Bar.Min -= UsedHeight * 0.5;
+		Bar.Max -= UsedHeight * 0.5;
+	}
+	for (FLatticeBar& Bar : ColBars) {
+		Bar.Min -= UsedWidth * 0.5;
+		Bar.Max -= UsedWidth * 0.5;
+	}
+
+	// =================== ROW/COL BOXES ======================================
+	// Columns run the full height, rows are split into segments that stop at the side of each column. Where a row is 
+	// deeper than the column it crosses, a cap covers the difference in front of the column. Nothing overlaps, so no 
+	// boolean is needed to get rid of z-fighting where the bars cross. A flat lattice has no caps, every bar's quad is
+	// at the same depth, so a cap would only cover the column quad it sits on.
+	for (const FLatticeBar& Col : ColBars) {
+		AddLatticeBox(Layout.Columns, Col.Depth, Col.Min, Col.Max, -(LatticeArea.Y * 0.5), LatticeArea.Y * 0.5);
+	}
+
+	for (const FLatticeBar& Row : RowBars) {
+		float SegmentStart = -(LatticeArea.X * 0.5);
+		for (const FLatticeBar& Col : ColBars) {
+			AddLatticeBox(Layout.Rows, Row.Depth, SegmentStart, Col.Min, Row.Min, Row.Max);
+			if (Row.Depth > Col.Depth && !bFlat) {
+				AddLatticeBox(Layout.Rows, Row.Depth - Col.Depth, Col.Min, Col.Max, Row.Min, Row.Max, -Col.Depth);
+			}
+			SegmentStart = Col.Max;
+		}
+		AddLatticeBox(Layout.Rows, Row.Depth, SegmentStart, LatticeArea.X * 0.5, Row.Min, Row.Max);
+	}
+
+	// =================== BORDER BOXES ======================================
+	if (Options->bHasBorder) {
+		float HThickness = Options->BorderSize.X;
+		float VThickness = Options->BorderSize.Y;
+		float BorderDepth = Options->BorderSize.Z;
 
+		float BorderWidth = FaceSize.X;
+		float BorderHeight = FaceSize.Y - (HThickness * 2);
+
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid Border - Width: %f, Height: %f, HThickness: %f, VThickness: %f, Depth: %f"), BorderWidth, BorderHeight, HThickness, VThickness, BorderDepth);
+
+		// left/right pieces fit between the top/bottom pieces
+		AddLatticeBox(Layout.BorderV, BorderDepth, -(FaceSize.X * 0.5), -(FaceSize.X * 0.5) + VThickness, -(BorderHeight * 0.5), BorderHeight * 0.5);
+		AddLatticeBox(Layout.BorderV, BorderDepth, (FaceSize.X * 0.5) - VThickness, FaceSize.X * 0.5, -(BorderHeight * 0.5), BorderHeight * 0.5);
+
+		// top/bottom pieces run the full width
+		AddLatticeBox(Layout.BorderH, BorderDepth, -(BorderWidth * 0.5), BorderWidth * 0.5, (FaceSize.Y * 0.5) - HThickness, FaceSize.Y * 0.5);
+		AddLatticeBox(Layout.BorderH, BorderDepth, -(BorderWidth * 0.5), BorderWidth * 0.5, -(FaceSize.Y * 0.5), -(FaceSize.Y * 0.5) + HThickness);
 	}
+}
+
+
+void LatticeGrid::BuildLattice(const FVector2D& FaceSize, TArray<UMaterialInterface*>& MaterialSet, UDynamicMesh* LatticeMesh)
+{
+	const FBuildingRandom Random = FBuildingRandom(Options->RandomSeed + LatticeGrid::RANDOM_OFFSET);
+
+	FLatticeLayout Layout;
+	LayoutLattice(FaceSize, Layout);
+
+	// we'll be reusing this a good number of times
+	FTransform ZeroTransform = FTransform();
+
+	// what materials should we assign
+	const bool HasGlobalMaterial = Options->MaterialSlots.Contains(ELatticeMaterialSlots::All);
+	const bool HasFramingMaterial = Options->MaterialSlots.Contains(ELatticeMaterialSlots::Framing_All);
+	const bool HasBorderMaterial = Options->MaterialSlots.Contains(ELatticeMaterialSlots::Border_All);
+
+	// the pieces are built in scratch meshes that go back to the pool once they are merged into `LatticeMesh`
+	UDynamicMesh* CombinedMesh = LatticeMesh;
+	FScopedBuildingMesh BorderHScratch(MeshPool);
+	FScopedBuildingMesh BorderVScratch(MeshPool);
+	FScopedBuildingMesh RowsScratch(MeshPool);
+	FScopedBuildingMesh ColsScratch(MeshPool);
+	UDynamicMesh* BorderHMesh = BorderHScratch.Get();
+	UDynamicMesh* BorderVMesh = BorderVScratch.Get();
+	UDynamicMesh* RowsMesh = RowsScratch.Get();
+	UDynamicMesh* ColsMesh = ColsScratch.Get();
+
+	// a flat lattice only has the front of each bar
+	auto AppendBars = [this](UE::Geometry::FDynamicMesh3& Mesh, const TArray<FBox>& Boxes)
+	{
+		if (bFlat) {
+			AppendLatticeQuads(Mesh, Boxes);
+		}
+		else {
+			AppendLatticeBoxes(Mesh, Boxes);
+		}
+	};
 
-	// =================== TRANSFORM ROWS/COLS TO BE CENTERED ===============================
-	// center in the Z axis
-	UGeometryScriptLibrary_MeshTransformFunctions::TranslateMesh(RowsMesh, FVector(0.f, 0.f, UsedHeight * 0.5 * -1));
+	// =================== BUILD ROWS/COLS ======================================
+	{
+		UE::Geometry::FDynamicMesh3 RowsBars;
+		AppendBars(RowsBars, Layout.Rows);
+		RowsMesh->SetMesh(MoveTemp(RowsBars));
 
-	// center in the Y axis
-	UGeometryScriptLibrary_MeshTransformFunctions::TranslateMesh(ColsMesh, FVector(0.f, UsedWidth * 0.5 * -1, 0.f));
+		UE::Geometry::FDynamicMesh3 ColsBars;
+		AppendBars(ColsBars, Layout.Columns);
+		ColsMesh->SetMesh(MoveTemp(ColsBars));
+	}
 
 	// =================== FRAMING MATERIALS ================================================
 	auto FramingMatOps = TArray<TTuple<UDynamicMesh*, int8>>();
 	if ((Options->bHasRows || Options->bHasColumns) && !HasGlobalMaterial && Options->MaterialSlots.Contains(ELatticeMaterialSlots::Framing_All)) {
 		// get the next available material id
-		int8 MatId = MaterialSet.Num();
-		// add our material to the MaterialSet array, this array will be set on the component as the list of active materials.
-		MaterialSet.Add(Options->MaterialSlots[ELatticeMaterialSlots::Framing_All]);
+		int8 MatId = AddLatticeMaterial(MaterialSet, Options->MaterialSlots[ELatticeMaterialSlots::Framing_All]);
 		// apply the same material id to both meshes the `Framing_All` means we are applying the same material to all framing.
 		FramingMatOps.Add(MakeTuple(RowsMesh, MatId));
 		FramingMatOps.Add(MakeTuple(ColsMesh, MatId));
-		UE_LOG(LogTemp, Display, TEXT("LatticeGrid MatId[%i] (Framing_All)"), MatId);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid MatId[%i] (Framing_All)"), MatId);
 	}
 	if (Options->bHasRows && !HasGlobalMaterial && !HasFramingMaterial && Options->MaterialSlots.Contains(ELatticeMaterialSlots::Framing_Horizontal)) {
-		int8 MatId = MaterialSet.Num();
-		MaterialSet.Add(Options->MaterialSlots[ELatticeMaterialSlots::Framing_Horizontal]);
+		int8 MatId = AddLatticeMaterial(MaterialSet, Options->MaterialSlots[ELatticeMaterialSlots::Framing_Horizontal]);
 		FramingMatOps.Add(MakeTuple(RowsMesh, MatId));
-		UE_LOG(LogTemp, Display, TEXT("LatticeGrid MatId[%i] (Framing_Horizontal)"), MatId);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid MatId[%i] (Framing_Horizontal)"), MatId);
 	}
 	if (Options->bHasColumns && !HasGlobalMaterial && !HasFramingMaterial && Options->MaterialSlots.Contains(ELatticeMaterialSlots::Framing_Vertical)) {
-		int8 MatId = MaterialSet.Num();
-		MaterialSet.Add(Options->MaterialSlots[ELatticeMaterialSlots::Framing_Vertical]);
+		int8 MatId = AddLatticeMaterial(MaterialSet, Options->MaterialSlots[ELatticeMaterialSlots::Framing_Vertical]);
 		FramingMatOps.Add(MakeTuple(ColsMesh, MatId));
-		UE_LOG(LogTemp, Display, TEXT("LatticeGrid MatId[%i] (Framing_Vertical)"), MatId);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid MatId[%i] (Framing_Vertical)"), MatId);
 	}
 
 	// apply material id's to the meshes provided.
-	for (const auto& MatOps : FramingMatOps) {
+	for (int32 OpIndex = 0; OpIndex < FramingMatOps.Num(); OpIndex++) {
+		const auto& MatOps = FramingMatOps[OpIndex];
 		UDynamicMesh* MatMesh = MatOps.Get<0>();
 		int8 MatId = MatOps.Get<1>();
 
-		// change the default material id, to the assigned material.
-		UGeometryScriptLibrary_MeshMaterialFunctions::RemapMaterialIDs(
-			MatMesh,
-			0,
-			MatId
-		);
-
 		FBox Bounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(MatMesh);
-		FTransform UVTransform = GetMeshUVTransform(Bounds, Options->UVScaleMode, Options->UVOriginMode, &RandomStream, Options->UVSize);
-		UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-			MatMesh,
-			MatId,
-			UVTransform, 
-			2); // min island tri count
+		FBuildingRandom UVRandom = Random.Stage(EBuildingRandomStage::LatticeFramingUVs).Element(OpIndex);
+		FTransform UVTransform = UUVUtilities::GetMeshUVTransform(Bounds, Options->UVScaleMode, Options->UVOriginMode, UVRandom, Options->UVSize);
+		// change the default material id to the assigned material and project its uvs in one pass
+		TArray<FFaceClassMaterialRule> Rules;
+		Rules.Add({ EBuildingFaceClass::All, 0, MatId, true, UVTransform });
+		FaceClassMaterials::ApplyMaterials(MatMesh, Rules);
 	}
 
 
-	// =================== UNION ROWS AND COLUMNS ================================================
-	// Combine the Rows/Cols Meshes
+	// =================== COMBINE ROWS AND COLUMNS ================================================
+	// the bars don't overlap, so the meshes are simply appended
 	UDynamicMesh* CombinedLatticeMesh = RowsMesh;
-	// By unioning the two lattice meshes (rows/columns) we'll ensure there is no Z fighting at the intersections.
-	UE_LOG(LogTemp, Display, TEXT("LatticeGrid - ApplyMeshBoolean"));
-	UGeometryScriptLibrary_MeshBooleanFunctions::ApplyMeshBoolean(
-		CombinedLatticeMesh,      // target mesh
-		ZeroTransform,  // target mesh transform
-		ColsMesh,      // tool mesh
-		ZeroTransform,  // location of the tool mesh
-		EGeometryScriptBooleanOperation::Union,  // subtract, intersect, union
-		FGeometryScriptMeshBooleanOptions()  // fill-holes, simplify, etc
+	UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
+		CombinedLatticeMesh,
+		ColsMesh,
+		ZeroTransform
 	);
 
 	// =======================================================================
 	// =================== BUILD BORDER ======================================
 	// =======================================================================
 	if (Options->bHasBorder) {
-		UE_LOG(LogTemp, Display, TEXT("LatticeGrid - Building Border"));
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid - Building Border"));
 
-		float HThickness = Options->BorderSize.X;
-		float VThickness = Options->BorderSize.Y;
-		float BorderDepth = Options->BorderSize.Z;
+		// left/right pieces fit between the top/bottom pieces
+		UE::Geometry::FDynamicMesh3 BorderV;
+		AppendBars(BorderV, Layout.BorderV);
+		BorderVMesh->SetMesh(MoveTemp(BorderV));
 
-		float BorderWidth = FaceSize.X;
-		float BorderHeight = FaceSize.Y - (HThickness * 2);
-
-		// left right pieces
-		const FVector LeftOrigin = FVector(0.f, -(FaceSize.X * 0.5) + (VThickness * 0.5), 0.f);
-		const FVector RightOrigin = FVector(0.f, (FaceSize.X * 0.5) - (VThickness * 0.5), 0.f);
-		auto LeftRight = TArray<FVector>();
-		LeftRight.Add(LeftOrigin);
-		LeftRight.Add(RightOrigin);
-
-		// top bottom pieces
-		const FVector TopOrigin = FVector(0.f, 0.f, (FaceSize.Y * 0.5) - (HThickness * 0.5));
-		const FVector BottomOrigin = FVector(0.f, 0.f, -(FaceSize.Y * 0.5) + (HThickness * 0.5));
-		auto TopBottom = TArray<FVector>();
-		TopBottom.Add(TopOrigin);
-		TopBottom.Add(BottomOrigin);
-
-		UE_LOG(LogTemp, Display, TEXT("LatticeGrid Border - Width: %f, Height: %f, HThickness: %f, VThickness: %f, Depth: %f, HSpace: %f"), BorderWidth, BorderHeight, HThickness, VThickness, BorderDepth);
-
-		// create left/right extrusions
-		for (const auto& SideOrigin : LeftRight) {
-			ToolMesh->Reset();
-			auto RectOptions = FGeometryScriptPrimitiveOptions();
-			// create a rectangle for our boolean
-			FTransform RectTransform = FTransform(FQuat(FRotator(0.f, -90.f, -90.f))); // orient so height is along the +Y axis and face points FVector::BackwardVector (-X)
-			RectTransform.SetTranslation(SideOrigin);
-			UGeometryScriptLibrary_MeshPrimitiveFunctions::AppendRectangleXY(
-				ToolMesh,
-				RectOptions,
-				RectTransform,
-				VThickness,
-				BorderHeight,
-				0,
-				0);
-
-			// extrude outward from the center (negative x direction)
-			auto ExtrudeOptions = FGeometryScriptMeshExtrudeOptions();
-			ExtrudeOptions.bSolidsToShells = false;
-			ExtrudeOptions.ExtrudeDirection = FVector::BackwardVector;
-			ExtrudeOptions.ExtrudeDistance = BorderDepth;
-			UGeometryScriptLibrary_MeshModelingFunctions::ApplyMeshExtrude( // THIS WAS CHANGED IN 5.1
-				ToolMesh,
-				ExtrudeOptions
-			);
-
-			UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-				BorderVMesh,
-				ToolMesh, // mesh to append
-				ZeroTransform
-			);
-		}
-
-		// create left/right extrusions
-		for (const auto& TopBotOrigin : TopBottom) {
-			ToolMesh->Reset();
-			auto RectOptions = FGeometryScriptPrimitiveOptions();
-			// create a rectangle for our boolean
-			FTransform RectTransform = FTransform(FQuat(FRotator(0.f, -90.f, -90.f))); // orient so height is along the +Y axis and face points FVector::BackwardVector (-X)
-			RectTransform.SetTranslation(TopBotOrigin);
-			UGeometryScriptLibrary_MeshPrimitiveFunctions::AppendRectangleXY(
-				ToolMesh,
-				RectOptions,
-				RectTransform,
-				BorderWidth,
-				HThickness,
-				0,
-				0);
-
-			// extrude outward from the center (negative x direction)
-			auto ExtrudeOptions = FGeometryScriptMeshExtrudeOptions();
-			ExtrudeOptions.bSolidsToShells = false;
-			ExtrudeOptions.ExtrudeDirection = FVector::BackwardVector;
-			ExtrudeOptions.ExtrudeDistance = BorderDepth;
-			UGeometryScriptLibrary_MeshModelingFunctions::ApplyMeshExtrude( // THIS WAS CHANGED IN 5.1
-				ToolMesh,
-				ExtrudeOptions
-			);
-
-			UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-				BorderHMesh,
-				ToolMesh, // mesh to append
-				ZeroTransform
-			);
-		}
+		// top/bottom pieces run the full width
+		UE::Geometry::FDynamicMesh3 BorderH;
+		AppendBars(BorderH, Layout.BorderH);
+		BorderHMesh->SetMesh(MoveTemp(BorderH));
 
 		auto BorderMatOps = TArray<TTuple<UDynamicMesh*, int8>>();
 		if (!HasGlobalMaterial && Options->MaterialSlots.Contains(ELatticeMaterialSlots::Border_All)) {
-			int8 MatId = MaterialSet.Num();
-			MaterialSet.Add(Options->MaterialSlots[ELatticeMaterialSlots::Border_All]);
+			int8 MatId = AddLatticeMaterial(MaterialSet, Options->MaterialSlots[ELatticeMaterialSlots::Border_All]);
 			BorderMatOps.Add(MakeTuple(BorderHMesh, MatId));
 			BorderMatOps.Add(MakeTuple(BorderVMesh, MatId));
-			UE_LOG(LogTemp, Display, TEXT("LatticeGrid MatId[%i] (Border_All)"), MatId);
+			UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid MatId[%i] (Border_All)"), MatId);
 		}
 		if (!HasGlobalMaterial && !HasBorderMaterial && Options->MaterialSlots.Contains(ELatticeMaterialSlots::Border_Horizontal)) {
-			int8 MatId = MaterialSet.Num();
-			MaterialSet.Add(Options->MaterialSlots[ELatticeMaterialSlots::Border_Horizontal]);
+			int8 MatId = AddLatticeMaterial(MaterialSet, Options->MaterialSlots[ELatticeMaterialSlots::Border_Horizontal]);
 			BorderMatOps.Add(MakeTuple(BorderHMesh, MatId));
-			UE_LOG(LogTemp, Display, TEXT("LatticeGrid MatId[%i] (Border_Horizontal)"), MatId);
+			UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid MatId[%i] (Border_Horizontal)"), MatId);
 		}
 		if (!HasGlobalMaterial && !HasBorderMaterial && Options->MaterialSlots.Contains(ELatticeMaterialSlots::Border_Vertical)) {
-			int8 MatId = MaterialSet.Num();
-			MaterialSet.Add(Options->MaterialSlots[ELatticeMaterialSlots::Border_Vertical]);
-			BorderMatOps.Add(MakeTuple(BorderHMesh, MatId));
-			UE_LOG(LogTemp, Display, TEXT("LatticeGrid MatId[%i] (Border_Vertical)"), MatId);
+			int8 MatId = AddLatticeMaterial(MaterialSet, Options->MaterialSlots[ELatticeMaterialSlots::Border_Vertical]);
+			BorderMatOps.Add(MakeTuple(BorderVMesh, MatId));
+			UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid MatId[%i] (Border_Vertical)"), MatId);
 		}
 
-		for (const auto& MatOps : BorderMatOps) {
+		for (int32 OpIndex = 0; OpIndex < BorderMatOps.Num(); OpIndex++) {
+			const auto& MatOps = BorderMatOps[OpIndex];
 			UDynamicMesh* MatMesh = MatOps.Get<0>();
 			int8 MatId = MatOps.Get<1>();
 
-			// change the default material id, to the assigned material.
-			UGeometryScriptLibrary_MeshMaterialFunctions::RemapMaterialIDs(
-				MatMesh,
-				0,
-				MatId
-			);
-
 			FBox Bounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(MatMesh);
-			FTransform UVTransform = GetMeshUVTransform(Bounds, Options->UVScaleMode, Options->UVOriginMode, &RandomStream, Options->UVSize);
-			UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-				MatMesh,
-				MatId,
-				UVTransform,
-				2); // min island tri count
+			FBuildingRandom UVRandom = Random.Stage(EBuildingRandomStage::LatticeBorderUVs).Element(OpIndex);
+			FTransform UVTransform = UUVUtilities::GetMeshUVTransform(Bounds, Options->UVScaleMode, Options->UVOriginMode, UVRandom, Options->UVSize);
+			// change the default material id to the assigned material and project its uvs in one pass
+			TArray<FFaceClassMaterialRule> Rules;
+			Rules.Add({ EBuildingFaceClass::All, 0, MatId, true, UVTransform });
+			FaceClassMaterials::ApplyMaterials(MatMesh, Rules);
 		}
 	}
 
@@ -435,119 +568,74 @@ void LatticeGrid::ApplyLattice(UDynamicMesh* Mesh, TArray<UMaterialInterface*>&
 	// =================== Apply Global Material ======================================
 	int8 GlobalMatId = -1;
 	if (HasGlobalMaterial) {
-		GlobalMatId = MaterialSet.Num();
-		MaterialSet.Add(Options->MaterialSlots[ELatticeMaterialSlots::All]);
-		UE_LOG(LogTemp, Display, TEXT("LatticeGrid MatId[%i] (All)"), GlobalMatId);
+		GlobalMatId = AddLatticeMaterial(MaterialSet, Options->MaterialSlots[ELatticeMaterialSlots::All]);
+		UE_LOG(LogBuildingGeneration, VeryVerbose, TEXT("LatticeGrid MatId[%i] (All)"), GlobalMatId);
 	}
 	else if (Options->MaterialSlots.IsEmpty()) {
-		UE_LOG(LogTemp, Warning, TEXT("LatticeGrid MaterialSlots empty, MaterialID 0 will be applied to mesh as a default"));
+		UE_LOG(LogBuildingGeneration, Verbose, TEXT("LatticeGrid MaterialSlots empty, MaterialID 0 will be applied to mesh as a default"));
 		GlobalMatId = 0;
 	}
 
 	if (GlobalMatId != -1) {
-		// change the default material id, to the assigned material.
-		UGeometryScriptLibrary_MeshMaterialFunctions::RemapMaterialIDs(
-			CombinedMesh,
-			0,
-			GlobalMatId
-		);
-
 		FBox Bounds = UGeometryScriptLibrary_MeshQueryFunctions::GetMeshBoundingBox(CombinedMesh);
-		FTransform UVTransform = GetMeshUVTransform(Bounds, Options->UVScaleMode, Options->UVOriginMode, &RandomStream, Options->UVSize);
-		UGeometryScriptLibrary_MeshUVFunctions::SetMeshUVsFromBoxProjection(
-			CombinedMesh,
-			GlobalMatId,
-			UVTransform,  // uses GetScale3D() to determine the size of the projection, you usually want this the size of the mesh itself.
-			2); // min island tri count
+		FBuildingRandom UVRandom = Random.Stage(EBuildingRandomStage::LatticeUVs);
+		FTransform UVTransform = UUVUtilities::GetMeshUVTransform(Bounds, Options->UVScaleMode, Options->UVOriginMode, UVRandom, Options->UVSize);
+		// change the default material id to the assigned material and project its uvs in one pass
+		TArray<FFaceClassMaterialRule> Rules;
+		Rules.Add({ EBuildingFaceClass::All, 0, GlobalMatId, true, UVTransform });
+		FaceClassMaterials::ApplyMaterials(CombinedMesh, Rules);
 
 
 	}
-
-	// =================== Add Lattice to Provided Mesh ==============================
-	FTransform MeshTransform = FTransform(FaceCenter);
-	UGeometryScriptLibrary_MeshBasicEditFunctions::AppendMesh(
-		Mesh,
-		CombinedMesh,
-		MeshTransform
-	);
-
-	UE_LOG(LogTemp, Display, TEXT("Lattice - Done"));
 }
 
-LatticeGrid::~LatticeGrid()
+void LatticeGrid::FindOrBuildLattice(const FVector2D& FaceSize, TArray<UMaterialInterface*>& MaterialSet, UDynamicMesh* LatticeMesh)
 {
-}
+	const uint64 Key = FLatticeMeshCache::MakeKey(FaceSize, *Options, bFlat);
+	FLatticeMeshPtr Lattice = MeshCache->Find(Key);
+	if (Lattice.IsValid()) {
+		LatticeMesh->SetMesh(Lattice->Mesh);
+	}
+	else {
+		// built against a local material set (index 0 stays the default material) so any building can use it
+		TArray<UMaterialInterface*> LocalMaterials;
+		LocalMaterials.Add(nullptr);
+		BuildLattice(FaceSize, LocalMaterials, LatticeMesh);
+
+		FLatticeMesh Built;
+		LatticeMesh->ProcessMesh([&Built](const UE::Geometry::FDynamicMesh3& ReadMesh)
+		{
+			Built.Mesh.CompactCopy(ReadMesh);
+		});
+		Built.Materials.Append(LocalMaterials.GetData() + 1, LocalMaterials.Num() - 1);
+		Lattice = MeshCache->Add(Key, MoveTemp(Built));
+	}
 
-FTransform LatticeGrid::GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMode ScaleMode, EBuildingUVOriginMode OriginMode, FRandomStream* Randomizer, float UVSize)
-{
-	// THe scale of the UV's when applying a projection is the size of the object itself for a 0-1 fit of uv's to the object.
-	FVector MeshSize = MeshBounds.GetSize();
-	FVector UVScale;
-
-	const double X = MeshSize.X;
-	const double Y = MeshSize.Y;
-	const double Z = MeshSize.Z;
-
-	switch (ScaleMode) {
-	case EBuildingUVScaleMode::MaxExtent:
-		UVScale = FVector(MeshSize.GetMax());
-		break;
-	case EBuildingUVScaleMode::MinExtent:
-		UVScale = FVector(MeshSize.GetMin());
-		break;
-	case EBuildingUVScaleMode::MidExtent:
-		// Find the median value in (x, y, z)
-		if ((X < Y && Y < Z) || (Z < Y && Y < X)) {
-			UVScale = FVector(Y);
-		}
-		else if ((Y < X && X < Z) || (Z < X && X < Y)) {
-			UVScale = FVector(X);
+	if (Lattice->Materials.Num() == 0) {
+		return;
+	}
+
+	// local id N is the lattice's N-1th material, 0 stays the default material
+	TArray<int32> Remap;
+	Remap.Add(0);
+	for (UMaterialInterface* Material : Lattice->Materials) {
+		Remap.Add(AddLatticeMaterial(MaterialSet, Material));
+	}
+	LatticeMesh->EditMesh([&Remap](UE::Geometry::FDynamicMesh3& EditMesh)
+	{
+		UE::Geometry::FDynamicMeshMaterialAttribute* MaterialIDs = EditMesh.HasAttributes() ? EditMesh.Attributes()->GetMaterialID() : nullptr;
+		if (MaterialIDs == nullptr) {
+			return;
 		}
-		else {
-			UVScale = FVector(Z);
+		for (int32 TriangleID : EditMesh.TriangleIndicesItr()) {
+			const int32 LocalID = MaterialIDs->GetValue(TriangleID);
+			if (Remap.IsValidIndex(LocalID)) {
+				MaterialIDs->SetValue(TriangleID, Remap[LocalID]);
+			}
 		}
-		break;
-	case EBuildingUVScaleMode::AvgExtent:
-		UVScale = FVector((MeshSize.X + MeshSize.Y + MeshSize.Z) / 3.f);
-		break;
-	case EBuildingUVScaleMode::XExtent:
-		UVScale = FVector(MeshSize.X);
-		break;
-	case EBuildingUVScaleMode::YExtent:
-		UVScale = FVector(MeshSize.Y);
-		break;
-	case EBuildingUVScaleMode::ZExtent:
-		UVScale = FVector(MeshSize.Z);
-		break;
-	case EBuildingUVScaleMode::Fixed:
-		UVScale = FVector(UVSize);
-		break;
-	}
-
-	FVector UVOrigin = FVector::Zero();
-
-	if (Randomizer == nullptr) {
-		TUniquePtr<FRandomStream> Randomizer = MakeUnique<FRandomStream>();
-	}
-
-	switch (OriginMode) {
-	case EBuildingUVOriginMode::MaxCoordinate:
-		UVOrigin = MeshBounds.Max;
-		break;
-	case EBuildingUVOriginMode::MinCoordinate:
-		UVOrigin = MeshBounds.Min;
-		break;
-	case EBuildingUVOriginMode::Random:
-		// Set the origin to be a random spot on the mesh
-		UVOrigin = FVector(
-			Randomizer->RandRange(MeshBounds.Min.X, MeshBounds.Max.X),
-			Randomizer->RandRange(MeshBounds.Min.Y, MeshBounds.Max.Y),
-			Randomizer->RandRange(MeshBounds.Min.Z, MeshBounds.Max.Z)
-		);
-		break;
-	}
+	});
+}
 
-	FTransform UVTransform(UVOrigin);
-	UVTransform.SetScale3D(UVScale);
-	return UVTransform;
+LatticeGrid::~LatticeGrid()
+{
 }
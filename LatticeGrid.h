@@ -5,8 +5,12 @@
 #include "CoreMinimal.h"
 #include "UDynamicMesh.h"
 #include "BuildingEnums.h"
+#include "BuildingInstances.h"
 #include "LatticeGrid.generated.h"
 
+class FBuildingMeshPool;
+class FLatticeMeshCache;
+
 UENUM(BlueprintType)
 enum class ELatticeMaterialSlots : uint8
 {
@@ -74,23 +78,88 @@ struct PROCEDURALBUILDINGS_API FLatticeGridOptions
 };
 
 /**
- * 
+ * The face of a mesh a lattice is placed on.
+ * The lattice is centered on `Origin`, its rows run across `Extent.X` and its columns up `Extent.Y` along `Up`,
+ * and the bars stick out of the face along `Normal`.
+ */
+struct PROCEDURALBUILDINGS_API FLatticeFaceFrame
+{
+	FVector Origin = FVector::Zero();
+	FVector Normal = FVector::BackwardVector;
+	FVector Up = FVector::UpVector;
+	FVector2D Extent = FVector2D::Zero(); // X=width, Y=height
+
+	// The face of an axis aligned box facing `Normal`, `Up` is Z for the sides and X for the top and bottom.
+	static FLatticeFaceFrame FromBox(const FBox& Box, const FVector& Normal);
+
+	// Transform from lattice space (face at X=0, bars towards -X, rows along Y, columns along Z) into the frame
+	FTransform GetTransform() const;
+};
+
+/**
+ * Builds rows and columns of framing (and an optional border) on the faces of a mesh.
+ *
+ * HOWTO:
+ *	LatticeGrid Lattice = LatticeGrid(&Options);
+ *	TArray<FLatticeFaceFrame> Faces = { FLatticeFaceFrame::FromBox(Bounds, FVector::ForwardVector), FLatticeFaceFrame::FromBox(Bounds, FVector::RightVector) };
+ *	Lattice.ApplyLattice(Mesh, Faces, MaterialSet);
+ *	Lattice.AddLatticeInstances(Faces, Instances); // or as instances of a unit cube
  */
 class PROCEDURALBUILDINGS_API LatticeGrid
 {
 public:
 	static const int32 RANDOM_OFFSET = 972959;
 	static const int32 MAX_LATTICES = 100;
+	// distance the quads of a flat lattice sit in front of the face
+	static constexpr float FLAT_OFFSET = 1.f;
 
 	LatticeGrid();
 	LatticeGrid(FLatticeGridOptions* Options);
+	// Apply the lattice to the -X face of the mesh bounds
 	void ApplyLattice(UDynamicMesh* Mesh, TArray<UMaterialInterface*>& MaterialSet);
+
+	// Apply the lattice to each face in a single pass. The lattice is built once per face size and appended to every 
+	// face of that size, the mesh itself is never transformed.
+	void ApplyLattice(UDynamicMesh* Mesh, const TArray<FLatticeFaceFrame>& Faces, TArray<UMaterialInterface*>& MaterialSet);
+
+	// Add an instance for every bar and border piece of each face instead of building the geometry, the layout is the
+	// same as ApplyLattice.
+	void AddLatticeInstances(const TArray<FLatticeFaceFrame>& Faces, FBuildingInstances& Instances);
+
+	// Build every bar as a single quad on the front of the bar instead of a box, the pattern is the same without
+	// any depth. Used by the coarser LODs.
+	void SetFlat(bool bInFlat);
+
+	// Take the scratch meshes the lattices are built in from `MeshPool` instead of allocating them, nullptr allocates
+	void SetMeshPool(FBuildingMeshPool* InMeshPool);
+
+	// Look lattices up in `InMeshCache` (eg. FLatticeMeshCache::Get()) and add the ones that are built, nullptr (the
+	// default) always builds them
+	void SetMeshCache(FLatticeMeshCache* InMeshCache);
 	~LatticeGrid();
 
 private:
 	FLatticeGridOptions* Options;
-
-	// TODO move to static utility function
-	FTransform GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMode ScaleMode, EBuildingUVOriginMode OriginMode, FRandomStream* Randomizer = nullptr, float UVSize = 0.f);
-
+	bool bFlat = false;
+	FBuildingMeshPool* MeshPool = nullptr;
+	FLatticeMeshCache* MeshCache = nullptr;
+
+	// The boxes of a lattice in lattice space
+	struct FLatticeLayout
+	{
+		TArray<FBox> Rows;
+		TArray<FBox> Columns;
+		TArray<FBox> BorderH;
+		TArray<FBox> BorderV;
+	};
+
+	// Lay out the rows, columns and border of a face of the given size
+	void LayoutLattice(const FVector2D& FaceSize, FLatticeLayout& Layout) const;
+
+	// Build the lattice for a face of the given size in lattice space into `LatticeMesh`
+	void BuildLattice(const FVector2D& FaceSize, TArray<UMaterialInterface*>& MaterialSet, UDynamicMesh* LatticeMesh);
+
+	// Copy the lattice for a face of the given size out of `MeshCache` into `LatticeMesh`, building and caching it if
+	// it isn't there, and remap its materials into `MaterialSet`
+	void FindOrBuildLattice(const FVector2D& FaceSize, TArray<UMaterialInterface*>& MaterialSet, UDynamicMesh* LatticeMesh);
 };
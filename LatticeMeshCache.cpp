@@ -0,0 +1,152 @@
+#include "LatticeMeshCache.h"
+#include "LatticeGrid.h"
+#include "PanelMeshCache.h"
+#include "BuildingStats.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/IConsoleManager.h"
+#include "Hash/CityHash.h"
+
+static TAutoConsoleVariable<int32> CVarLatticeCacheBudgetMB(
+	TEXT("Building.LatticeCache.BudgetMB"),
+	32,
+	TEXT("Memory budget of the shared lattice mesh cache in MB, least recently used lattices are evicted above it. 0 disables the cache."),
+	ECVF_Default);
+
+static FAutoConsoleCommand LatticeCacheStatsCommand(
+	TEXT("Building.LatticeCache.Stats"),
+	TEXT("Log hit/miss counters and memory use of the shared lattice mesh cache"),
+	FConsoleCommandDelegate::CreateLambda([]() { FLatticeMeshCache::Get().LogStats(); }));
+
+static FAutoConsoleCommand LatticeCacheClearCommand(
+	TEXT("Building.LatticeCache.Clear"),
+	TEXT("Empty the shared lattice mesh cache and reset its counters"),
+	FConsoleCommandDelegate::CreateLambda([]() { FLatticeMeshCache::Get().Empty(); FLatticeMeshCache::Get().ResetStats(); }));
+
+FLatticeMeshCache& FLatticeMeshCache::Get()
+{
+	static FLatticeMeshCache Instance;
+	return Instance;
+}
+
+uint64 FLatticeMeshCache::MakeKey(const FVector2D& FaceSize, const FLatticeGridOptions& Options, bool bFlat)
+{
+	// The text export covers every option (including the seed and material slots) without a hand written hash.
+	FString OptionsText;
+	FLatticeGridOptions::StaticStruct()->ExportText(OptionsText, &Options, nullptr, nullptr, PPF_None, nullptr);
+	const uint64 OptionsHash = CityHash64(reinterpret_cast<const char*>(*OptionsText), OptionsText.Len() * sizeof(TCHAR));
+
+	struct FLatticeKeyData
+	{
+		double SizeX;
+		double SizeY;
+		int32 bFlat;
+	};
+
+	FLatticeKeyData KeyData;
+	FMemory::Memzero(KeyData);
+	KeyData.SizeX = FaceSize.X;
+	KeyData.SizeY = FaceSize.Y;
+	KeyData.bFlat = bFlat ? 1 : 0;
+
+	return CityHash64WithSeed(reinterpret_cast<const char*>(&KeyData), sizeof(KeyData), OptionsHash);
+}
+
+FLatticeMeshPtr FLatticeMeshCache::Find(uint64 Key)
+{
+	FScopeLock ScopeLock(&Lock);
+	FEntry* Entry = Entries.Find(Key);
+	if (Entry == nullptr) {
+		NumMisses++;
+		return nullptr;
+	}
+
+	NumHits++;
+	INC_DWORD_STAT(STAT_BuildingLatticeCacheHits);
+	Entry->LastUsed = ++UseCounter;
+	return Entry->Lattice;
+}
+
+FLatticeMeshPtr FLatticeMeshCache::Add(uint64 Key, FLatticeMesh&& Lattice)
+{
+	const int64 BudgetBytes = GetBudgetBytes();
+	const int64 LatticeBytes = FPanelMeshCache::EstimateMeshBytes(Lattice.Mesh);
+	FLatticeMeshPtr Shared = MakeShared<const FLatticeMesh, ESPMode::ThreadSafe>(MoveTemp(Lattice));
+	if (LatticeBytes > BudgetBytes) {
+		return Shared; // cache disabled, or a single lattice larger than the whole budget
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	if (FEntry* Existing = Entries.Find(Key)) {
+		// another thread built the same lattice at the same time
+		Existing->LastUsed = ++UseCounter;
+		return Existing->Lattice;
+	}
+
+	FEntry& Entry = Entries.Add(Key);
+	Entry.Lattice = Shared;
+	Entry.Bytes = LatticeBytes;
+	Entry.LastUsed = ++UseCounter;
+	UsedBytes += LatticeBytes;
+
+	EvictToBudget(BudgetBytes);
+	return Shared;
+}
+
+void FLatticeMeshCache::EvictToBudget(int64 BudgetBytes)
+{
+	while (UsedBytes > BudgetBytes && Entries.Num() > 0) {
+		uint64 OldestKey = 0;
+		uint64 OldestUse = MAX_uint64;
+		for (const auto& Pair : Entries) {
+			if (Pair.Value.LastUsed < OldestUse) {
+				OldestUse = Pair.Value.LastUsed;
+				OldestKey = Pair.Key;
+			}
+		}
+
+		UsedBytes -= Entries[OldestKey].Bytes;
+		Entries.Remove(OldestKey);
+		NumEvictions++;
+	}
+}
+
+void FLatticeMeshCache::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+	Entries.Empty();
+	UsedBytes = 0;
+}
+
+void FLatticeMeshCache::ResetStats()
+{
+	FScopeLock ScopeLock(&Lock);
+	NumHits = 0;
+	NumMisses = 0;
+	NumEvictions = 0;
+}
+
+int64 FLatticeMeshCache::GetBudgetBytes() const
+{
+	return (int64)FMath::Max(CVarLatticeCacheBudgetMB.GetValueOnAnyThread(), 0) * 1024 * 1024;
+}
+
+int64 FLatticeMeshCache::GetUsedBytes() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return UsedBytes;
+}
+
+int32 FLatticeMeshCache::Num() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries.Num();
+}
+
+void FLatticeMeshCache::LogStats() const
+{
+	FScopeLock ScopeLock(&Lock);
+	const int64 Lookups = NumHits + NumMisses;
+	const double HitRate = Lookups > 0 ? (100.0 * NumHits) / Lookups : 0.0;
+	UE_LOG(LogBuildingGeneration, Display, TEXT("LatticeMeshCache - Lattices: %i, Used: %.2f MB / %.2f MB, Hits: %lld, Misses: %lld (%.1f%% hit rate), Evictions: %lld"),
+		Entries.Num(), UsedBytes / (1024.0 * 1024.0), GetBudgetBytes() / (1024.0 * 1024.0), NumHits, NumMisses, HitRate, NumEvictions);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "HAL/CriticalSection.h"
+
+struct FLatticeGridOptions;
+class UMaterialInterface;
+
+// A finished lattice in lattice space. Material ID 0 is the default material, local ID N (N > 0) is Materials[N - 1].
+struct PROCEDURALBUILDINGS_API FLatticeMesh
+{
+	UE::Geometry::FDynamicMesh3 Mesh;
+	TArray<UMaterialInterface*> Materials;
+};
+
+typedef TSharedPtr<const FLatticeMesh, ESPMode::ThreadSafe> FLatticeMeshPtr;
+
+/**
+ * Process wide cache of finished lattices (rows, columns and border with their materials and uvs).
+ *
+ * A lattice only depends on the face size, its FLatticeGridOptions (the framing seed is an option, not the building
+ * seed) and whether it is flat, so every box with the same framing and face size shares one lattice, across
+ * buildings too. The cache has a memory budget (`Building.LatticeCache.BudgetMB`) like FPanelMeshCache. Thread safe.
+ *
+ * HOWTO:
+ *	LatticeGrid Lattice = LatticeGrid(&Options);
+ *	Lattice.SetMeshCache(&FLatticeMeshCache::Get());
+ */
+class PROCEDURALBUILDINGS_API FLatticeMeshCache
+{
+public:
+	static FLatticeMeshCache& Get();
+
+	// Stable hash of everything a lattice's geometry depends on
+	static uint64 MakeKey(const FVector2D& FaceSize, const FLatticeGridOptions& Options, bool bFlat);
+
+	// Returns the cached lattice for `Key` or nullptr, a hit marks the lattice as most recently used
+	FLatticeMeshPtr Find(uint64 Key);
+
+	// Takes the lattice and returns the cached one, the lattice is still returned (uncached) if it is over budget
+	FLatticeMeshPtr Add(uint64 Key, FLatticeMesh&& Lattice);
+
+	void Empty();
+	void ResetStats();
+
+	int64 GetBudgetBytes() const;
+	int64 GetUsedBytes() const;
+	int32 Num() const;
+	int64 GetNumHits() const { return NumHits; }
+	int64 GetNumMisses() const { return NumMisses; }
+
+	// Write the hit/miss counters and memory use to the log
+	void LogStats() const;
+
+private:
+	struct FEntry
+	{
+		FLatticeMeshPtr Lattice;
+		int64 Bytes = 0;
+		uint64 LastUsed = 0;
+	};
+
+	mutable FCriticalSection Lock;
+	TMap<uint64, FEntry> Entries;
+	int64 UsedBytes = 0;
+	uint64 UseCounter = 0;
+
+	int64 NumHits = 0;
+	int64 NumMisses = 0;
+	int64 NumEvictions = 0;
+
+	// Lock must be held
+	void EvictToBudget(int64 BudgetBytes);
+};
@@ -0,0 +1,194 @@
+#include "PanelMeshCache.h"
+#include "BuildingStats.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/IConsoleManager.h"
+#include "Hash/CityHash.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+
+static TAutoConsoleVariable<int32> CVarPanelCacheBudgetMB(
+	TEXT("Building.PanelCache.BudgetMB"),
+	64,
+	TEXT("Memory budget of the shared panel mesh cache in MB, least recently used panels are evicted above it. 0 disables the cache."),
+	ECVF_Default);
+
+static FAutoConsoleCommand PanelCacheStatsCommand(
+	TEXT("Building.PanelCache.Stats"),
+	TEXT("Log hit/miss counters and memory use of the shared panel mesh cache"),
+	FConsoleCommandDelegate::CreateLambda([]() { FPanelMeshCache::Get().LogStats(); }));
+
+static FAutoConsoleCommand PanelCacheClearCommand(
+	TEXT("Building.PanelCache.Clear"),
+	TEXT("Empty the shared panel mesh cache and reset its counters"),
+	FConsoleCommandDelegate::CreateLambda([]() { FPanelMeshCache::Get().Empty(); FPanelMeshCache::Get().ResetStats(); }));
+
+FPanelMeshCache& FPanelMeshCache::Get()
+{
+	static FPanelMeshCache Instance;
+	return Instance;
+}
+
+uint64 FPanelMeshCache::MakeKey(const FVector& PanelSize, const FBooleanGridOptions& Options, EGeometryScriptBooleanOperation BoolMode)
+{
+	// The text export covers every option (including the seed) without a hand written hash to keep in sync.
+	FString OptionsText;
+	FBooleanGridOptions::StaticStruct()->ExportText(OptionsText, &Options, nullptr, nullptr, PPF_None, nullptr);
+	const uint64 OptionsHash = CityHash64(reinterpret_cast<const char*>(*OptionsText), OptionsText.Len() * sizeof(TCHAR));
+
+	struct FPanelKeyData
+	{
+		double SizeX;
+		double SizeY;
+		double SizeZ;
+		int32 BoolMode;
+	};
+
+	FPanelKeyData KeyData;
+	FMemory::Memzero(KeyData);
+	KeyData.SizeX = PanelSize.X;
+	KeyData.SizeY = PanelSize.Y;
+	KeyData.SizeZ = PanelSize.Z;
+	KeyData.BoolMode = static_cast<int32>(BoolMode);
+
+	return CityHash64WithSeed(reinterpret_cast<const char*>(&KeyData), sizeof(KeyData), OptionsHash);
+}
+
+int64 FPanelMeshCache::EstimateMeshBytes(const UE::Geometry::FDynamicMesh3& Mesh)
+{
+	using namespace UE::Geometry;
+
+	// vertex: position, ref count and roughly 6 edge references
+	int64 Bytes = (int64)Mesh.MaxVertexID() * (sizeof(FVector3d) + sizeof(int16) + 6 * sizeof(int32));
+	// triangle: vertex indices, edge indices, ref count
+	Bytes += (int64)Mesh.MaxTriangleID() * (sizeof(FIndex3i) * 2 + sizeof(int16));
+	// edge: vertices and triangles
+	Bytes += (int64)Mesh.MaxEdgeID() * (sizeof(FIndex2i) * 2);
+
+	if (Mesh.HasTriangleGroups()) {
+		Bytes += (int64)Mesh.MaxTriangleID() * sizeof(int32);
+	}
+
+	if (const FDynamicMeshAttributeSet* Attributes = Mesh.Attributes()) {
+		for (int32 LayerIndex = 0; LayerIndex < Attributes->NumUVLayers(); LayerIndex++) {
+			const FDynamicMeshUVOverlay* UVLayer = Attributes->GetUVLayer(LayerIndex);
+			Bytes += (int64)UVLayer->MaxElementID() * (sizeof(FVector2f) + sizeof(int32) * 2);
+			Bytes += (int64)Mesh.MaxTriangleID() * sizeof(FIndex3i);
+		}
+		if (const FDynamicMeshNormalOverlay* Normals = Attributes->PrimaryNormals()) {
+			Bytes += (int64)Normals->MaxElementID() * (sizeof(FVector3f) + sizeof(int32) * 2);
+			Bytes += (int64)Mesh.MaxTriangleID() * sizeof(FIndex3i);
+		}
+		if (Attributes->HasMaterialID()) {
+			Bytes += (int64)Mesh.MaxTriangleID() * sizeof(int32);
+		}
+	}
+
+	return Bytes;
+}
+
+FPanelMeshPtr FPanelMeshCache::Find(uint64 Key)
+{
+	FScopeLock ScopeLock(&Lock);
+	FEntry* Entry = Entries.Find(Key);
+	if (Entry == nullptr) {
+		NumMisses++;
+		return nullptr;
+	}
+
+	NumHits++;
+	INC_DWORD_STAT(STAT_BuildingPanelCacheHits);
+	Entry->LastUsed = ++UseCounter;
+	return Entry->Mesh;
+}
+
+void FPanelMeshCache::Add(uint64 Key, const UE::Geometry::FDynamicMesh3& Mesh)
+{
+	const int64 BudgetBytes = GetBudgetBytes();
+	if (BudgetBytes <= 0) {
+		return; // cache disabled
+	}
+
+	// copy outside the lock, panels can be large. Panels are built in pool meshes, which keep the ids of the larger
+	// meshes they held before, only the live elements are copied.
+	TSharedRef<UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe> Compacted = MakeShared<UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe>();
+	Compacted->CompactCopy(Mesh);
+	const int64 MeshBytes = EstimateMeshBytes(*Compacted);
+	if (MeshBytes > BudgetBytes) {
+		return; // a single panel larger than the whole budget
+	}
+	FPanelMeshPtr MeshCopy = Compacted;
+
+	FScopeLock ScopeLock(&Lock);
+	if (FEntry* Existing = Entries.Find(Key)) {
+		// another thread built the same panel at the same time
+		Existing->LastUsed = ++UseCounter;
+		return;
+	}
+
+	FEntry& Entry = Entries.Add(Key);
+	Entry.Mesh = MeshCopy;
+	Entry.Bytes = MeshBytes;
+	Entry.LastUsed = ++UseCounter;
+	UsedBytes += MeshBytes;
+
+	EvictToBudget(BudgetBytes);
+}
+
+void FPanelMeshCache::EvictToBudget(int64 BudgetBytes)
+{
+	while (UsedBytes > BudgetBytes && Entries.Num() > 0) {
+		// find the least recently used panel, eviction is rare compared to lookups so a scan is fine.
+		uint64 OldestKey = 0;
+		uint64 OldestUse = MAX_uint64;
+		for (const auto& Pair : Entries) {
+			if (Pair.Value.LastUsed < OldestUse) {
+				OldestUse = Pair.Value.LastUsed;
+				OldestKey = Pair.Key;
+			}
+		}
+
+		UsedBytes -= Entries[OldestKey].Bytes;
+		Entries.Remove(OldestKey);
+		NumEvictions++;
+	}
+}
+
+void FPanelMeshCache::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+	Entries.Empty();
+	UsedBytes = 0;
+}
+
+void FPanelMeshCache::ResetStats()
+{
+	FScopeLock ScopeLock(&Lock);
+	NumHits = 0;
+	NumMisses = 0;
+	NumEvictions = 0;
+}
+
+int64 FPanelMeshCache::GetBudgetBytes() const
+{
+	return (int64)FMath::Max(CVarPanelCacheBudgetMB.GetValueOnAnyThread(), 0) * 1024 * 1024;
+}
+
+int64 FPanelMeshCache::GetUsedBytes() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return UsedBytes;
+}
+
+int32 FPanelMeshCache::Num() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries.Num();
+}
+
+void FPanelMeshCache::LogStats() const
+{
+	FScopeLock ScopeLock(&Lock);
+	const int64 Lookups = NumHits + NumMisses;
+	const double HitRate = Lookups > 0 ? (100.0 * NumHits) / Lookups : 0.0;
+	UE_LOG(LogBuildingGeneration, Display, TEXT("PanelMeshCache - Panels: %i, Used: %.2f MB / %.2f MB, Hits: %lld, Misses: %lld (%.1f%% hit rate), Evictions: %lld"),
+		Entries.Num(), UsedBytes / (1024.0 * 1024.0), GetBudgetBytes() / (1024.0 * 1024.0), NumHits, NumMisses, HitRate, NumEvictions);
+}
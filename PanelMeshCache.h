@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "HAL/CriticalSection.h"
+#include "GeometryScript/MeshBooleanFunctions.h"
+#include "BooleanGrid.h"
+
+typedef TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe> FPanelMeshPtr;
+
+/**
+ * Process wide cache of finished side panels (slab + window booleans) in panel space.
+ *
+ * A panel's geometry depends only on its size, its FBooleanGridOptions (which includes the window seed) and the
+ * boolean mode, so panels with the same inputs can be shared between boxes and between buildings. With uniform 
+ * windows most panels of a district are duplicates.
+ *
+ * The cache has a memory budget (`Building.PanelCache.BudgetMB`), the least recently used panels are evicted 
+ * once it's exceeded. Thread safe.
+ *
+ * HOWTO:
+ *	uint64 Key = FPanelMeshCache::MakeKey(PanelSize, BoolOptions, BoolMode);
+ *	if (FPanelMeshPtr Cached = FPanelMeshCache::Get().Find(Key)) { ... append *Cached ... }
+ *	else { ... build panel ... FPanelMeshCache::Get().Add(Key, PanelMesh); }
+ */
+class PROCEDURALBUILDINGS_API FPanelMeshCache
+{
+public:
+	static FPanelMeshCache& Get();
+
+	// Stable hash of everything a panel's geometry depends on
+	static uint64 MakeKey(const FVector& PanelSize, const FBooleanGridOptions& Options, EGeometryScriptBooleanOperation BoolMode);
+
+	// Approximate resident size of a mesh, its vertex/triangle/edge storage plus attribute overlays
+	static int64 EstimateMeshBytes(const UE::Geometry::FDynamicMesh3& Mesh);
+
+	// Returns the cached panel for `Key` or nullptr, a hit marks the panel as most recently used
+	FPanelMeshPtr Find(uint64 Key);
+
+	// Copies the mesh into the cache, evicting least recently used panels if the budget is exceeded
+	void Add(uint64 Key, const UE::Geometry::FDynamicMesh3& Mesh);
+
+	void Empty();
+	void ResetStats();
+
+	int64 GetBudgetBytes() const;
+	int64 GetUsedBytes() const;
+	int32 Num() const;
+	int64 GetNumHits() const { return NumHits; }
+	int64 GetNumMisses() const { return NumMisses; }
+	int64 GetNumEvictions() const { return NumEvictions; }
+
+	// Write the hit/miss counters and memory use to the log
+	void LogStats() const;
+
+private:
+	struct FEntry
+	{
+		FPanelMeshPtr Mesh;
+		int64 Bytes = 0;
+		uint64 LastUsed = 0;
+	};
+
+	mutable FCriticalSection Lock;
+	TMap<uint64, FEntry> Entries;
+	int64 UsedBytes = 0;
+	uint64 UseCounter = 0;
+
+	int64 NumHits = 0;
+	int64 NumMisses = 0;
+	int64 NumEvictions = 0;
+
+	// Lock must be held
+	void EvictToBudget(int64 BudgetBytes);
+};
@@ -3,8 +3,11 @@
 
 #include "UVUtilities.h"
 #include "BuildingEnums.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
 
-FTransform UUVUtilities::GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMode ScaleMode, EBuildingUVOriginMode OriginMode, FRandomStream* Randomizer, float UVSize)
+using namespace UE::Geometry;
+
+FTransform UUVUtilities::GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMode ScaleMode, EBuildingUVOriginMode OriginMode, const FBuildingRandom& Random, float UVSize)
 {
 	// THe scale of the UV's when applying a projection is the size of the object itself for a 0-1 fit of uv's to the object.
 	FVector MeshSize = MeshBounds.GetSize();
@@ -52,10 +55,6 @@ FTransform UUVUtilities::GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMo
 
 	FVector UVOrigin = FVector::Zero();
 
-	if (Randomizer == nullptr) {
-		TUniquePtr<FRandomStream> Randomizer = MakeUnique<FRandomStream>();
-	}
-
 	switch (OriginMode) {
 	case EBuildingUVOriginMode::MaxCoordinate:
 		UVOrigin = MeshBounds.Max;
@@ -66,9 +65,9 @@ FTransform UUVUtilities::GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMo
 	case EBuildingUVOriginMode::Random:
 		// Set the origin to be a random spot on the mesh
 		UVOrigin = FVector(
-			Randomizer->RandRange(MeshBounds.Min.X, MeshBounds.Max.X),
-			Randomizer->RandRange(MeshBounds.Min.Y, MeshBounds.Max.Y),
-			Randomizer->RandRange(MeshBounds.Min.Z, MeshBounds.Max.Z)
+			Random.FRandRange(MeshBounds.Min.X, MeshBounds.Max.X, 0),
+			Random.FRandRange(MeshBounds.Min.Y, MeshBounds.Max.Y, 1),
+			Random.FRandRange(MeshBounds.Min.Z, MeshBounds.Max.Z, 2)
 		);
 		break;
 	}
@@ -77,3 +76,189 @@ FTransform UUVUtilities::GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMo
 	UVTransform.SetScale3D(UVScale);
 	return UVTransform;
 }
+
+void UUVUtilities::SetMeshUVsFromBoxProjections(UDynamicMesh* Mesh, const TArray<FUVBoxProjection>& Projections)
+{
+	if (Mesh == nullptr || Projections.IsEmpty()) {
+		return;
+	}
+	Mesh->EditMesh([&](FDynamicMesh3& EditMesh)
+	{
+		SetMeshUVsFromBoxProjections(EditMesh, Projections);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
+}
+
+void UUVUtilities::SetMeshUVsFromBoxProjections(FDynamicMesh3& Mesh, const TArray<FUVBoxProjection>& Projections)
+{
+	if (Projections.IsEmpty() || !Mesh.HasAttributes() || !Mesh.Attributes()->HasMaterialID()) {
+		return;
+	}
+
+	// material id -> projection, the last projection listed for an id wins
+	TMap<int32, int32> SlotByMaterial;
+	TArray<FTransform> SlotTransforms;
+	for (int32 Slot = 0; Slot < Projections.Num(); Slot++) {
+		SlotByMaterial.Add(Projections[Slot].MaterialID, Slot);
+		SlotTransforms.Add(Projections[Slot].Transform);
+	}
+
+	const FDynamicMeshMaterialAttribute* MaterialIDs = Mesh.Attributes()->GetMaterialID();
+	TArray<int32> TriangleSlots;
+	TriangleSlots.Init(INDEX_NONE, Mesh.MaxTriangleID());
+	for (int32 TriangleID : Mesh.TriangleIndicesItr()) {
+		if (const int32* Slot = SlotByMaterial.Find(MaterialIDs->GetValue(TriangleID))) {
+			TriangleSlots[TriangleID] = *Slot;
+		}
+	}
+	ProjectBoxUVs(Mesh, TriangleSlots, SlotTransforms);
+}
+
+void UUVUtilities::ProjectBoxUVs(FDynamicMesh3& Mesh, const TArray<int32>& TriangleSlots, const TArray<FTransform>& SlotTransforms)
+{
+	const int32 NumSlots = SlotTransforms.Num();
+	if (NumSlots == 0) {
+		return;
+	}
+	if (!Mesh.HasAttributes()) {
+		Mesh.EnableAttributes();
+	}
+	FDynamicMeshUVOverlay* UVs = Mesh.Attributes()->PrimaryUV();
+
+	// ================ PROJECTION MAPS ===================
+	// Every slot has 6 box faces (+X, -X, +Y, -Y, +Z, -Z). A face projects onto the two other axes of the box, the u axis
+	// is flipped on the negative faces so textures read the same way on opposite sides.
+	static const int32 FaceUAxis[6] = { 1, 1, 0, 0, 0, 0 };
+	static const float FaceUSign[6] = { 1.f, -1.f, -1.f, 1.f, 1.f, -1.f };
+	static const int32 FaceVAxis[6] = { 2, 2, 2, 2, 1, 1 };
+	static const float FaceVSign[6] = { 1.f, 1.f, 1.f, 1.f, 1.f, -1.f };
+
+	const int32 NumSlotFaces = NumSlots * 6;
+	TArray<FVector3d> SlotOrigins;
+	TArray<FVector3d> SlotAxes; // 3 per slot
+	TArray<FVector3f> UMaps;    // per slot face, u = Dot(UMap, P - Origin)
+	TArray<FVector3f> VMaps;
+	SlotOrigins.SetNum(NumSlots);
+	SlotAxes.SetNum(NumSlots * 3);
+	UMaps.SetNum(NumSlotFaces);
+	VMaps.SetNum(NumSlotFaces);
+	for (int32 Slot = 0; Slot < NumSlots; Slot++) {
+		const FTransform& Transform = SlotTransforms[Slot];
+		const FVector3d Dimensions = FVector3d(Transform.GetScale3D()).ComponentMax(FVector3d(KINDA_SMALL_NUMBER));
+		SlotOrigins[Slot] = FVector3d(Transform.GetLocation());
+		for (int32 Axis = 0; Axis < 3; Axis++) {
+			FVector3d Unit = FVector3d::Zero();
+			Unit[Axis] = 1.0;
+			SlotAxes[Slot * 3 + Axis] = FVector3d(Transform.GetRotation().RotateVector(Unit));
+		}
+		for (int32 Face = 0; Face < 6; Face++) {
+			const int32 UAxis = FaceUAxis[Face];
+			const int32 VAxis = FaceVAxis[Face];
+			UMaps[Slot * 6 + Face] = FVector3f(SlotAxes[Slot * 3 + UAxis] * (FaceUSign[Face] / Dimensions[UAxis]));
+			VMaps[Slot * 6 + Face] = FVector3f(SlotAxes[Slot * 3 + VAxis] * (FaceVSign[Face] / Dimensions[VAxis]));
+		}
+	}
+
+	// ================ GATHER ===================
+	// Each triangle picks the box face its normal points at most. Corners that share a vertex and a slot face share a
+	// uv element, so islands stay connected across the triangles of a face.
+	TArray<int32> CornerElements;   // 3 per projected triangle
+	TArray<int32> ProjectedTriangles;
+	TArray<int32> ElementVertex;
+	TArray<int32> ElementSlotFace;
+	TArray<int32> SlotFaceCounts;
+	SlotFaceCounts.SetNumZeroed(NumSlotFaces);
+	TMap<uint64, int32> ElementByKey;
+	for (int32 TriangleID : Mesh.TriangleIndicesItr()) {
+		const int32 Slot = TriangleSlots.IsValidIndex(TriangleID) ? TriangleSlots[TriangleID] : INDEX_NONE;
+		if (Slot == INDEX_NONE) {
+			continue;
+		}
+		const FVector3d Normal = Mesh.GetTriNormal(TriangleID);
+		int32 Face = 0;
+		double BestDot = -1.0;
+		for (int32 Axis = 0; Axis < 3; Axis++) {
+			const double Dot = Normal.Dot(SlotAxes[Slot * 3 + Axis]);
+			if (FMath::Abs(Dot) > BestDot) {
+				BestDot = FMath::Abs(Dot);
+				Face = Axis * 2 + (Dot < 0.0 ? 1 : 0);
+			}
+		}
+		const int32 SlotFace = Slot * 6 + Face;
+
+		const FIndex3i Triangle = Mesh.GetTriangle(TriangleID);
+		ProjectedTriangles.Add(TriangleID);
+		for (int32 Corner = 0; Corner < 3; Corner++) {
+			const uint64 Key = (static_cast<uint64>(Triangle[Corner]) << 32) | static_cast<uint32>(SlotFace);
+			int32* Existing = ElementByKey.Find(Key);
+			if (Existing == nullptr) {
+				const int32 Element = ElementVertex.Add(Triangle[Corner]);
+				ElementSlotFace.Add(SlotFace);
+				SlotFaceCounts[SlotFace]++;
+				Existing = &ElementByKey.Add(Key, Element);
+			}
+			CornerElements.Add(*Existing);
+		}
+	}
+	const int32 NumElements = ElementVertex.Num();
+	if (NumElements == 0) {
+		return;
+	}
+
+	// ================ STRUCTURE OF ARRAYS ===================
+	// counting sort by slot face, every run of the buffers is projected with the same map
+	TArray<int32> RunStarts;
+	RunStarts.SetNumUninitialized(NumSlotFaces + 1);
+	RunStarts[0] = 0;
+	for (int32 SlotFace = 0; SlotFace < NumSlotFaces; SlotFace++) {
+		RunStarts[SlotFace + 1] = RunStarts[SlotFace] + SlotFaceCounts[SlotFace];
+	}
+	TArray<int32> RunNext = RunStarts;
+
+	// positions are stored relative to the projection origin, so single precision is plenty
+	TArray<float> PX, PY, PZ, U, V;
+	TArray<int32> ElementOrder;
+	PX.SetNumUninitialized(NumElements);
+	PY.SetNumUninitialized(NumElements);
+	PZ.SetNumUninitialized(NumElements);
+	U.SetNumUninitialized(NumElements);
+	V.SetNumUninitialized(NumElements);
+	ElementOrder.SetNumUninitialized(NumElements);
+	for (int32 Element = 0; Element < NumElements; Element++) {
+		const int32 SlotFace = ElementSlotFace[Element];
+		const int32 Index = RunNext[SlotFace]++;
+		const FVector3d Position = Mesh.GetVertex(ElementVertex[Element]) - SlotOrigins[SlotFace / 6];
+		PX[Index] = static_cast<float>(Position.X);
+		PY[Index] = static_cast<float>(Position.Y);
+		PZ[Index] = static_cast<float>(Position.Z);
+		ElementOrder[Element] = Index;
+	}
+
+	// ================ PROJECT ===================
+	for (int32 SlotFace = 0; SlotFace < NumSlotFaces; SlotFace++) {
+		const FVector3f UMap = UMaps[SlotFace];
+		const FVector3f VMap = VMaps[SlotFace];
+		const float* RESTRICT X = PX.GetData();
+		const float* RESTRICT Y = PY.GetData();
+		const float* RESTRICT Z = PZ.GetData();
+		float* RESTRICT OutU = U.GetData();
+		float* RESTRICT OutV = V.GetData();
+		for (int32 Index = RunStarts[SlotFace]; Index < RunStarts[SlotFace + 1]; Index++) {
+			OutU[Index] = UMap.X * X[Index] + UMap.Y * Y[Index] + UMap.Z * Z[Index];
+			OutV[Index] = VMap.X * X[Index] + VMap.Y * Y[Index] + VMap.Z * Z[Index];
+		}
+	}
+
+	// ================ WRITE ===================
+	TArray<int32> ElementIDs;
+	ElementIDs.SetNumUninitialized(NumElements);
+	for (int32 Index = 0; Index < NumElements; Index++) {
+		ElementIDs[Index] = UVs->AppendElement(FVector2f(U[Index], V[Index]));
+	}
+	for (int32 TriangleIndex = 0; TriangleIndex < ProjectedTriangles.Num(); TriangleIndex++) {
+		const int32* Corners = &CornerElements[TriangleIndex * 3];
+		UVs->SetTriangle(ProjectedTriangles[TriangleIndex], FIndex3i(
+			ElementIDs[ElementOrder[Corners[0]]],
+			ElementIDs[ElementOrder[Corners[1]]],
+			ElementIDs[ElementOrder[Corners[2]]]));
+	}
+}
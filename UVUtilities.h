@@ -4,11 +4,40 @@
 
 #include "CoreMinimal.h"
 #include "BuildingEnums.h"
+#include "BuildingRandom.h"
+#include "UDynamicMesh.h"
+#include "DynamicMesh/DynamicMesh3.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "UVUtilities.generated.h"
 
+// Box projected uvs for the triangles of one material id
+USTRUCT(BlueprintType)
+struct PROCEDURALBUILDINGS_API FUVBoxProjection
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Material ID", ToolTip = "Triangles with this material id are projected"))
+	int32 MaterialID = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (DisplayName = "Transform", ToolTip = "Location and rotation of the projection box, the scale is the size of the box (see GetMeshUVTransform)"))
+	FTransform Transform = FTransform();
+};
+
 /**
- * 
+ * UV helpers for the building pipeline.
+ *
+ * SetMeshUVsFromBoxProjections projects any number of material ids in a single pass: triangles pick a face of their
+ * projection box, the uv corners are gathered into structure of arrays buffers sorted by (projection, face) and each 
+ * run is projected with a constant affine map in a loop the compiler can vectorize. The uvs are the ones the engine's
+ * SetMeshUVsFromBoxProjection gives (ProceduralBuildings.UVs.BatchedMatchesEngine checks it), except that islands
+ * smaller than its MinIslandTriCount aren't merged into a neighbouring face: a lone triangle keeps the face its normal
+ * points at. The building's faces are quads, so none of its islands are that small.
+ *
+ * HOWTO:
+ *	FUVBoxProjection Sides;
+ *	Sides.MaterialID = SidesMatId;
+ *	Sides.Transform = UUVUtilities::GetMeshUVTransform(Bounds, ScaleMode, OriginMode, Random, UVSize);
+ *	UUVUtilities::SetMeshUVsFromBoxProjections(Mesh, { Sides, Roof });
  */
 UCLASS(meta = (ScriptName = "BUildingScript_UVs"))
 class PROCEDURALBUILDINGS_API UUVUtilities : public UBlueprintFunctionLibrary
@@ -19,5 +48,15 @@ public:
 
 	//UFUNCTION(BlueprintCallable, Category = "ProceduralBuilding|UVs", meta = (ScriptMethod))
 	// TODO make a blueprint version of this function
-	static FTransform GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMode ScaleMode, EBuildingUVOriginMode OriginMode, FRandomStream* Randomizer, float UVSize);
+	// `Random` is only used by EBuildingUVOriginMode::Random, channels 0-2 of it pick the origin within the bounds.
+	static FTransform GetMeshUVTransform(FBox& MeshBounds, EBuildingUVScaleMode ScaleMode, EBuildingUVOriginMode OriginMode, const FBuildingRandom& Random, float UVSize);
+
+	// Box project uv channel 0 of the triangles of each material id with its transform, in one pass over the mesh.
+	// Triangles with a material id that isn't listed keep their uvs.
+	static void SetMeshUVsFromBoxProjections(UDynamicMesh* Mesh, const TArray<FUVBoxProjection>& Projections);
+	static void SetMeshUVsFromBoxProjections(UE::Geometry::FDynamicMesh3& Mesh, const TArray<FUVBoxProjection>& Projections);
+
+	// The projection kernel. `TriangleSlots[TriangleID]` is the index of the triangle's transform in `SlotTransforms`, 
+	// or INDEX_NONE to leave the triangle alone.
+	static void ProjectBoxUVs(UE::Geometry::FDynamicMesh3& Mesh, const TArray<int32>& TriangleSlots, const TArray<FTransform>& SlotTransforms);
 };